@@ -66,6 +66,8 @@ namespace DocCol {
 static constexpr const char *DocumentId   = "document_id";
 static constexpr const char *DisplayName  = "_display_name";
 static constexpr const char *MimeType     = "mime_type";
+static constexpr const char *Size         = "_size";
+static constexpr const char *LastModified = "last_modified";
 static constexpr const char *DirMimeType  = "vnd.android.document/directory";
 }
 
@@ -178,6 +180,16 @@ void AndroidFolder::invalidateCache()
 // ── fileNames ──────────────────────────────────────────────────
 
 QStringList AndroidFolder::fileNames() const
+{
+    QStringList result;
+    for (const Entry &entry : entries())
+        result << entry.name;
+    return result;
+}
+
+// ── entries ────────────────────────────────────────────────────
+
+QList<AndroidFolder::Entry> AndroidFolder::entries() const
 {
 #ifdef Q_OS_ANDROID
     if (!isReady())
@@ -200,15 +212,20 @@ QStringList AndroidFolder::fileNames() const
         "(Landroid/net/Uri;Ljava/lang/String;)Landroid/net/Uri;",
         treeUriObj.object(), rootDocId.object());
 
-    // Projection: [_display_name, mime_type, document_id]
+    // Projection: [_display_name, mime_type, document_id, _size, last_modified]
+    // サイズと更新日時も同じクエリで取る（ファイルごとの追加クエリは不要）
     jclass strCls = env->FindClass("java/lang/String");
-    jobjectArray proj = env->NewObjectArray(3, strCls, nullptr);
+    jobjectArray proj = env->NewObjectArray(5, strCls, nullptr);
     env->SetObjectArrayElement(
         proj, 0, QJniObject::fromString(QLatin1String(DocCol::DisplayName)).object());
     env->SetObjectArrayElement(
         proj, 1, QJniObject::fromString(QLatin1String(DocCol::MimeType)).object());
     env->SetObjectArrayElement(
         proj, 2, QJniObject::fromString(QLatin1String(DocCol::DocumentId)).object());
+    env->SetObjectArrayElement(
+        proj, 3, QJniObject::fromString(QLatin1String(DocCol::Size)).object());
+    env->SetObjectArrayElement(
+        proj, 4, QJniObject::fromString(QLatin1String(DocCol::LastModified)).object());
 
     QJniObject cursor = contentResolver().callObjectMethod(
         "query",
@@ -222,7 +239,7 @@ QStringList AndroidFolder::fileNames() const
     env->DeleteLocalRef(proj);
     env->DeleteLocalRef(strCls);
 
-    QStringList result;
+    QList<Entry> result;
     if (cursor.isValid()) {
         m_docIdCache.clear();   // ← クエリのたびにキャッシュ更新
         while (cursor.callMethod<jboolean>("moveToNext")) {
@@ -233,21 +250,30 @@ QStringList AndroidFolder::fileNames() const
             // ディレクトリは除外（フラットフォルダの仕様）
             if (mime != QLatin1String(DocCol::DirMimeType)) {
                 // col 0 = _display_name, col 2 = document_id
-                const QString name = cursor.callObjectMethod(
+                Entry entry;
+                entry.name = cursor.callObjectMethod(
                     "getString", "(I)Ljava/lang/String;",
                     static_cast<jint>(0)).toString();
                 const QString docId = cursor.callObjectMethod(
                     "getString", "(I)Ljava/lang/String;",
                     static_cast<jint>(2)).toString();
-                result << name;
-                m_docIdCache.insert(name, docId);   // ← キャッシュに追加
-                qDebug() << "[AndroidFolder::fileNames]" << name << "->" << docId;
+
+                // col 3 = _size, col 4 = last_modified（プロバイダによっては NULL）
+                if (!cursor.callMethod<jboolean>("isNull", "(I)Z", static_cast<jint>(3)))
+                    entry.size = cursor.callMethod<jlong>("getLong", "(I)J", static_cast<jint>(3));
+                if (!cursor.callMethod<jboolean>("isNull", "(I)Z", static_cast<jint>(4)))
+                    entry.lastModified = cursor.callMethod<jlong>("getLong", "(I)J", static_cast<jint>(4));
+
+                m_docIdCache.insert(entry.name, docId);   // ← キャッシュに追加
+                qDebug() << "[AndroidFolder::entries]" << entry.name << "->" << docId
+                         << entry.size << entry.lastModified;
+                result << entry;
             }
         }
         cursor.callMethod<void>("close");
     }
-    qDebug() << "[AndroidFolder::fileNames] treeUri:" << m_treeUri;
-    qDebug() << "[AndroidFolder::fileNames] total files:" << result.size();
+    qDebug() << "[AndroidFolder::entries] treeUri:" << m_treeUri;
+    qDebug() << "[AndroidFolder::entries] total files:" << result.size();
     return result;
 
 #else
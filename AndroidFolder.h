@@ -26,6 +26,13 @@ class AndroidFolder : public QObject
     Q_OBJECT
 
 public:
+    /// fileNames() 1回のクエリで取得するファイル情報。
+    struct Entry {
+        QString name;
+        qint64  size = -1;          ///< _size（不明なら -1）
+        qint64  lastModified = -1;  ///< last_modified（エポックからのミリ秒、不明なら -1）
+    };
+
     explicit AndroidFolder(QObject *parent = nullptr);
     ~AndroidFolder() override;
 
@@ -53,6 +60,10 @@ public:
     /// isReady()==false なら空リストを返す。
     QStringList fileNames() const;
 
+    /// fileNames() と同じクエリで _size と last_modified も取得する。
+    /// 同期（ミラー）で変更の有無を判定するのに使う。
+    QList<Entry> entries() const;
+
     /// ファイルを読み込む（ファイル名で指定）。
     /// 失敗時は空の QByteArray を返す。
     QByteArray read(const QString &fileName) const;
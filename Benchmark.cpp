@@ -0,0 +1,1066 @@
+#include "Benchmark.h"
+
+#include "ContactSheet.h"
+#include "ContentHash.h"
+#include "FolderCompare.h"
+#include "GalleryLoader.h"
+#include "GalleryTheme.h"
+#include "IconTint.h"
+#include "MirrorSync.h"
+#include "PixmapCache.h"
+#include "PngBuild.h"
+#include "SessionSnapshot.h"
+#include "SvgDisplayList.h"
+#include "SvgLint.h"
+#include "SvgIconEngine.h"
+#include "SvgInspector.h"
+#include "SvgMetadata.h"
+#include "SvgPair.h"
+#include "SvgPathParser.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QLocale>
+#include <QMap>
+#include <QPainter>
+#include <QScrollArea>
+#include <QSvgRenderer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVBoxLayout>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+// Reads every *.svg in a folder, reporting an error if there are none
+QList<QByteArray> readSvgs(const QString &directory)
+{
+    QDir dir(directory);
+    QList<QByteArray> result;
+    for (const QString &fileName : dir.entryList(QStringList("*.svg"), QDir::Files, QDir::Name)) {
+        QFile file(dir.absoluteFilePath(fileName));
+        if (file.open(QIODevice::ReadOnly))
+            result.append(file.readAll());
+    }
+    if (result.isEmpty())
+        out() << "No SVG files found in: " << directory << Qt::endl;
+    return result;
+}
+
+double ms(qint64 nsecs)
+{
+    return nsecs / 1e6;
+}
+
+// Resident set size in bytes, or -1 where /proc is not available
+qint64 residentBytes()
+{
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+#ifdef Q_OS_UNIX
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+// A distinct small icon per index, so nothing is shared between items
+QByteArray syntheticSvg(int index)
+{
+    return QString("<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 24 24\">"
+                   "<rect x=\"2\" y=\"2\" width=\"20\" height=\"20\" rx=\"%1\" fill=\"#%2\"/>"
+                   "<circle cx=\"12\" cy=\"12\" r=\"%3\" fill=\"#fff\"/></svg>")
+        .arg(index % 10)
+        .arg(QString::number(0x204060 + index * 97 % 0xbfbfbf, 16).rightJustified(6, QLatin1Char('0')))
+        .arg(2 + index % 8)
+        .toUtf8();
+}
+
+QString syntheticName(int index)
+{
+    return QString("icon%1.svg").arg(index, 5, 10, QLatin1Char('0'));
+}
+
+} // namespace
+
+namespace Benchmark {
+
+int displayList(const QString &directory, int iconSize)
+{
+    const QList<QByteArray> svgs = readSvgs(directory);
+    if (svgs.isEmpty())
+        return 1;
+
+    constexpr int kRounds = 10;
+    const QSize size(iconSize, iconSize);
+    QElapsedTimer timer;
+
+    // Compile (and write to the cache) once per icon
+    QList<SvgDisplayList> lists;
+    qint64 svgBytes = 0, listBytes = 0, lossy = 0;
+    timer.start();
+    for (const QByteArray &svg : svgs) {
+        lists.append(SvgDisplayList::cached(svg));
+        svgBytes += svg.size();
+        listBytes += lists.last().byteSize();
+        lossy += lists.last().isLossy() ? 1 : 0;
+    }
+    const qint64 compileNs = timer.nsecsElapsed();
+
+    // Warm start: map every list from the cache
+    timer.start();
+    for (const QByteArray &svg : svgs)
+        SvgDisplayList::cached(svg);
+    const qint64 loadNs = timer.nsecsElapsed();
+
+    timer.start();
+    for (int round = 0; round < kRounds; ++round) {
+        for (const QByteArray &svg : svgs) {
+            SvgIconEngine engine(svg);
+            engine.pixmap(size, QIcon::Normal, QIcon::Off);
+        }
+    }
+    const qint64 engineNs = timer.nsecsElapsed();
+
+    timer.start();
+    for (int round = 0; round < kRounds; ++round) {
+        for (const SvgDisplayList &list : lists) {
+            DisplayListIconEngine engine(list);
+            engine.pixmap(size, QIcon::Normal, QIcon::Off);
+        }
+    }
+    const qint64 replayNs = timer.nsecsElapsed();
+
+    const qint64 renders = qint64(kRounds) * svgs.size();
+    out() << "Icons:              " << svgs.size() << " at " << iconSize << " px, "
+          << kRounds << " rounds" << Qt::endl
+          << "SVG bytes:          " << svgBytes << Qt::endl
+          << "Display list bytes: " << listBytes << " (" << lossy << " lossy)" << Qt::endl
+          << "Compile (cold):     " << ms(compileNs) << " ms" << Qt::endl
+          << "Load (mapped):      " << ms(loadNs) << " ms" << Qt::endl
+          << "SvgIconEngine:      " << ms(engineNs) << " ms, "
+          << ms(engineNs) * 1000 / renders << " us/icon" << Qt::endl
+          << "Display list:       " << ms(replayNs) << " ms, "
+          << ms(replayNs) * 1000 / renders << " us/icon" << Qt::endl
+          << "Speedup:            " << (replayNs ? double(engineNs) / replayNs : 0.0) << "x" << Qt::endl;
+    return 0;
+}
+
+int themeSwitch()
+{
+    const QList<QColor> presets = {
+        QColor(236, 236, 236), QColor(110, 110, 110), QColor(90, 90, 90), QColor(40, 40, 40),
+    };
+    const QList<RenderBackend*> backends = {RenderBackendRegistry::instance().backends().first()};
+
+    // In-memory fixture, shared by every item
+    const SvgDocumentPtr document = SvgDocumentPtr::create(QStringLiteral("fixture.svg"), QByteArray(
+        "<svg xmlns='http://www.w3.org/2000/svg' viewBox='0 0 16 16'>"
+        "<circle cx='8' cy='8' r='6' fill='#3daee9'/></svg>"));
+
+    for (int count : {1000, 10000}) {
+        QScrollArea scrollArea;
+        scrollArea.setWidgetResizable(true);
+        QWidget *gallery = new QWidget;
+        QVBoxLayout *layout = new QVBoxLayout(gallery);
+        for (int i = 0; i < count; ++i)
+            layout->addWidget(new SvgPair(document, {}, 32, backends, {0}, gallery));
+        scrollArea.setWidget(gallery);
+        scrollArea.resize(900, 700);
+        scrollArea.show();
+        QApplication::processEvents();
+
+        GalleryTheme theme;
+        qint64 applyNs = 0, totalNs = 0;
+        QElapsedTimer timer;
+        for (int round = 0; round < 4; ++round) {
+            for (const QColor &color : presets) {
+                timer.start();
+                theme.setBackground(color);
+                theme.apply(gallery);
+                applyNs += timer.nsecsElapsed();
+                QApplication::processEvents(); // Includes the repaint
+                totalNs += timer.nsecsElapsed();
+            }
+        }
+        const int switches = 4 * presets.size();
+        out() << count << " items: " << ms(applyNs) / switches << " ms/switch palette, "
+              << ms(totalNs) / switches << " ms/switch incl. repaint" << Qt::endl;
+    }
+    return 0;
+}
+
+int resizeMemory(const QString &directory)
+{
+    QDir dir(directory);
+    const QStringList svgFiles = dir.entryList(QStringList("*.svg"), QDir::Files, QDir::Name);
+    if (svgFiles.isEmpty()) {
+        out() << "No SVG files found in: " << directory << Qt::endl;
+        return 1;
+    }
+
+    const QStringList allPngFiles = dir.entryList(QStringList("*.png"), QDir::Files, QDir::Name);
+    const QList<RenderBackend*> backends = RenderBackendRegistry::instance().backends();
+    QWidget gallery;
+    QVBoxLayout *layout = new QVBoxLayout(&gallery);
+    QList<SvgPair*> pairs;
+    for (const QString &svgFile : svgFiles) {
+        QStringList matchingPngs;
+        for (const QString &pngFile : GalleryLoader::matchingPngs(svgFile, allPngFiles))
+            matchingPngs.append(dir.absoluteFilePath(pngFile));
+        pairs.append(new SvgPair(dir.absoluteFilePath(svgFile), matchingPngs, 32, backends, {0}, &gallery));
+        layout->addWidget(pairs.last());
+    }
+
+    // Slider sweeps 16 -> 128 -> 16, painting every step
+    constexpr int kChanges = 1000;
+    constexpr int kMinSize = 16;
+    constexpr int kMaxSize = 128;
+    QImage canvas(1, 1, QImage::Format_ARGB32_Premultiplied);
+    qint64 afterFirstSweep = -1;
+    int size = kMinSize, step = 1;
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 before = residentBytes();
+    for (int change = 0; change < kChanges; ++change) {
+        size += step;
+        if (size == kMaxSize || size == kMinSize)
+            step = -step;
+        for (SvgPair *pair : pairs) {
+            pair->setIconSize(size);
+            pair->adjustSize();
+            if (canvas.size() != pair->size())
+                canvas = QImage(pair->size(), QImage::Format_ARGB32_Premultiplied);
+            pair->render(&canvas);
+        }
+        if (change == 2 * (kMaxSize - kMinSize) - 1)
+            afterFirstSweep = residentBytes();
+    }
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    const qint64 after = residentBytes();
+
+    out() << "Items:              " << pairs.size() << ", " << kChanges << " size changes" << Qt::endl
+          << "Time:               " << ms(elapsedNs) / kChanges << " ms/change" << Qt::endl;
+    if (before < 0 || afterFirstSweep < 0 || after < 0) {
+        out() << "Resident memory:    not available on this platform" << Qt::endl;
+        return 0;
+    }
+
+    // Once every size has been visited nothing new should be kept
+    constexpr qint64 kTolerance = 1024 * 1024;
+    const qint64 growth = after - afterFirstSweep;
+    out() << "Resident at start:  " << before / 1024 << " KiB" << Qt::endl
+          << "After first sweep:  " << afterFirstSweep / 1024 << " KiB" << Qt::endl
+          << "After all changes:  " << after / 1024 << " KiB" << Qt::endl
+          << "Growth after sweep: " << growth / 1024 << " KiB "
+          << (growth <= kTolerance ? "(constant)" : "(GROWING)") << Qt::endl;
+
+    // Every raster goes through the one budget
+    const PixmapCache::Stats cache = PixmapCache::instance().stats();
+    const bool withinBudget = cache.bytes <= cache.budget;
+    out() << cache.summary() << (withinBudget ? "" : "  <-- OVER BUDGET") << Qt::endl;
+    return growth <= kTolerance && withinBudget ? 0 : 1;
+}
+
+int pixelRatios(const QString &directory, int iconSize)
+{
+    const QList<QByteArray> svgs = readSvgs(directory);
+    if (svgs.isEmpty())
+        return 1;
+
+    QList<SvgDocumentPtr> documents;
+    for (const QByteArray &svg : svgs)
+        documents.append(SvgDocumentPtr::create(QString(), svg));
+
+    const QSize size(iconSize, iconSize);
+    const QList<qreal> ratios = {1.0, 1.25, 1.5, 2.0};
+    QElapsedTimer timer;
+    int wrongSize = 0;
+
+    out() << "Icons: " << svgs.size() << " at " << iconSize << " px" << Qt::endl;
+    for (RenderBackend *backend : RenderBackendRegistry::instance().backends()) {
+        out() << backend->name() << ":" << Qt::endl;
+        for (qreal ratio : ratios) {
+            const QSize expected = size * ratio;
+            timer.start();
+            for (const SvgDocumentPtr &document : documents) {
+                const QPixmap p = backend->render(*document, size, ratio);
+                if (!p.isNull() && p.size() != expected)
+                    ++wrongSize;
+            }
+            const qint64 elapsedNs = timer.nsecsElapsed();
+            out() << "  " << ratio << "x (" << expected.width() << " px): "
+                  << ms(elapsedNs) * 1000 / documents.size() << " us/icon" << Qt::endl;
+        }
+    }
+
+    if (wrongSize)
+        out() << wrongSize << " render(s) not at size × ratio pixels" << Qt::endl;
+    return wrongSize ? 1 : 0;
+}
+
+int loader(const QString &directory, int latencyMs, int iconSize)
+{
+    const FolderSourcePtr local = QSharedPointer<LocalFolderSource>::create(directory);
+    if (!local->isReady()) {
+        out() << "Directory does not exist: " << directory << Qt::endl;
+        return 1;
+    }
+
+    SimulatedFolderSource::Latency latency;
+    latency.listMs = 10 * latencyMs;
+    latency.readMs = latencyMs;
+    const FolderSourcePtr slow = QSharedPointer<SimulatedFolderSource>::create(local, latency);
+
+    // Stand-in for creating a gallery item: parse and render the SVG once
+    RenderBackend *backend = RenderBackendRegistry::instance().backend(QStringLiteral("custom"));
+    const QSize size(iconSize, iconSize);
+    auto consume = [&](const QByteArray &svg) {
+        SvgDocument document(QString(), svg);
+        backend->render(document, size);
+    };
+
+    // Old loader: list, then read and build one file at a time on one thread
+    QElapsedTimer timer;
+    timer.start();
+    int items = 0;
+    qint64 firstNs = 0;
+    QStringList pngFiles;
+    QStringList svgFiles;
+    for (const FolderEntry &entry : slow->list()) {
+        if (entry.name.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive))
+            svgFiles.append(entry.name);
+        else if (entry.name.endsWith(QLatin1String(".png"), Qt::CaseInsensitive))
+            pngFiles.append(entry.name);
+    }
+    svgFiles.sort();
+    for (const QString &svgFile : svgFiles) {
+        const QByteArray svg = slow->read(svgFile);
+        for (const QString &pngFile : GalleryLoader::matchingPngs(svgFile, pngFiles))
+            slow->read(pngFile);
+        consume(svg);
+        if (items++ == 0)
+            firstNs = timer.nsecsElapsed();
+    }
+    const qint64 sequentialNs = timer.nsecsElapsed();
+    if (items == 0) {
+        out() << "No SVG files found in: " << directory << Qt::endl;
+        return 1;
+    }
+
+    out() << items << " SVGs, " << latencyMs << " ms simulated latency per file, "
+          << latency.listMs << " ms per listing" << Qt::endl
+          << "Sequential:                first " << ms(firstNs) << " ms, total "
+          << ms(sequentialNs) << " ms" << Qt::endl;
+
+    // GalleryLoader: reads run ahead on the I/O pool while items are built
+    for (int readers : {1, 4}) {
+        FolderSource::setMaxParallelReads(readers);
+        for (int batchSize : {1, 8, 32}) {
+            // Storage that serves as many reads at once as the pool issues
+            latency.maxConcurrent = readers;
+            const FolderSourcePtr source = QSharedPointer<SimulatedFolderSource>::create(local, latency);
+
+            GalleryLoader loader;
+            QEventLoop loop;
+            QObject::connect(&loader, &GalleryLoader::itemLoaded, [&](int, const GalleryLoader::Item &item) {
+                consume(item.svgData);
+            });
+            QObject::connect(&loader, &GalleryLoader::finished, &loop, &QEventLoop::quit);
+            loader.start(source, batchSize);
+            loop.exec();
+
+            const GalleryLoader::Stats &stats = loader.stats();
+            out() << "Async, " << readers << " reader(s), batch " << QString::number(batchSize).leftJustified(2)
+                  << ": first " << ms(stats.firstItemNs) << " ms, total " << ms(stats.totalNs) << " ms ("
+                  << (stats.totalNs ? double(sequentialNs) / stats.totalNs : 0.0) << "x)" << Qt::endl;
+        }
+    }
+    FolderSource::setMaxParallelReads(4);
+
+    // Same files as in-memory fixtures: the loader's own overhead
+    QHash<QString, QByteArray> files;
+    for (const FolderEntry &entry : local->list())
+        files.insert(entry.name, local->read(entry.name));
+    GalleryLoader loader;
+    QEventLoop loop;
+    QObject::connect(&loader, &GalleryLoader::itemLoaded, [&](int, const GalleryLoader::Item &item) {
+        consume(item.svgData);
+    });
+    QObject::connect(&loader, &GalleryLoader::finished, &loop, &QEventLoop::quit);
+    loader.start(QSharedPointer<MemoryFolderSource>::create(directory, files));
+    loop.exec();
+    out() << "Async, in memory:          first " << ms(loader.stats().firstItemNs) << " ms, total "
+          << ms(loader.stats().totalNs) << " ms" << Qt::endl;
+    return 0;
+}
+
+int mirrorSync(int latencyMs)
+{
+    // Fake SAF tree of 200 icons behind simulated latency, mirrored in memory
+    QHash<QString, QByteArray> files;
+    for (int i = 0; i < 200; ++i) {
+        files.insert(QString("icon%1.svg").arg(i, 3, 10, QLatin1Char('0')),
+                     QString("<svg xmlns=\"http://www.w3.org/2000/svg\" viewBox=\"0 0 24 24\">"
+                             "<circle cx=\"12\" cy=\"12\" r=\"%1\"/></svg>").arg(1 + i % 11).toUtf8());
+    }
+    const auto remote = QSharedPointer<MemoryFolderSource>::create(QStringLiteral("remote"), files);
+    const auto mirror = QSharedPointer<MemoryFolderSource>::create(QStringLiteral("mirror"), QHash<QString, QByteArray>());
+
+    SimulatedFolderSource::Latency latency;
+    latency.listMs = 10 * latencyMs;
+    latency.readMs = latencyMs;
+    MirrorSync sync(QSharedPointer<SimulatedFolderSource>::create(remote, latency), mirror);
+
+    int failures = 0;
+    auto check = [&](const char *step, const MirrorSync::Result &result, qint64 nsecs,
+                     int added, int updated, int removed, int unchanged) {
+        const bool ok = result.ok && result.failed == 0 && result.added == added && result.updated == updated
+                        && result.removed == removed && result.unchanged == unchanged;
+        out() << QString(step).leftJustified(10) << ms(nsecs) << " ms: " << result.summary()
+              << (ok ? "" : "  <-- MISMATCH") << Qt::endl;
+        if (!ok)
+            ++failures;
+    };
+
+    QElapsedTimer timer;
+    out() << files.size() << " files, " << latencyMs << " ms simulated latency per file" << Qt::endl;
+
+    timer.start();
+    check("Cold", sync.sync(), timer.nsecsElapsed(), files.size(), 0, 0, 0);
+
+    timer.start();
+    MirrorSync::Result warm = sync.sync();
+    check("Warm", warm, timer.nsecsElapsed(), 0, 0, 0, files.size());
+    if (warm.bytesTransferred != 0)
+        ++failures;
+
+    // Three edits, two new files, one deletion
+    for (int i = 0; i < 3; ++i)
+        remote->write(QString("icon%1.svg").arg(i, 3, 10, QLatin1Char('0')), "<svg xmlns=\"http://www.w3.org/2000/svg\"/>");
+    remote->write(QStringLiteral("new1.svg"), "<svg xmlns=\"http://www.w3.org/2000/svg\"/>");
+    remote->write(QStringLiteral("new2.svg"), "<svg xmlns=\"http://www.w3.org/2000/svg\"/>");
+    remote->remove(QStringLiteral("icon199.svg"));
+    timer.start();
+    check("Changed", sync.sync(), timer.nsecsElapsed(), 2, 3, 1, files.size() - 4);
+
+    // The mirror must now hold exactly what the remote holds
+    for (const FolderEntry &entry : remote->list()) {
+        if (mirror->read(entry.name) != remote->read(entry.name)) {
+            out() << "Mirror differs from remote: " << entry.name << Qt::endl;
+            ++failures;
+        }
+    }
+    if (mirror->read(QStringLiteral("icon199.svg")).size() > 0) {
+        out() << "Deleted file still mirrored" << Qt::endl;
+        ++failures;
+    }
+
+    // A fresh sync object over the same mirror picks up the saved manifest
+    MirrorSync restarted(remote, mirror);
+    timer.start();
+    check("Restarted", restarted.sync(), timer.nsecsElapsed(), 0, 0, 0, files.size() + 1);
+
+    out() << (failures ? "FAILED" : "OK") << Qt::endl;
+    return failures ? 1 : 0;
+}
+
+int contactSheet(int count, int iconSize)
+{
+    // Distinct synthetic icons, so nothing is shared between cells
+    QList<SvgDocumentPtr> documents;
+    for (int i = 0; i < count; ++i)
+        documents.append(SvgDocumentPtr::create(syntheticName(i), syntheticSvg(i)));
+
+    ContactSheet::Options options;
+    options.sections.append({iconSize, QColor(90, 90, 90), QStringLiteral("Benchmark")});
+    ContactSheet sheet(documents, options);
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath(QStringLiteral("sheet.png"));
+    const qint64 before = residentBytes();
+    qint64 peak = before;
+    QElapsedTimer timer;
+    timer.start();
+    const bool ok = sheet.writePng(path, [&peak](int, int) {
+        peak = qMax(peak, residentBytes());
+        return true;
+    });
+    const qint64 elapsedNs = timer.nsecsElapsed();
+    if (!ok) {
+        out() << "Export failed: " << sheet.errorString() << Qt::endl;
+        return 1;
+    }
+
+    const QSize size = sheet.pngSize();
+    const qint64 sheetBytes = qint64(size.width()) * size.height() * 4;
+    out() << count << " icons at " << iconSize << " px: " << size.width() << "x" << size.height() << " px, "
+          << sheet.bandCount() << " bands" << Qt::endl
+          << "Time:             " << ms(elapsedNs) << " ms" << Qt::endl
+          << "File size:        " << QFileInfo(path).size() / 1024 << " KiB" << Qt::endl
+          << "Whole image:      " << sheetBytes / 1024 << " KiB if materialized" << Qt::endl;
+
+    // Verify the stream decodes; QImage reads the whole sheet back, so only for small ones
+    if (sheetBytes <= 256 * 1024 * 1024) {
+        const QImage decoded(path);
+        if (decoded.size() != size) {
+            out() << "Written PNG does not decode to " << size.width() << "x" << size.height() << Qt::endl;
+            return 1;
+        }
+    }
+
+    if (before < 0) {
+        out() << "Resident memory:  not available on this platform" << Qt::endl;
+        return 0;
+    }
+    const qint64 growth = peak - before;
+    out() << "Peak growth:      " << growth / 1024 << " KiB" << Qt::endl;
+    return growth < sheetBytes / 2 ? 0 : 1;
+}
+
+int sessionRestore(int count, int iconSize)
+{
+    SessionSnapshot::Session session;
+    session.folder = QStringLiteral("/benchmark");
+    session.iconSize = iconSize;
+    session.background = QColor(90, 90, 90);
+    const qint64 modified = QDateTime::currentMSecsSinceEpoch();
+    for (int i = 0; i < count; ++i) {
+        SessionSnapshot::Item item;
+        item.name = syntheticName(i);
+        item.data = syntheticSvg(i);
+        item.contentHash = contentHash(item.data);
+        item.size = item.data.size();
+        item.lastModified = modified;
+        session.items.append(item);
+    }
+
+    QTemporaryDir dir;
+    const QString path = dir.filePath(QStringLiteral("session.snapshot"));
+    QElapsedTimer timer;
+    timer.start();
+    if (!SessionSnapshot::save(path, session)) {
+        out() << "Failed to save " << path << Qt::endl;
+        return 1;
+    }
+    const qint64 saveNs = timer.nsecsElapsed();
+
+    // What SvgGallery::restoreSession() does: map, then items straight from the mapping
+    timer.start();
+    const SessionSnapshot snapshot = SessionSnapshot::load(path);
+    const qint64 loadNs = timer.nsecsElapsed();
+    if (!snapshot.isValid() || snapshot.session().items.size() != count) {
+        out() << "Snapshot does not load back" << Qt::endl;
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        const SessionSnapshot::Item &item = snapshot.session().items[i];
+        if (item.name != session.items[i].name || item.data != session.items[i].data
+            || item.contentHash != session.items[i].contentHash || item.lastModified != modified) {
+            out() << "Item " << i << " does not round-trip" << Qt::endl;
+            return 1;
+        }
+    }
+
+    const QList<RenderBackend*> backends = {RenderBackendRegistry::instance().backends().first()};
+    QScrollArea scrollArea;
+    scrollArea.setWidgetResizable(true);
+    QWidget *gallery = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(gallery);
+    timer.start();
+    for (const SessionSnapshot::Item &item : snapshot.session().items) {
+        SvgDocumentPtr document = SvgDocumentPtr::create(item.name, item.data, item.contentHash);
+        layout->addWidget(new SvgPair(document, {}, iconSize, backends, {0}, gallery));
+    }
+    const qint64 buildNs = timer.nsecsElapsed();
+    scrollArea.setWidget(gallery);
+    scrollArea.resize(900, 700);
+    scrollArea.show();
+    QApplication::processEvents(); // Layout and the first paint
+    const qint64 shownNs = timer.nsecsElapsed();
+
+    out() << count << " items, " << QFileInfo(path).size() / 1024 << " KiB snapshot" << Qt::endl
+          << "Save:             " << ms(saveNs) << " ms" << Qt::endl
+          << "Map and decode:   " << ms(loadNs) << " ms" << Qt::endl
+          << "Create items:     " << ms(buildNs) << " ms" << Qt::endl
+          << "Usable gallery:   " << ms(loadNs + shownNs) << " ms (map, items, first paint)" << Qt::endl;
+    return 0;
+}
+
+int metadata(int count)
+{
+    QList<QByteArray> data;
+    qint64 bytes = 0;
+    for (int i = 0; i < count; ++i) {
+        data.append(syntheticSvg(i));
+        bytes += data.last().size();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<SvgMetadata> sequential;
+    sequential.reserve(count);
+    for (const QByteArray &svg : std::as_const(data))
+        sequential.append(SvgMetadata::extract(svg));
+    const qint64 sequentialNs = timer.nsecsElapsed();
+
+    timer.start();
+    const QList<SvgMetadata> parallel = SvgMetadata::extractAsync(data).results();
+    const qint64 parallelNs = timer.nsecsElapsed();
+
+    for (int i = 0; i < count; ++i) {
+        if (!parallel[i].isValid() || parallel[i].complexity() != sequential[i].complexity()) {
+            out() << "Item " << i << " differs between sequential and parallel extraction" << Qt::endl;
+            return 1;
+        }
+    }
+
+    // Same flat key array and stable sort as SvgGallery::arrangeGallery()
+    struct Entry {
+        int group;
+        float key;
+        int index;
+    };
+    QList<Entry> entries;
+    entries.reserve(count);
+    timer.start();
+    for (int i = 0; i < count; ++i)
+        entries.append({parallel[i].complexity() < 16 ? 0 : 1, -float(parallel[i].complexity()), i});
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.group != b.group ? a.group < b.group : a.key < b.key;
+    });
+    const qint64 sortNs = timer.nsecsElapsed();
+
+    const double megabytes = bytes / (1024.0 * 1024.0);
+    out() << count << " SVGs, " << bytes / 1024 << " KiB, " << sizeof(SvgMetadata) << " bytes of metadata each" << Qt::endl
+          << "Sequential:       " << ms(sequentialNs) << " ms, " << megabytes / (sequentialNs / 1e9) << " MB/s" << Qt::endl
+          << "Thread pool:      " << ms(parallelNs) << " ms, " << megabytes / (parallelNs / 1e9) << " MB/s, "
+          << QThreadPool::globalInstance()->maxThreadCount() << " threads" << Qt::endl
+          << "Sort and group:   " << ms(sortNs) << " ms" << Qt::endl;
+    return 0;
+}
+
+int pathParser(const QString &directory)
+{
+    const QList<QByteArray> svgs = readSvgs(directory);
+    if (svgs.isEmpty())
+        return 1;
+
+    // The d attributes as UTF-8, the way they sit in the files
+    QList<QByteArray> paths;
+    qint64 svgBytes = 0, pathBytes = 0;
+    for (const QByteArray &svg : svgs) {
+        svgBytes += svg.size();
+        QXmlStreamReader xml(svg);
+        while (!xml.atEnd()) {
+            if (xml.readNext() == QXmlStreamReader::StartElement && xml.name() == QLatin1String("path")) {
+                paths.append(xml.attributes().value(QLatin1String("d")).toUtf8());
+                pathBytes += paths.last().size();
+            }
+        }
+    }
+    if (paths.isEmpty()) {
+        out() << "No path data in: " << directory << Qt::endl;
+        return 1;
+    }
+
+    // Best of a few rounds, so one cold cache does not decide
+    constexpr int kRounds = 5;
+    QElapsedTimer timer;
+    auto timeParser = [&](SvgPathParser::Mode mode, SvgPathParser::Stats *stats) {
+        qint64 best = std::numeric_limits<qint64>::max();
+        for (int round = 0; round < kRounds; ++round) {
+            SvgPathParser parser(SvgPathParser::Grid(), mode);
+            timer.start();
+            for (const QByteArray &d : std::as_const(paths))
+                parser.parsePath(QByteArrayView(d));
+            best = qMin(best, timer.nsecsElapsed());
+            *stats = parser.stats();
+        }
+        return best;
+    };
+    SvgPathParser::Stats scalar, simd;
+    const qint64 scalarNs = timeParser(SvgPathParser::Scalar, &scalar);
+    const qint64 simdNs = timeParser(SvgPathParser::Auto, &simd);
+    if (scalar.numbers != simd.numbers || scalar.segments != simd.segments || scalar.bounds() != simd.bounds()) {
+        out() << "SIMD and scalar parsing disagree" << Qt::endl;
+        return 1;
+    }
+
+    qint64 rendererNs = std::numeric_limits<qint64>::max();
+    for (int round = 0; round < kRounds; ++round) {
+        timer.start();
+        for (const QByteArray &svg : svgs)
+            QSvgRenderer renderer(svg);
+        rendererNs = qMin(rendererNs, timer.nsecsElapsed());
+    }
+
+    auto throughput = [](qint64 bytes, qint64 nsecs) {
+        return nsecs > 0 ? bytes / (1024.0 * 1024.0) / (nsecs / 1e9) : 0.0;
+    };
+    out() << svgs.size() << " SVGs, " << svgBytes / 1024 << " KiB, of which " << paths.size() << " paths, "
+          << pathBytes / 1024 << " KiB path data" << Qt::endl
+          << "Segments:         " << simd.segments << " (" << simd.curves << " curves), "
+          << simd.numbers << " numbers, up to " << simd.maxDecimals << " decimals"
+          << (simd.error ? ", some invalid" : "") << Qt::endl
+          << "Path parser:      " << throughput(pathBytes, scalarNs) << " MB/s scalar, "
+          << throughput(pathBytes, simdNs) << " MB/s "
+          << (SvgPathParser::simdAvailable() ? "SSE2" : "without SIMD on this target") << Qt::endl
+          << "QSvgRenderer:     " << throughput(svgBytes, rendererNs) << " MB/s of whole files ("
+          << ms(rendererNs) << " ms to load all)" << Qt::endl;
+    return 0;
+}
+
+int lint(const QString &directory)
+{
+    const QList<QByteArray> svgs = readSvgs(directory);
+    if (svgs.isEmpty())
+        return 1;
+    qint64 bytes = 0;
+    for (const QByteArray &svg : svgs)
+        bytes += svg.size();
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<SvgLint::Report> sequential;
+    sequential.reserve(svgs.size());
+    for (const QByteArray &svg : svgs)
+        sequential.append(SvgLint::run(svg));
+    const qint64 sequentialNs = timer.nsecsElapsed();
+
+    timer.start();
+    const QList<SvgLint::Report> parallel = SvgLint::runAsync(svgs).results();
+    const qint64 parallelNs = timer.nsecsElapsed();
+
+    QMap<QString, int> perRule;
+    int flagged = 0, severe = 0;
+    for (qsizetype i = 0; i < svgs.size(); ++i) {
+        if (parallel[i].findings.size() != sequential[i].findings.size() || parallel[i].cost != sequential[i].cost) {
+            out() << "File " << i << " differs between sequential and parallel linting" << Qt::endl;
+            return 1;
+        }
+        if (parallel[i].isClean())
+            continue;
+        ++flagged;
+        if (parallel[i].severity() == SvgLint::Severe)
+            ++severe;
+        for (const SvgLint::Finding &finding : parallel[i].findings)
+            ++perRule[SvgLint::ruleName(finding.rule)];
+    }
+
+    const double megabytes = bytes / (1024.0 * 1024.0);
+    out() << svgs.size() << " SVGs, " << bytes / 1024 << " KiB" << Qt::endl
+          << "Sequential:       " << ms(sequentialNs) << " ms, " << megabytes / (sequentialNs / 1e9) << " MB/s" << Qt::endl
+          << "Thread pool:      " << ms(parallelNs) << " ms, " << megabytes / (parallelNs / 1e9) << " MB/s, "
+          << QThreadPool::globalInstance()->maxThreadCount() << " threads" << Qt::endl
+          << "Flagged:          " << flagged << " (" << severe << " severe)" << Qt::endl;
+    for (auto it = perRule.cbegin(); it != perRule.cend(); ++it)
+        out() << "  " << it.key() << ": " << it.value() << Qt::endl;
+    return 0;
+}
+
+int tint(int count, int iconSize)
+{
+    // Generated icons with their light parts in currentColor
+    QList<SvgDocumentPtr> documents;
+    for (int i = 0; i < count; ++i) {
+        QByteArray svg = syntheticSvg(i);
+        svg.replace("#fff", "currentColor");
+        documents.append(SvgDocumentPtr::create(syntheticName(i), svg));
+    }
+    RenderBackend *backend = RenderBackendRegistry::instance().backend(QStringLiteral("custom"));
+    const QSize size(iconSize, iconSize);
+    const QList<QColor> colors = {QColor(61, 174, 233), QColor(218, 68, 83), QColor(39, 174, 96), Qt::white, Qt::black};
+
+    QElapsedTimer timer;
+    timer.start();
+    QList<IconTint::Layers> layers;
+    layers.reserve(count);
+    for (const SvgDocumentPtr &document : std::as_const(documents))
+        layers.append(IconTint::render(backend, *document, size, 1.0, IconTint::CurrentColor));
+    const qint64 layersNs = timer.nsecsElapsed();
+    qint64 maskBytes = 0;
+    for (const IconTint::Layers &layer : std::as_const(layers))
+        maskBytes += layer.base.sizeInBytes() + layer.coverage.sizeInBytes();
+
+    // Every icon in every color; what a color switch costs when all are shown
+    auto timeComposite = [&](bool simd) {
+        timer.start();
+        for (const QColor &color : colors) {
+            for (const IconTint::Layers &layer : std::as_const(layers))
+                IconTint::composite(layer, color, simd);
+        }
+        return timer.nsecsElapsed() / colors.size();
+    };
+    const qint64 scalarNs = timeComposite(false);
+    const qint64 simdNs = timeComposite(true);
+
+    timer.start();
+    for (const SvgDocumentPtr &document : std::as_const(documents)) {
+        SvgDocument recolored(document->path(), IconTint::substituteCurrentColor(document->data(), colors.first()));
+        backend->render(recolored, size, 1.0);
+    }
+    const qint64 rerenderNs = timer.nsecsElapsed();
+
+    // The kernels agree exactly, and a composite matches rendering the
+    // substituted markup up to rounding
+    for (int i = 0; i < count; ++i) {
+        for (const QColor &color : colors) {
+            const QImage simd = IconTint::composite(layers[i], color, true);
+            if (simd != IconTint::composite(layers[i], color, false)) {
+                out() << "SIMD and scalar compositing differ for item " << i << Qt::endl;
+                return 1;
+            }
+            if (i % 97)
+                continue;
+            SvgDocument recolored(documents[i]->path(), IconTint::substituteCurrentColor(documents[i]->data(), color));
+            const QImage rendered = backend->render(recolored, size, 1.0).toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            for (int y = 0; y < rendered.height(); ++y) {
+                const auto *a = reinterpret_cast<const QRgb *>(simd.constScanLine(y));
+                const auto *b = reinterpret_cast<const QRgb *>(rendered.constScanLine(y));
+                for (int x = 0; x < rendered.width(); ++x) {
+                    // Three 8-bit roundings: two renders and the composite
+                    if (qAbs(qRed(a[x]) - qRed(b[x])) > 3 || qAbs(qGreen(a[x]) - qGreen(b[x])) > 3
+                        || qAbs(qBlue(a[x]) - qBlue(b[x])) > 3 || qAbs(qAlpha(a[x]) - qAlpha(b[x])) > 3) {
+                        out() << "Composite of item " << i << " differs from a render at " << x << "," << y << Qt::endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    // Interactive: the whole gallery switches, only what is shown composites
+    QScrollArea scrollArea;
+    scrollArea.setWidgetResizable(true);
+    QWidget *gallery = new QWidget;
+    QVBoxLayout *layout = new QVBoxLayout(gallery);
+    QList<SvgPair*> pairs;
+    for (const SvgDocumentPtr &document : std::as_const(documents)) {
+        pairs.append(new SvgPair(document, {}, iconSize, {backend}, {0}, gallery));
+        pairs.last()->setTint(IconTint::CurrentColor);
+        layout->addWidget(pairs.last());
+    }
+    scrollArea.setWidget(gallery);
+    scrollArea.resize(900, 700);
+    scrollArea.show();
+    QApplication::processEvents();
+
+    qint64 switchNs = 0;
+    for (const QColor &color : colors) {
+        timer.start();
+        for (SvgPair *pair : std::as_const(pairs))
+            pair->setTint(IconTint::CurrentColor, color);
+        QApplication::processEvents(); // Includes the repaint
+        switchNs += timer.nsecsElapsed();
+    }
+
+    const QLocale locale;
+    out() << count << " icons at " << iconSize << " px, masks " << locale.formattedDataSize(maskBytes) << Qt::endl
+          << "Build masks:      " << ms(layersNs) << " ms (two renders per icon)" << Qt::endl
+          << "Recolor all:      " << ms(scalarNs) << " ms scalar, " << ms(simdNs) << " ms "
+          << (IconTint::simdAvailable() ? "SSE2" : "without SIMD on this target") << Qt::endl
+          << "Render all again: " << ms(rerenderNs) << " ms" << Qt::endl
+          << "Gallery switch:   " << ms(switchNs) / colors.size() << " ms/color incl. repaint" << Qt::endl;
+    return 0;
+}
+
+int pngBuild(int count, bool optimize)
+{
+    QTemporaryDir dir;
+    const auto folder = QSharedPointer<LocalFolderSource>::create(dir.path());
+    for (int i = 0; i < count; ++i)
+        folder->write(syntheticName(i), syntheticSvg(i));
+
+    PngBuild::Options options;
+    options.optimize = optimize;
+    const int sizes = int(options.sizes.size());
+
+    int failures = 0;
+    QElapsedTimer timer;
+    auto step = [&](const char *name, int built, int unchanged, int removed) {
+        timer.start();
+        const PngBuild::Result result = PngBuild(folder, folder, options).run();
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        const bool ok = result.ok && result.failed == 0 && result.built == built
+                        && result.unchanged == unchanged && result.removed == removed;
+        out() << QString(name).leftJustified(10) << ms(elapsedNs) << " ms: " << result.summary()
+              << (ok ? "" : "  <-- MISMATCH") << Qt::endl;
+        if (!ok)
+            ++failures;
+        return elapsedNs;
+    };
+
+    out() << count << " SVGs at " << sizes << " sizes, " << (optimize ? "optimized" : "fast") << " encoding, "
+          << QThreadPool::globalInstance()->maxThreadCount() << " threads" << Qt::endl;
+    step("Cold", count, 0, 0);
+    step("Warm", 0, count, 0);
+
+    // One changed icon, one rewritten with the same content, one deleted
+    folder->write(syntheticName(0), syntheticSvg(count));
+    folder->write(syntheticName(1), syntheticSvg(1));
+    folder->remove(syntheticName(2));
+    const qint64 changedNs = step("Changed", 1, count - 2, sizes);
+    if (changedNs > 1000000000LL) {
+        out() << "Rebuilding one icon took over a second  <-- TOO SLOW" << Qt::endl;
+        ++failures;
+    }
+
+    // Both encodings must decode to the rendered pixels
+    for (int i = 0; i < qMin(count, 50); ++i) {
+        QSvgRenderer renderer(syntheticSvg(i));
+        QImage image(32, 32, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        renderer.render(&painter);
+        painter.end();
+        const QImage expected = image.convertToFormat(QImage::Format_ARGB32);
+        for (bool optimized : {false, true}) {
+            const QImage decoded = QImage::fromData(PngBuild::encode(image, optimized), "PNG").convertToFormat(QImage::Format_ARGB32);
+            if (decoded != expected) {
+                out() << syntheticName(i) << ": " << (optimized ? "optimized" : "fast") << " PNG does not decode to the render" << Qt::endl;
+                ++failures;
+            }
+        }
+    }
+
+    out() << (failures ? "FAILED" : "OK") << Qt::endl;
+    return failures ? 1 : 0;
+}
+
+int folderCompare(int count, int iconSize)
+{
+    if (count < 20) {
+        out() << "Compare at least 20 icons" << Qt::endl;
+        return 1;
+    }
+
+    QTemporaryDir dir;
+    QDir(dir.path()).mkpath("before");
+    QDir(dir.path()).mkpath("after");
+    const auto before = QSharedPointer<LocalFolderSource>::create(QDir(dir.path()).filePath("before"));
+    const auto after = QSharedPointer<LocalFolderSource>::create(QDir(dir.path()).filePath("after"));
+    for (int i = 0; i < count; ++i) {
+        before->write(syntheticName(i), syntheticSvg(i));
+        after->write(syntheticName(i), syntheticSvg(i));
+    }
+
+    // Ten redrawn icons, one only reformatted, one removed, one renamed, one new
+    constexpr int kChanged = 10;
+    for (int i = 0; i < kChanged; ++i)
+        after->write(syntheticName(i), syntheticSvg(count + i));
+    after->write(syntheticName(kChanged), syntheticSvg(kChanged).replace("/><", "/>\n<"));
+    after->remove(syntheticName(kChanged + 1));
+    after->write(QStringLiteral("renamed.svg"), syntheticSvg(kChanged + 2));
+    after->remove(syntheticName(kChanged + 2));
+    after->write(QStringLiteral("added.svg"), syntheticSvg(count + kChanged));
+
+    FolderCompare::Options options;
+    options.size = iconSize;
+    QElapsedTimer timer;
+    timer.start();
+    const FolderCompare::Result result = FolderCompare(before, after, options).run();
+    const qint64 elapsedNs = timer.nsecsElapsed();
+
+    out() << count << " SVGs per folder at " << iconSize << " px, " << QThreadPool::globalInstance()->maxThreadCount()
+          << " threads: " << ms(elapsedNs) << " ms, " << result.summary() << Qt::endl;
+    for (const FolderCompare::Change &change : result.changes) {
+        out() << "  " << FolderCompare::statusName(change.status).leftJustified(8) << change.name();
+        if (change.status == FolderCompare::Changed)
+            out() << "  " << QString::number(change.pixels.score() * 100, 'f', 1) << "% of pixels";
+        out() << Qt::endl;
+    }
+
+    const bool ok = result.ok && result.failed == 0 && result.changed == kChanged && result.identicalRenders == 1
+                    && result.added == 1 && result.removed == 1 && result.renamed == 1
+                    && result.unchanged == count - kChanged - 3;
+    out() << (ok ? "OK" : "FAILED") << Qt::endl;
+    return ok ? 0 : 1;
+}
+
+int inspector(int shapes)
+{
+    constexpr int kWidth = 2000;
+    constexpr int kHeight = 1500;
+    QString svg = QString("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%2\" viewBox=\"0 0 %1 %2\">")
+                      .arg(kWidth).arg(kHeight);
+    for (int i = 0; i < shapes; ++i) {
+        svg += QString("<path d=\"M%1 %2 q%3 %4 %5 0 t%6 %7 z\" fill=\"#%8\" fill-opacity=\"0.6\"/>")
+                   .arg(i * 37 % kWidth).arg(i * 53 % kHeight)
+                   .arg(20 + i % 80).arg(-40 - i % 60).arg(60 + i % 120)
+                   .arg(-30 - i % 50).arg(40 + i % 70)
+                   .arg(QString::number(0x204060 + i * 97 % 0xbfbfbf, 16).rightJustified(6, QLatin1Char('0')));
+    }
+    svg += "</svg>";
+    const SvgDocumentPtr document = SvgDocumentPtr::create(QStringLiteral("illustration.svg"), svg.toUtf8());
+
+    SvgInspector view;
+    view.resize(1280, 800);
+    view.show();
+    QApplication::processEvents();
+    view.setDocument(document);
+
+    // Every tile the view touches, at the most one partial row and column more on each side
+    const QSize viewport = view.viewport()->size();
+    const int maxTiles = (viewport.width() / SvgInspector::kTileSize + 2) * (viewport.height() / SvgInspector::kTileSize + 2);
+    int failures = 0;
+    QElapsedTimer timer;
+    auto show = [&](int zoom) {
+        view.setZoom(zoom);
+        const int before = view.tilesRendered();
+        timer.start();
+        view.viewport()->repaint();
+        while (view.isRendering())
+            QApplication::processEvents(QEventLoop::AllEvents, 5);
+        QApplication::processEvents(); // The last tiles in, and painted
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        const int tiles = view.tilesRendered() - before;
+        const double wholeMb = double(kWidth) * zoom * kHeight * zoom * 4 / (1024 * 1024);
+        out() << QString("%1×").arg(zoom).rightJustified(4) << ": " << tiles << " tile(s) in " << ms(elapsedNs) << " ms, "
+              << QString::number(tiles * 0.25, 'f', 1) << " MiB; whole at this zoom "
+              << QString::number(wholeMb, 'f', 0) << " MiB" << Qt::endl;
+        return tiles;
+    };
+
+    out() << shapes << " paths, " << kWidth << "×" << kHeight << " px at 1×, view " << viewport.width() << "×"
+          << viewport.height() << ", " << QThreadPool::globalInstance()->maxThreadCount() << " threads" << Qt::endl;
+    for (int zoom = 1; zoom <= SvgInspector::kMaxZoom; zoom *= 2) {
+        if (show(zoom) > maxTiles) {
+            out() << "More tiles than the view shows at " << zoom << "×" << Qt::endl;
+            ++failures;
+        }
+    }
+    if (show(SvgInspector::kMaxZoom / 2) != 0) {
+        out() << "Zooming back rendered again instead of using the cached tiles" << Qt::endl;
+        ++failures;
+    }
+
+    out() << (failures ? "FAILED" : "OK") << Qt::endl;
+    return failures ? 1 : 0;
+}
+
+} // namespace Benchmark
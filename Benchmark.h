@@ -0,0 +1,77 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+
+// Command-line benchmarks, printed to stdout. Each returns a process exit code.
+namespace Benchmark {
+
+// SvgIconEngine (parse + render per request) against replaying compiled display lists
+int displayList(const QString &directory, int iconSize);
+
+// Switching the background preset on galleries of 1k and 10k items
+int themeSwitch();
+
+// Memory across 1,000 icon size changes of the gallery items for <dir>;
+// fails if the resident set keeps growing after the first sweep
+int resizeMemory(const QString &directory);
+
+// Loading <dir> through storage with the given per-file latency: the old
+// one-file-at-a-time loop against GalleryLoader's batched, overlapped reads
+int loader(const QString &directory, int latencyMs, int iconSize);
+
+// Rendering at 1.0, 1.25, 1.5 and 2.0 device pixel ratios per backend
+int pixelRatios(const QString &directory, int iconSize);
+
+// Syncs a simulated remote folder into an in-memory mirror: a cold sync,
+// a warm one that must transfer nothing, and one after edits, additions
+// and a deletion. Fails if any transfer count is off
+int mirrorSync(int latencyMs);
+
+// Exports <count> generated icons as one streamed PNG contact sheet; fails if
+// memory grows by half of what the whole sheet would take, or it does not decode
+int contactSheet(int count, int iconSize);
+
+// Saves <count> generated icons as a session snapshot, then times mapping it
+// and building the gallery items from it up to the first paint. Fails if the
+// snapshot does not read back exactly
+int sessionRestore(int count, int iconSize);
+
+// Extracts metadata from <count> generated icons, sequentially and on the
+// thread pool, then sorts and groups the results the way the gallery does
+int metadata(int count);
+
+// Path data of the SVGs in <dir> through SvgPathParser, scalar and SIMD, in
+// MB/s, next to QSvgRenderer loading the same files. Fails if the two
+// parser modes disagree
+int pathParser(const QString &directory);
+
+// Lints the SVGs in <dir> sequentially and on the thread pool, and lists
+// what was found per rule. Fails if the two runs disagree
+int lint(const QString &directory);
+
+// Tinting <count> generated currentColor icons: building the masks, then
+// compositing every icon in new colors, scalar and SIMD, against rendering
+// them all again, and switching colors on a gallery of that many items.
+// Fails if the two kernels differ or a composite is off from a real render
+int tint(int count, int iconSize);
+
+// Builds PNGs for <count> generated icons in a temporary folder: cold, warm,
+// then after one edit, one rewrite with the same content and one deletion.
+// Fails if the build counts are off or an encoding does not decode to the
+// rendered pixels
+int pngBuild(int count, bool optimize);
+
+// Compares two temporary folders of <count> generated icons that differ by
+// a few edits, an edit that renders the same, an addition, a removal and a
+// rename. Fails if any of them is missed or miscounted
+int folderCompare(int count, int iconSize);
+
+// Zooms SvgInspector from 1× to 64× into a generated 2000×1500 illustration
+// of <shapes> paths, then back one level. Fails if more tiles are rendered
+// than the view shows, or if the level zoomed back to is rendered again
+int inspector(int shapes);
+
+} // namespace Benchmark
+
+#endif // BENCHMARK_H
@@ -0,0 +1,410 @@
+#include "ContactSheet.h"
+
+#include "GalleryTheme.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QFontMetrics>
+#include <QFuture>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QSaveFile>
+#include <QSvgRenderer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtEndian>
+#include <QtMath>
+
+#if __has_include(<QtZlib/zlib.h>)
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+namespace {
+
+// Flat backgrounds and small icons compress well even at the fastest level,
+// and deflate is the one step of the export that does not run in parallel
+constexpr int kCompressionLevel = 1;
+constexpr int kIdatSize = 1 << 16;
+
+constexpr int kMinLabelWidth = 72;  // Cell width that keeps file names readable
+constexpr int kHeaderMargin = 8;
+
+QFont pixelFont(int pixelSize, bool bold)
+{
+    QFont font;
+    font.setPixelSize(pixelSize);
+    font.setBold(bold);
+    return font;
+}
+
+const QFont &titleFont() { static const QFont font = pixelFont(13, true);  return font; }
+const QFont &labelFont() { static const QFont font = pixelFont(10, false); return font; }
+
+// Writes an 8-bit RGB PNG from rows handed over in order. The image data is
+// one zlib stream cut into IDAT chunks, so only a row and the deflate window
+// are held at any time.
+class PngStreamWriter
+{
+public:
+    explicit PngStreamWriter(QIODevice *device)
+        : m_device(device)
+    {
+    }
+
+    ~PngStreamWriter()
+    {
+        if (m_started)
+            deflateEnd(&m_stream);
+    }
+
+    bool begin(const QSize &size)
+    {
+        m_width = size.width();
+        if (m_device->write("\x89PNG\r\n\x1a\n", 8) != 8)
+            return false;
+
+        char header[13] = {};
+        qToBigEndian<quint32>(quint32(size.width()), header);
+        qToBigEndian<quint32>(quint32(size.height()), header + 4);
+        header[8] = 8; // Bits per channel
+        header[9] = 2; // Truecolor; deflate, adaptive filtering and no interlace are all 0
+        if (!writeChunk("IHDR", QByteArrayView(header, sizeof(header))))
+            return false;
+
+        if (deflateInit(&m_stream, kCompressionLevel) != Z_OK)
+            return false;
+        m_started = true;
+        m_row.resize(1 + 3 * qsizetype(m_width));
+        m_out.resize(kIdatSize);
+        return true;
+    }
+
+    // RGB32 rows, m_width wide
+    bool writeRows(const QImage &image)
+    {
+        for (int y = 0; y < image.height(); ++y) {
+            const QRgb *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            uchar *out = reinterpret_cast<uchar *>(m_row.data());
+            *out++ = 0; // Filter type: none
+            for (int x = 0; x < m_width; ++x) {
+                *out++ = uchar(qRed(pixels[x]));
+                *out++ = uchar(qGreen(pixels[x]));
+                *out++ = uchar(qBlue(pixels[x]));
+            }
+            m_stream.next_in = reinterpret_cast<Bytef *>(m_row.data());
+            m_stream.avail_in = uInt(m_row.size());
+            if (!deflateRows(Z_NO_FLUSH))
+                return false;
+        }
+        return true;
+    }
+
+    bool finish()
+    {
+        m_stream.next_in = nullptr;
+        m_stream.avail_in = 0;
+        return deflateRows(Z_FINISH) && writeChunk("IEND", QByteArrayView());
+    }
+
+private:
+    // Fills the output buffer; every full buffer becomes one IDAT chunk
+    bool deflateRows(int flush)
+    {
+        int status = Z_OK;
+        do {
+            m_stream.next_out = reinterpret_cast<Bytef *>(m_out.data()) + m_outUsed;
+            m_stream.avail_out = uInt(m_out.size() - m_outUsed);
+            status = deflate(&m_stream, flush);
+            if (status == Z_STREAM_ERROR)
+                return false;
+            m_outUsed = m_out.size() - m_stream.avail_out;
+            if (m_outUsed == m_out.size()) {
+                if (!writeChunk("IDAT", m_out))
+                    return false;
+                m_outUsed = 0;
+            }
+        } while (m_stream.avail_out == 0 || (flush == Z_FINISH && status != Z_STREAM_END));
+
+        if (flush == Z_FINISH && m_outUsed > 0) {
+            if (!writeChunk("IDAT", QByteArrayView(m_out.constData(), m_outUsed)))
+                return false;
+            m_outUsed = 0;
+        }
+        return true;
+    }
+
+    bool writeChunk(const char *type, QByteArrayView data)
+    {
+        char length[4];
+        qToBigEndian<quint32>(quint32(data.size()), length);
+        uLong crc = crc32(0, reinterpret_cast<const Bytef *>(type), 4);
+        if (!data.isEmpty())
+            crc = crc32(crc, reinterpret_cast<const Bytef *>(data.data()), uInt(data.size()));
+        char checksum[4];
+        qToBigEndian<quint32>(quint32(crc), checksum);
+
+        return m_device->write(length, 4) == 4
+               && m_device->write(type, 4) == 4
+               && m_device->write(data.data(), data.size()) == data.size()
+               && m_device->write(checksum, 4) == 4;
+    }
+
+    QIODevice *m_device;
+    z_stream m_stream = {};
+    bool m_started = false;
+    int m_width = 0;
+    QByteArray m_row;
+    QByteArray m_out;
+    qsizetype m_outUsed = 0;
+};
+
+} // namespace
+
+ContactSheet::ContactSheet(const QList<SvgDocumentPtr> &documents, const Options &options)
+    : m_documents(documents)
+    , m_options(options)
+{
+    for (const SvgDocumentPtr &document : m_documents)
+        m_names.append(QFileInfo(document->path()).fileName());
+
+    // Columns for a roughly square section at the largest cell size
+    m_columns = options.columns;
+    if (m_columns <= 0) {
+        QSize cell(1, 1);
+        for (const Section &section : options.sections) {
+            const Layout layout = layoutFor(section);
+            cell = cell.expandedTo(QSize(layout.cellWidth, layout.cellHeight));
+        }
+        m_columns = qCeil(qSqrt(qreal(m_documents.size()) * cell.height() / cell.width()));
+    }
+    m_columns = qBound(1, m_columns, qMax(1, int(m_documents.size())));
+
+    // Cut every section into a header band and bands of whole cell rows
+    int width = 0;
+    int height = 0;
+    for (const Section &section : options.sections) {
+        Layout layout = layoutFor(section);
+        layout.rows = int((m_documents.size() + m_columns - 1) / m_columns);
+        m_layouts.append(layout);
+        width = qMax(width, m_columns * layout.cellWidth);
+
+        const int index = m_layouts.size() - 1;
+        m_bands.append(Band{index, -1, 0, layout.headerHeight});
+        height += layout.headerHeight;
+
+        const int rowsPerBand = qMax(1, options.bandHeight / layout.cellHeight);
+        for (int row = 0; row < layout.rows; row += rowsPerBand) {
+            const int rowCount = qMin(rowsPerBand, layout.rows - row);
+            m_bands.append(Band{index, row, rowCount, rowCount * layout.cellHeight});
+            height += rowCount * layout.cellHeight;
+        }
+    }
+    m_size = QSize(width, height);
+}
+
+ContactSheet::Layout ContactSheet::layoutFor(const Section &section) const
+{
+    Layout layout;
+    layout.section = section;
+    const int padding = qMax(6, section.iconSize / 4);
+    const int labelHeight = m_options.labels ? QFontMetrics(labelFont()).height() + 2 : 0;
+    layout.cellWidth = qMax(section.iconSize, m_options.labels ? kMinLabelWidth : 0) + 2 * padding;
+    layout.cellHeight = section.iconSize + 2 * padding + labelHeight;
+    layout.headerHeight = QFontMetrics(titleFont()).height() + 2 * kHeaderMargin;
+    return layout;
+}
+
+void ContactSheet::drawHeader(QPainter &painter, const Layout &layout, const QRect &rect) const
+{
+    const GalleryTheme theme(layout.section.background);
+    painter.setPen(theme.text());
+    painter.setFont(titleFont());
+    painter.drawText(rect.adjusted(kHeaderMargin, 0, -kHeaderMargin, 0), Qt::AlignLeft | Qt::AlignVCenter,
+                     layout.section.title);
+}
+
+void ContactSheet::drawCell(QPainter &painter, const Layout &layout, const QRect &cell, int index) const
+{
+    const int size = layout.section.iconSize;
+    const int padding = qMax(6, size / 4);
+    const QRect iconRect(cell.x() + (cell.width() - size) / 2, cell.y() + padding, size, size);
+
+    // A renderer of its own: cells render on several threads, and the
+    // documents' shared parsed forms belong to the GUI thread
+    QSvgRenderer renderer(m_documents[index]->data());
+    if (renderer.isValid()) {
+        renderer.setAspectRatioMode(Qt::KeepAspectRatio);
+        renderer.render(&painter, iconRect);
+    }
+
+    if (!m_options.labels)
+        return;
+    QColor dimmed = GalleryTheme(layout.section.background).text();
+    dimmed.setAlpha(renderer.isValid() ? 170 : 255);
+    painter.setPen(renderer.isValid() ? dimmed : QColor(Qt::red));
+    painter.setFont(labelFont());
+    const QFontMetrics metrics(labelFont());
+    const QRect labelRect(cell.x() + 2, iconRect.bottom() + 1 + padding / 2, cell.width() - 4, metrics.height());
+    painter.drawText(labelRect, Qt::AlignHCenter | Qt::AlignTop,
+                     metrics.elidedText(m_names[index], Qt::ElideMiddle, labelRect.width()));
+}
+
+QImage ContactSheet::renderBand(const Band &band) const
+{
+    const Layout &layout = m_layouts[band.layout];
+    QImage image(m_size.width(), band.height, QImage::Format_RGB32);
+    image.fill(layout.section.background);
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    if (band.firstRow < 0) {
+        drawHeader(painter, layout, image.rect());
+        return image;
+    }
+
+    for (int row = 0; row < band.rowCount; ++row) {
+        for (int column = 0; column < m_columns; ++column) {
+            const int index = (band.firstRow + row) * m_columns + column;
+            if (index >= m_documents.size())
+                break;
+            const QRect cell(column * layout.cellWidth, row * layout.cellHeight, layout.cellWidth, layout.cellHeight);
+            drawCell(painter, layout, cell, index);
+        }
+    }
+    return image;
+}
+
+bool ContactSheet::writePng(const QString &path, const Progress &progress)
+{
+    m_error.clear();
+    if (m_size.isEmpty()) {
+        m_error = QStringLiteral("Nothing to export");
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_error = file.errorString();
+        return false;
+    }
+    PngStreamWriter png(&file);
+    if (!png.begin(m_size)) {
+        m_error = QStringLiteral("Cannot start the PNG stream");
+        return false;
+    }
+
+    // Bands render ahead on every core and are written in order. At most one
+    // band per thread is in flight, which is what bounds memory.
+    // The pool goes before the file, so returning early waits for the bands
+    // still rendering.
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    QList<QFuture<QImage>> pending;
+    int next = 0;
+
+    for (int done = 0; done < m_bands.size(); ++done) {
+        while (next < m_bands.size() && pending.size() < pool.maxThreadCount()) {
+            const Band band = m_bands[next++];
+            pending.append(QtConcurrent::run(&pool, [this, band] {
+                return renderBand(band);
+            }));
+        }
+
+        const QImage image = pending.takeFirst().result();
+        if (!png.writeRows(image)) {
+            m_error = file.errorString();
+            return false;
+        }
+        if (progress && !progress(done + 1, bandCount())) {
+            m_error = QStringLiteral("Canceled");
+            file.cancelWriting();
+            return false;
+        }
+    }
+
+    if (!png.finish() || !file.commit()) {
+        m_error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool ContactSheet::writePdf(const QString &path, const Progress &progress)
+{
+    m_error.clear();
+    QPdfWriter writer(path);
+    writer.setTitle(QFileInfo(path).completeBaseName());
+    writer.setResolution(96); // One unit per pixel, as on the PNG sheet
+    writer.setPageLayout(QPageLayout(QPageSize(QPageSize::A4), QPageLayout::Portrait, QMarginsF()));
+
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        m_error = QStringLiteral("Cannot write %1").arg(path);
+        return false;
+    }
+    const QRect page(0, 0, writer.width(), writer.height());
+
+    // Same sections and cells as the PNG, reflowed to the page width
+    struct Pagination {
+        int columns;
+        int rowsPerPage;
+        int pages;
+    };
+    QList<Pagination> paginations;
+    int totalPages = 0;
+    for (const Layout &layout : m_layouts) {
+        Pagination pagination;
+        pagination.columns = qMax(1, page.width() / layout.cellWidth);
+        pagination.rowsPerPage = qMax(1, (page.height() - layout.headerHeight) / layout.cellHeight);
+        const int rows = int((m_documents.size() + pagination.columns - 1) / pagination.columns);
+        pagination.pages = qMax(1, (rows + pagination.rowsPerPage - 1) / pagination.rowsPerPage);
+        paginations.append(pagination);
+        totalPages += pagination.pages;
+    }
+
+    // Icons stay vectors; each page is finished before the next is drawn
+    int done = 0;
+    for (int i = 0; i < m_layouts.size(); ++i) {
+        Layout layout = m_layouts[i];
+        const Pagination &pagination = paginations[i];
+        const QString title = layout.section.title;
+        const int perPage = pagination.columns * pagination.rowsPerPage;
+
+        for (int pageIndex = 0; pageIndex < pagination.pages; ++pageIndex) {
+            if (done > 0)
+                writer.newPage();
+            painter.fillRect(page, layout.section.background);
+
+            layout.section.title = pagination.pages > 1
+                ? QStringLiteral("%1 (%2/%3)").arg(title).arg(pageIndex + 1).arg(pagination.pages)
+                : title;
+            drawHeader(painter, layout, QRect(0, 0, page.width(), layout.headerHeight));
+
+            const int first = pageIndex * perPage;
+            const int last = qMin(int(m_documents.size()), first + perPage);
+            for (int index = first; index < last; ++index) {
+                const int row = (index - first) / pagination.columns;
+                const int column = (index - first) % pagination.columns;
+                const QRect cell(column * layout.cellWidth, layout.headerHeight + row * layout.cellHeight,
+                                 layout.cellWidth, layout.cellHeight);
+                drawCell(painter, layout, cell, index);
+            }
+
+            if (progress && !progress(++done, totalPages)) {
+                painter.end();
+                QFile::remove(path);
+                m_error = QStringLiteral("Canceled");
+                return false;
+            }
+        }
+    }
+
+    if (!painter.end()) {
+        m_error = QStringLiteral("Cannot write %1").arg(path);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef CONTACTSHEET_H
+#define CONTACTSHEET_H
+
+#include "SvgDocument.h"
+
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QRect>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+
+class QPainter;
+
+// An overview of many SVGs for design reviews: one section per icon size and
+// background, each a grid of icons with their file names.
+//
+// PNG export renders horizontal bands of the sheet in parallel and streams
+// them through zlib as they complete, so peak memory is a few bands, not the
+// sheet. PDF export draws the icons as vectors, one page at a time.
+class ContactSheet
+{
+public:
+    struct Section {
+        int iconSize = 32;
+        QColor background;
+        QString title;
+    };
+
+    struct Options {
+        QList<Section> sections;
+        int columns = 0;        // 0 picks a roughly square sheet
+        bool labels = true;     // File names under the icons
+        int bandHeight = 256;   // Rendered at once per PNG band, in pixels
+    };
+
+    // Called after each band or page; return false to cancel
+    using Progress = std::function<bool(int done, int total)>;
+
+    ContactSheet(const QList<SvgDocumentPtr> &documents, const Options &options);
+
+    QSize pngSize() const { return m_size; }
+    int bandCount() const { return int(m_bands.size()); }
+
+    bool writePng(const QString &path, const Progress &progress = {});
+    bool writePdf(const QString &path, const Progress &progress = {});
+    QString errorString() const { return m_error; }
+
+private:
+    struct Layout {
+        Section section;
+        int cellWidth = 0;
+        int cellHeight = 0;
+        int headerHeight = 0;
+        int rows = 0;
+    };
+    // A horizontal strip of the PNG: a section header or some rows of cells
+    struct Band {
+        int layout = 0;
+        int firstRow = -1; // -1 for the header
+        int rowCount = 0;
+        int height = 0;
+    };
+
+    Layout layoutFor(const Section &section) const;
+    QImage renderBand(const Band &band) const;
+    void drawHeader(QPainter &painter, const Layout &layout, const QRect &rect) const;
+    void drawCell(QPainter &painter, const Layout &layout, const QRect &cell, int index) const;
+
+    QList<SvgDocumentPtr> m_documents;
+    QStringList m_names;
+    Options m_options;
+    int m_columns = 1;
+    QList<Layout> m_layouts;
+    QList<Band> m_bands;
+    QSize m_size;
+    QString m_error;
+};
+
+#endif // CONTACTSHEET_H
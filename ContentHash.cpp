@@ -0,0 +1,46 @@
+#include "ContentHash.h"
+
+#include <QtEndian>
+
+#include <cstring>
+
+quint64 contentHash(QByteArrayView data, quint64 seed)
+{
+    constexpr quint64 m = 0xc6a4a7935bd1e995ULL;
+    constexpr int r = 47;
+
+    const qsizetype len = data.size();
+    const uchar *p = reinterpret_cast<const uchar *>(data.data());
+    const uchar *end = p + (len & ~qsizetype(7));
+
+    quint64 h = seed ^ (quint64(len) * m);
+
+    for (; p != end; p += 8) {
+        quint64 k;
+        std::memcpy(&k, p, sizeof(k));
+        k = qFromLittleEndian(k);
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch (len & 7) {
+    case 7: h ^= quint64(p[6]) << 48; Q_FALLTHROUGH();
+    case 6: h ^= quint64(p[5]) << 40; Q_FALLTHROUGH();
+    case 5: h ^= quint64(p[4]) << 32; Q_FALLTHROUGH();
+    case 4: h ^= quint64(p[3]) << 24; Q_FALLTHROUGH();
+    case 3: h ^= quint64(p[2]) << 16; Q_FALLTHROUGH();
+    case 2: h ^= quint64(p[1]) << 8;  Q_FALLTHROUGH();
+    case 1: h ^= quint64(p[0]);
+            h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
@@ -0,0 +1,11 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include <QByteArrayView>
+#include <QtGlobal>
+
+// Fast, non-cryptographic 64-bit hash of file contents (MurmurHash64A).
+// Stable across platforms and runs, so it can be persisted.
+quint64 contentHash(QByteArrayView data, quint64 seed = 0);
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,239 @@
+#include "FolderCompare.h"
+
+#include "ContentHash.h"
+
+#include <QHash>
+#include <QPainter>
+#include <QSet>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+
+namespace {
+
+QSet<QString> svgNames(const QList<FolderEntry> &listing)
+{
+    QSet<QString> names;
+    names.reserve(listing.size());
+    for (const FolderEntry &entry : listing) {
+        if (entry.name.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive))
+            names.insert(entry.name);
+    }
+    return names;
+}
+
+FolderCompare::Change change(FolderCompare::Status status, const QString &beforeName, const QString &afterName)
+{
+    FolderCompare::Change result;
+    result.status = status;
+    result.beforeName = beforeName;
+    result.afterName = afterName;
+    return result;
+}
+
+} // namespace
+
+QString FolderCompare::Result::summary() const
+{
+    QString text = QString("%1 changed, %2 added, %3 removed, %4 renamed, %5 unchanged")
+                       .arg(changed).arg(added).arg(removed).arg(renamed).arg(unchanged);
+    if (identicalRenders)
+        text += QString(", %1 edited without a visible change").arg(identicalRenders);
+    if (failed)
+        text += QString(", %1 unreadable").arg(failed);
+    return text;
+}
+
+FolderCompare::FolderCompare(const FolderSourcePtr &before, const FolderSourcePtr &after, const Options &options)
+    : m_before(before)
+    , m_after(after)
+    , m_options(options)
+{
+}
+
+QString FolderCompare::statusName(Status status)
+{
+    switch (status) {
+    case Changed:
+        return QStringLiteral("changed");
+    case Added:
+        return QStringLiteral("added");
+    case Removed:
+        return QStringLiteral("removed");
+    case Renamed:
+        return QStringLiteral("renamed");
+    }
+    return {};
+}
+
+FolderCompare::Read FolderCompare::read(const QString &name, bool inBefore, bool inAfter) const
+{
+    Read result;
+    result.name = name;
+    result.inBefore = inBefore;
+    result.inAfter = inAfter;
+    if (inBefore) {
+        result.beforeData = m_before->read(name);
+        result.beforeHash = contentHash(result.beforeData);
+    }
+    if (inAfter) {
+        result.afterData = m_after->read(name);
+        result.afterHash = contentHash(result.afterData);
+    }
+    result.failed = (inBefore && result.beforeData.isEmpty()) || (inAfter && result.afterData.isEmpty());
+
+    // Most of a release is unchanged; only what may be rendered stays in memory
+    if (!result.failed && inBefore && inAfter && result.beforeHash == result.afterHash) {
+        result.beforeData.clear();
+        result.afterData.clear();
+    }
+    return result;
+}
+
+FolderCompare::Change FolderCompare::render(const Pending &pending) const
+{
+    Change result = pending.change;
+    const QSize size(m_options.size, m_options.size);
+    if (!pending.beforeData.isEmpty())
+        result.before = VisualDiff::renderSvg(pending.beforeData, size);
+    if (result.status == Renamed)
+        result.after = result.before; // The same content
+    else if (!pending.afterData.isEmpty())
+        result.after = VisualDiff::renderSvg(pending.afterData, size);
+    if (result.status == Changed) {
+        QImage changed;
+        result.pixels = VisualDiff::compare(result.before, result.after, m_options.tolerance, &changed);
+
+        // The changes alone are hard to place; the new icon shows through faintly
+        result.diff = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        result.diff.fill(Qt::transparent);
+        QPainter painter(&result.diff);
+        painter.setOpacity(0.25);
+        painter.drawImage(0, 0, result.after);
+        painter.setOpacity(1.0);
+        painter.drawImage(0, 0, changed);
+    }
+    return result;
+}
+
+FolderCompare::Result FolderCompare::run(const Progress &progress)
+{
+    Result result;
+    if (m_options.size <= 0) {
+        result.error = QLatin1String("No render size");
+        return result;
+    }
+
+    // Both listings at once; slow storage pays its latency only once
+    QFuture<QList<FolderEntry>> beforeListing = m_before->listAsync();
+    QFuture<QList<FolderEntry>> afterListing = m_after->listAsync();
+    const QSet<QString> inBefore = svgNames(beforeListing.result());
+    const QSet<QString> inAfter = svgNames(afterListing.result());
+    if (inBefore.isEmpty() && !m_before->isReady()) {
+        result.error = QString("%1 is not accessible").arg(m_before->displayName());
+        return result;
+    }
+    if (inAfter.isEmpty() && !m_after->isReady()) {
+        result.error = QString("%1 is not accessible").arg(m_after->displayName());
+        return result;
+    }
+
+    QSet<QString> all = inBefore;
+    all.unite(inAfter);
+    QStringList names(all.cbegin(), all.cend());
+    names.sort();
+
+    // Read and hashed on the I/O pool, compared here in name order
+    QFuture<Read> reads = QtConcurrent::mapped(FolderSource::ioPool(), names, [&](const QString &name) {
+        return read(name, inBefore.contains(name), inAfter.contains(name));
+    });
+    QList<Pending> pending;
+    QList<Read> gone;
+    QList<Read> arrived;
+    for (int i = 0; i < names.size(); ++i) {
+        const Read file = reads.resultAt(i);
+        if (file.failed) {
+            ++result.failed;
+        } else if (file.inBefore && file.inAfter) {
+            if (file.beforeHash == file.afterHash)
+                ++result.unchanged;
+            else
+                pending.append({change(Changed, file.name, file.name), file.beforeData, file.afterData});
+        } else if (file.inBefore) {
+            gone.append(file);
+        } else {
+            arrived.append(file);
+        }
+        if (progress && !progress(i + 1, int(names.size()))) {
+            reads.cancel();
+            reads.waitForFinished();
+            result.error = QLatin1String("Canceled");
+            return result;
+        }
+    }
+
+    // Content that left one name and arrived under another is a rename;
+    // several copies pair up in name order
+    QHash<quint64, QList<int>> goneByHash;
+    for (int i = 0; i < gone.size(); ++i)
+        goneByHash[gone[i].beforeHash].append(i);
+    QList<bool> renamed(gone.size(), false);
+    for (const Read &file : std::as_const(arrived)) {
+        const auto it = goneByHash.find(file.afterHash);
+        if (it != goneByHash.end() && !it->isEmpty()) {
+            const int index = it->takeFirst();
+            renamed[index] = true;
+            pending.append({change(Renamed, gone[index].name, file.name), gone[index].beforeData, {}});
+        } else {
+            pending.append({change(Added, QString(), file.name), {}, file.afterData});
+        }
+    }
+    for (int i = 0; i < gone.size(); ++i) {
+        if (!renamed[i])
+            pending.append({change(Removed, gone[i].name, QString()), gone[i].beforeData, {}});
+    }
+
+    QFuture<Change> renders = QtConcurrent::mapped(QThreadPool::globalInstance(), pending,
+                                                   [this](const Pending &item) { return render(item); });
+    for (int i = 0; i < pending.size(); ++i) {
+        Change rendered = renders.resultAt(i);
+        switch (rendered.status) {
+        case Changed:
+            if (rendered.pixels.identical()) {
+                ++result.identicalRenders;
+                break;
+            }
+            ++result.changed;
+            result.changes.append(std::move(rendered));
+            break;
+        case Added:
+            ++result.added;
+            result.changes.append(std::move(rendered));
+            break;
+        case Removed:
+            ++result.removed;
+            result.changes.append(std::move(rendered));
+            break;
+        case Renamed:
+            ++result.renamed;
+            result.changes.append(std::move(rendered));
+            break;
+        }
+        if (progress && !progress(i + 1, int(pending.size()))) {
+            renders.cancel();
+            renders.waitForFinished();
+            result.error = QLatin1String("Canceled");
+            return result;
+        }
+    }
+
+    // Each status is in name order already
+    std::stable_sort(result.changes.begin(), result.changes.end(), [](const Change &a, const Change &b) {
+        if (a.status != b.status)
+            return a.status < b.status;
+        return a.status == Changed && a.pixels.score() > b.pixels.score();
+    });
+    result.ok = true;
+    return result;
+}
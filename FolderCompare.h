@@ -0,0 +1,97 @@
+#ifndef FOLDERCOMPARE_H
+#define FOLDERCOMPARE_H
+
+#include "FolderSource.h"
+#include "VisualDiff.h"
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+// Compares two versions of an icon folder, such as the icons of two client
+// releases. SVGs are paired by name, and files are read and hashed on the
+// I/O pool; a pair with the same content hash is unchanged without being
+// rendered, and content that only moved to another name is a rename. Only
+// pairs whose content differs are rendered, on the global thread pool, and
+// scored by VisualDiff, so an edit that changes no pixel is not reported.
+class FolderCompare
+{
+public:
+    struct Options {
+        int size = 32;     // Render size in pixels
+        int tolerance = 2; // Per channel, as in VisualDiff::compare()
+    };
+
+    enum Status { Changed, Added, Removed, Renamed };
+
+    struct Change {
+        Status status = Changed;
+        QString beforeName; // Empty when added
+        QString afterName;  // Empty when removed
+        QImage before;      // Renders at Options::size; null where there is no file
+        QImage after;
+        QImage diff;        // Changed pixels over the faded after render; only for Changed
+        VisualDiff::Result pixels;
+
+        QString name() const { return afterName.isEmpty() ? beforeName : afterName; }
+    };
+
+    struct Result {
+        bool ok = false;
+        QString error;
+        QList<Change> changes; // Most changed first, then added, removed and renamed, each by name
+        int changed = 0;
+        int added = 0;
+        int removed = 0;
+        int renamed = 0;
+        int unchanged = 0;        // Same content hash
+        int identicalRenders = 0; // Content differs, rendering does not; not listed
+        int failed = 0;           // Could not be read
+
+        QString summary() const;
+    };
+
+    // Called as files are read, then as changes are rendered, with the
+    // counts of that step; return false to cancel
+    using Progress = std::function<bool(int done, int total)>;
+
+    FolderCompare(const FolderSourcePtr &before, const FolderSourcePtr &after, const Options &options = Options());
+
+    // Blocking
+    Result run(const Progress &progress = {});
+
+    static QString statusName(Status status);
+
+private:
+    // One name in either folder, read and hashed on the I/O pool; the data
+    // is only kept when it has to be rendered
+    struct Read {
+        QString name;
+        bool inBefore = false;
+        bool inAfter = false;
+        bool failed = false;
+        quint64 beforeHash = 0;
+        quint64 afterHash = 0;
+        QByteArray beforeData;
+        QByteArray afterData;
+    };
+
+    // A change with the content to render it from
+    struct Pending {
+        Change change;
+        QByteArray beforeData;
+        QByteArray afterData;
+    };
+
+    Read read(const QString &name, bool inBefore, bool inAfter) const;
+    Change render(const Pending &pending) const;
+
+    FolderSourcePtr m_before;
+    FolderSourcePtr m_after;
+    Options m_options;
+};
+
+#endif // FOLDERCOMPARE_H
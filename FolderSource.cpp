@@ -0,0 +1,273 @@
+#include "FolderSource.h"
+
+#include "AndroidFolder.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimeZone>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+// ── FolderSource ───────────────────────────────────────────────
+
+QString FolderSource::localPath(const QString &fileName) const
+{
+    Q_UNUSED(fileName)
+    return {};
+}
+
+QThreadPool *FolderSource::ioPool()
+{
+    static QThreadPool *pool = [] {
+        QThreadPool *pool = new QThreadPool;
+        pool->setMaxThreadCount(4);
+        pool->setObjectName(QStringLiteral("FolderSource I/O"));
+        return pool;
+    }();
+    return pool;
+}
+
+void FolderSource::setMaxParallelReads(int count)
+{
+    ioPool()->setMaxThreadCount(qMax(1, count));
+}
+
+QFuture<QList<FolderEntry>> FolderSource::listAsync() const
+{
+    QSharedPointer<const FolderSource> self = sharedFromThis();
+    return QtConcurrent::run(ioPool(), [self] {
+        return self->list();
+    });
+}
+
+QFuture<FolderBatch> FolderSource::readAsync(const QStringList &fileNames, int batchSize) const
+{
+    QList<QStringList> batches;
+    batchSize = qMax(1, batchSize);
+    for (qsizetype i = 0; i < fileNames.size(); i += batchSize)
+        batches.append(fileNames.mid(i, batchSize));
+
+    QSharedPointer<const FolderSource> self = sharedFromThis();
+    return QtConcurrent::mapped(ioPool(), std::move(batches), [self](const QStringList &names) {
+        FolderBatch batch;
+        batch.reserve(names.size());
+        for (const QString &name : names)
+            batch.append(FolderFile{name, self->read(name)});
+        return batch;
+    });
+}
+
+// ── LocalFolderSource ──────────────────────────────────────────
+
+LocalFolderSource::LocalFolderSource(const QString &path)
+    : m_dir(path)
+{
+}
+
+QString LocalFolderSource::displayName() const
+{
+    return m_dir.path();
+}
+
+bool LocalFolderSource::isReady() const
+{
+    // Unreadable lists as empty, so it is not ready either
+    return m_dir.exists() && m_dir.isReadable();
+}
+
+QList<FolderEntry> LocalFolderSource::list() const
+{
+    // One directory scan returns names and metadata together
+    QList<FolderEntry> result;
+    const QFileInfoList infos = m_dir.entryInfoList(QDir::Files, QDir::Name);
+    result.reserve(infos.size());
+    for (const QFileInfo &info : infos)
+        result.append(FolderEntry{info.fileName(), info.size(), info.lastModified()});
+    return result;
+}
+
+QByteArray LocalFolderSource::read(const QString &fileName) const
+{
+    QFile file(m_dir.absoluteFilePath(fileName));
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    return file.readAll();
+}
+
+bool LocalFolderSource::write(const QString &fileName, const QByteArray &data)
+{
+    QSaveFile file(m_dir.absoluteFilePath(fileName));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(data);
+    return file.commit();
+}
+
+bool LocalFolderSource::remove(const QString &fileName)
+{
+    return QFile::remove(m_dir.absoluteFilePath(fileName));
+}
+
+QString LocalFolderSource::localPath(const QString &fileName) const
+{
+    return m_dir.absoluteFilePath(fileName);
+}
+
+// ── MemoryFolderSource ─────────────────────────────────────────
+
+MemoryFolderSource::MemoryFolderSource(const QString &name, const QHash<QString, QByteArray> &files)
+    : m_name(name)
+    , m_files(files)
+{
+    m_lastWrite = QDateTime::currentDateTimeUtc();
+    for (auto it = m_files.cbegin(); it != m_files.cend(); ++it)
+        m_modified.insert(it.key(), m_lastWrite);
+}
+
+QList<FolderEntry> MemoryFolderSource::list() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<FolderEntry> result;
+    for (auto it = m_files.cbegin(); it != m_files.cend(); ++it)
+        result.append(FolderEntry{it.key(), it.value().size(), m_modified.value(it.key())});
+    return result;
+}
+
+QByteArray MemoryFolderSource::read(const QString &fileName) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_files.value(fileName);
+}
+
+bool MemoryFolderSource::write(const QString &fileName, const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    m_files.insert(fileName, data);
+
+    // Strictly increasing, so two writes within a millisecond still differ
+    QDateTime now = QDateTime::currentDateTimeUtc();
+    if (m_lastWrite.isValid() && now <= m_lastWrite)
+        now = m_lastWrite.addMSecs(1);
+    m_lastWrite = now;
+    m_modified.insert(fileName, now);
+    return true;
+}
+
+bool MemoryFolderSource::remove(const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+    m_modified.remove(fileName);
+    return m_files.remove(fileName);
+}
+
+// ── AndroidFolderSource ────────────────────────────────────────
+
+AndroidFolderSource::AndroidFolderSource(AndroidFolder *folder)
+    : m_folder(folder)
+{
+}
+
+QString AndroidFolderSource::displayName() const
+{
+    return m_folder->treeUri();
+}
+
+bool AndroidFolderSource::isReady() const
+{
+    return m_folder->isReady();
+}
+
+QList<FolderEntry> AndroidFolderSource::list() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<FolderEntry> result;
+    for (const AndroidFolder::Entry &entry : m_folder->entries()) {
+        QDateTime lastModified;
+        if (entry.lastModified >= 0)
+            lastModified = QDateTime::fromMSecsSinceEpoch(entry.lastModified, QTimeZone::UTC);
+        result.append(FolderEntry{entry.name, entry.size, lastModified});
+    }
+    return result;
+}
+
+QByteArray AndroidFolderSource::read(const QString &fileName) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_folder->read(fileName);
+}
+
+bool AndroidFolderSource::write(const QString &fileName, const QByteArray &data)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_folder->write(fileName, data);
+}
+
+bool AndroidFolderSource::remove(const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_folder->remove(fileName);
+}
+
+// ── SimulatedFolderSource ──────────────────────────────────────
+
+SimulatedFolderSource::SimulatedFolderSource(const FolderSourcePtr &source, const Latency &latency)
+    : m_source(source)
+    , m_latency(latency)
+    , m_slots(qMax(1, latency.maxConcurrent))
+{
+}
+
+QString SimulatedFolderSource::displayName() const
+{
+    return m_source->displayName();
+}
+
+bool SimulatedFolderSource::isReady() const
+{
+    return m_source->isReady();
+}
+
+QList<FolderEntry> SimulatedFolderSource::list() const
+{
+    QThread::msleep(m_latency.listMs);
+    return m_source->list();
+}
+
+QByteArray SimulatedFolderSource::read(const QString &fileName) const
+{
+    // Storage serves maxConcurrent reads; the rest queue up, like SAF does
+    m_slots.acquire();
+    QSemaphoreReleaser slot(m_slots);
+
+    QByteArray data = m_source->read(fileName);
+    qint64 ms = m_latency.readMs;
+    if (m_latency.bytesPerMs > 0)
+        ms += data.size() / m_latency.bytesPerMs;
+    QThread::msleep(ms);
+    return data;
+}
+
+bool SimulatedFolderSource::write(const QString &fileName, const QByteArray &data)
+{
+    m_slots.acquire();
+    QSemaphoreReleaser slot(m_slots);
+
+    qint64 ms = m_latency.readMs;
+    if (m_latency.bytesPerMs > 0)
+        ms += data.size() / m_latency.bytesPerMs;
+    QThread::msleep(ms);
+    return m_source->write(fileName, data);
+}
+
+bool SimulatedFolderSource::remove(const QString &fileName)
+{
+    m_slots.acquire();
+    QSemaphoreReleaser slot(m_slots);
+
+    QThread::msleep(m_latency.readMs);
+    return m_source->remove(fileName);
+}
@@ -0,0 +1,169 @@
+#ifndef FOLDERSOURCE_H
+#define FOLDERSOURCE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QEnableSharedFromThis>
+#include <QFuture>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSemaphore>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+
+class AndroidFolder;
+class QThreadPool;
+
+// One file in a flat folder, as returned by a listing
+struct FolderEntry {
+    QString name;
+    qint64 size = -1;        // -1 if the source does not know
+    QDateTime lastModified;  // Invalid if the source does not know
+};
+
+// A file read by FolderSource::readAsync(); data is empty if the read failed
+struct FolderFile {
+    QString name;
+    QByteArray data;
+};
+
+using FolderBatch = QList<FolderFile>;
+
+// A flat folder the gallery loads from: the local file system, a SAF tree
+// on Android, or a stand-in for either.
+//
+// Implementations provide blocking list()/read()/write(); they are called on
+// the I/O thread pool and must be thread-safe. listAsync() and readAsync()
+// keep the source alive until their futures finish, so sources are always
+// held in a FolderSourcePtr.
+class FolderSource : public QEnableSharedFromThis<FolderSource>
+{
+public:
+    virtual ~FolderSource() = default;
+
+    // Shown in status messages and remembered as the current folder
+    virtual QString displayName() const = 0;
+    virtual bool isReady() const = 0;
+
+    virtual QList<FolderEntry> list() const = 0;
+    virtual QByteArray read(const QString &fileName) const = 0;
+    virtual bool write(const QString &fileName, const QByteArray &data) = 0;
+    virtual bool remove(const QString &fileName) = 0;
+
+    // Path of the file on the local file system, or empty if it has none
+    virtual QString localPath(const QString &fileName) const;
+
+    // Listing on the I/O pool
+    QFuture<QList<FolderEntry>> listAsync() const;
+
+    // Reads the files in batches of batchSize. Batches are read concurrently
+    // up to the I/O pool size and reported as each completes, so they may
+    // arrive out of order. Canceling the future stops further batches.
+    QFuture<FolderBatch> readAsync(const QStringList &fileNames, int batchSize = 16) const;
+
+    // Threads used for listing and reading; separate from the global pool so
+    // slow storage does not hold up rendering. Default 4.
+    static QThreadPool *ioPool();
+    static void setMaxParallelReads(int count);
+};
+
+using FolderSourcePtr = QSharedPointer<FolderSource>;
+
+// A directory on the local file system
+class LocalFolderSource : public FolderSource
+{
+public:
+    explicit LocalFolderSource(const QString &path);
+
+    QString displayName() const override;
+    bool isReady() const override;
+
+    QList<FolderEntry> list() const override;
+    QByteArray read(const QString &fileName) const override;
+    bool write(const QString &fileName, const QByteArray &data) override;
+    bool remove(const QString &fileName) override;
+    QString localPath(const QString &fileName) const override;
+
+private:
+    QDir m_dir;
+};
+
+// Files held in memory: fixtures for benchmarks and for exercising the
+// loader without touching storage. write() updates the set.
+class MemoryFolderSource : public FolderSource
+{
+public:
+    explicit MemoryFolderSource(const QString &name = QStringLiteral("memory"),
+                                const QHash<QString, QByteArray> &files = {});
+
+    QString displayName() const override { return m_name; }
+    bool isReady() const override { return true; }
+
+    QList<FolderEntry> list() const override;
+    QByteArray read(const QString &fileName) const override;
+    bool write(const QString &fileName, const QByteArray &data) override;
+    bool remove(const QString &fileName) override;
+
+private:
+    QString m_name;
+    mutable QMutex m_mutex;
+    QHash<QString, QByteArray> m_files;
+    QHash<QString, QDateTime> m_modified;
+    QDateTime m_lastWrite;
+};
+
+// A SAF tree picked through AndroidFolder. AndroidFolder is not thread-safe
+// (its documentId cache is filled lazily), so calls are serialized.
+class AndroidFolderSource : public FolderSource
+{
+public:
+    explicit AndroidFolderSource(AndroidFolder *folder);
+
+    QString displayName() const override;
+    bool isReady() const override;
+
+    QList<FolderEntry> list() const override;
+    QByteArray read(const QString &fileName) const override;
+    bool write(const QString &fileName, const QByteArray &data) override;
+    bool remove(const QString &fileName) override;
+
+private:
+    AndroidFolder *m_folder;
+    mutable QMutex m_mutex;
+};
+
+// Wraps another source and adds the latency of slow storage (SAF over JNI,
+// network shares), so loading can be tested and benchmarked on a desktop.
+// Files never have a local path, just like on Android.
+class SimulatedFolderSource : public FolderSource
+{
+public:
+    struct Latency {
+        int listMs = 200;         // Per listing
+        int readMs = 15;          // Per file, before the first byte
+        int bytesPerMs = 2000;    // Transfer rate after that; 0 for unlimited
+        int maxConcurrent = 1;    // Reads the storage serves at once
+    };
+
+    SimulatedFolderSource(const FolderSourcePtr &source, const Latency &latency);
+
+    QString displayName() const override;
+    bool isReady() const override;
+
+    QList<FolderEntry> list() const override;
+    QByteArray read(const QString &fileName) const override;
+    bool write(const QString &fileName, const QByteArray &data) override;
+    bool remove(const QString &fileName) override;
+
+    const Latency &latency() const { return m_latency; }
+
+private:
+    FolderSourcePtr m_source;
+    Latency m_latency;
+    mutable QSemaphore m_slots; // maxConcurrent reads in flight
+};
+
+#endif // FOLDERSOURCE_H
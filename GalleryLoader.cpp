@@ -0,0 +1,178 @@
+#include "GalleryLoader.h"
+
+#include <QFileInfo>
+#include <QRegularExpression>
+
+GalleryLoader::GalleryLoader(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_listWatcher, &QFutureWatcherBase::finished, this, &GalleryLoader::onListed);
+    connect(&m_readWatcher, &QFutureWatcherBase::resultsReadyAt, this, &GalleryLoader::onBatchesReady);
+    connect(&m_readWatcher, &QFutureWatcherBase::finished, this, [this] {
+        // Results are all reported before finished; anything left means canceled
+        onBatchesReady();
+        if (m_running)
+            finish(m_readWatcher.isCanceled() || m_nextItem < m_items.size());
+    });
+}
+
+GalleryLoader::~GalleryLoader()
+{
+    // Pending batches keep the source alive by themselves; just stop them
+    m_listWatcher.cancel();
+    m_readWatcher.cancel();
+}
+
+QStringList GalleryLoader::matchingPngs(const QString &svgFile, const QStringList &pngFiles)
+{
+    QString baseName = QFileInfo(svgFile).completeBaseName();
+    QRegularExpression pngPattern(
+        QString("^%1(_\\d+)?\\.png$").arg(QRegularExpression::escape(baseName)));
+    QStringList result;
+    for (const QString &pngFile : pngFiles) {
+        if (pngPattern.match(pngFile).hasMatch())
+            result.append(pngFile);
+    }
+    return result;
+}
+
+QList<GalleryLoader::Item> GalleryLoader::itemsOf(const QList<FolderEntry> &entries)
+{
+    QStringList svgFiles, pngFiles;
+    for (const FolderEntry &entry : entries) {
+        if (entry.name.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive))
+            svgFiles.append(entry.name);
+        else if (entry.name.endsWith(QLatin1String(".png"), Qt::CaseInsensitive))
+            pngFiles.append(entry.name);
+    }
+    svgFiles.sort();
+    pngFiles.sort();
+
+    QList<Item> items;
+    items.reserve(svgFiles.size());
+    for (const QString &svgFile : std::as_const(svgFiles)) {
+        Item item;
+        item.svgFile = svgFile;
+        item.pngFiles = matchingPngs(svgFile, pngFiles);
+        items.append(item);
+    }
+    return items;
+}
+
+void GalleryLoader::start(const FolderSourcePtr &source, int batchSize)
+{
+    cancel();
+
+    m_source = source;
+    m_batchSize = batchSize;
+    m_running = true;
+    m_entries.clear();
+    m_items.clear();
+    m_data.clear();
+    m_nextItem = 0;
+    m_nextBatch = 0;
+    m_stats = Stats();
+    m_timer.start();
+
+    // setFuture() also drops signals still queued from the previous load
+    m_readWatcher.setFuture(QFuture<FolderBatch>());
+    m_listWatcher.setFuture(m_source->listAsync());
+}
+
+void GalleryLoader::cancel()
+{
+    if (!m_running)
+        return;
+
+    // Batches already being read finish in the background and are dropped
+    m_listWatcher.cancel();
+    m_readWatcher.cancel();
+    finish(true);
+}
+
+void GalleryLoader::onListed()
+{
+    if (!m_running || m_listWatcher.isCanceled())
+        return;
+    m_stats.listNs = m_timer.nsecsElapsed();
+
+    m_entries = m_listWatcher.result();
+    m_items = itemsOf(m_entries);
+
+    // Read item by item in listing order
+    QStringList toRead;
+    int pngCount = 0;
+    for (const Item &item : std::as_const(m_items)) {
+        pngCount += item.pngFiles.size();
+        toRead.append(item.svgFile);
+        toRead.append(item.pngFiles);
+    }
+
+    m_stats.svgCount = m_items.size();
+    m_stats.pngCount = pngCount;
+    emit listed(m_items.size(), pngCount);
+
+    // icon_16.png belongs to both icon.svg and icon_16.svg; read it once
+    toRead.removeDuplicates();
+
+    if (toRead.isEmpty()) {
+        finish(false);
+        return;
+    }
+    m_readWatcher.setFuture(m_source->readAsync(toRead, m_batchSize));
+}
+
+void GalleryLoader::onBatchesReady()
+{
+    if (!m_running)
+        return;
+
+    // Batches finish in any order; consume them in order so items come out sorted
+    QFuture<FolderBatch> future = m_readWatcher.future();
+    while (m_nextBatch < future.resultCount() && future.isResultReadyAt(m_nextBatch)) {
+        const FolderBatch batch = future.resultAt(m_nextBatch++);
+        for (const FolderFile &file : batch) {
+            m_data.insert(file.name, file.data);
+            m_stats.bytesRead += file.data.size();
+            ++m_stats.filesRead;
+        }
+    }
+    emitReadyItems();
+}
+
+void GalleryLoader::emitReadyItems()
+{
+    while (m_running && m_nextItem < m_items.size()) {
+        Item &item = m_items[m_nextItem];
+
+        if (!m_data.contains(item.svgFile))
+            return;
+        for (const QString &pngFile : item.pngFiles) {
+            if (!m_data.contains(pngFile))
+                return;
+        }
+
+        item.svgData = m_data.value(item.svgFile);
+        for (const QString &pngFile : item.pngFiles)
+            item.pngData.append(m_data.value(pngFile));
+
+        if (m_nextItem == 0)
+            m_stats.firstItemNs = m_timer.nsecsElapsed();
+        const int index = m_nextItem++;
+        emit itemLoaded(index, item);
+
+        // The receiver keeps what it needs
+        item.svgData.clear();
+        item.pngData.clear();
+    }
+}
+
+void GalleryLoader::finish(bool canceled)
+{
+    if (!m_running)
+        return;
+    m_running = false;
+    m_stats.totalNs = m_timer.nsecsElapsed();
+    m_data.clear();
+    emit finished(canceled);
+}
@@ -0,0 +1,87 @@
+#ifndef GALLERYLOADER_H
+#define GALLERYLOADER_H
+
+#include "FolderSource.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+// Lists a folder source and reads its SVGs with their matching PNGs off the
+// GUI thread. Reads run in batches ahead of the consumer, so creating the
+// gallery items overlaps with fetching the next files. Items carry the bytes;
+// nothing is copied to disk on the way to rendering.
+class GalleryLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    // One SVG with the PNGs named after it (icon.svg, icon.png, icon_48.png)
+    struct Item {
+        QString svgFile;
+        QStringList pngFiles;
+        QByteArray svgData;
+        QList<QByteArray> pngData; // Same order as pngFiles
+    };
+
+    struct Stats {
+        int svgCount = 0;
+        int pngCount = 0;
+        qint64 listNs = 0;      // Until the listing arrived
+        qint64 firstItemNs = 0; // Until the first item was ready
+        qint64 totalNs = 0;     // Until the last item was ready
+        qint64 bytesRead = 0;
+        int filesRead = 0;
+    };
+
+    explicit GalleryLoader(QObject *parent = nullptr);
+    ~GalleryLoader() override;
+
+    // Cancels a running load before starting
+    void start(const FolderSourcePtr &source, int batchSize = 16);
+    void cancel();
+    bool isRunning() const { return m_running; }
+
+    FolderSourcePtr source() const { return m_source; }
+    // Every file in the last listing, with its size and modification time
+    const QList<FolderEntry> &entries() const { return m_entries; }
+    const Stats &stats() const { return m_stats; }
+
+    // PNG file names that belong to svgFile
+    static QStringList matchingPngs(const QString &svgFile, const QStringList &pngFiles);
+    // The items of a listing in name order, without data
+    static QList<Item> itemsOf(const QList<FolderEntry> &entries);
+
+signals:
+    void listed(int svgCount, int pngCount);
+    // Emitted in listing order
+    void itemLoaded(int index, const GalleryLoader::Item &item);
+    void finished(bool canceled);
+
+private:
+    void onListed();
+    void onBatchesReady();
+    void emitReadyItems();
+    void finish(bool canceled);
+
+    FolderSourcePtr m_source;
+    int m_batchSize = 16;
+    bool m_running = false;
+    QFutureWatcher<QList<FolderEntry>> m_listWatcher;
+    QFutureWatcher<FolderBatch> m_readWatcher;
+
+    QList<FolderEntry> m_entries;
+    QList<Item> m_items;
+    int m_nextItem = 0;
+    int m_nextBatch = 0;
+    QHash<QString, QByteArray> m_data; // Read so far; a PNG can belong to two SVGs
+
+    QElapsedTimer m_timer;
+    Stats m_stats;
+};
+
+#endif // GALLERYLOADER_H
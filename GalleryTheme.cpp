@@ -0,0 +1,55 @@
+#include "GalleryTheme.h"
+
+#include <QCoreApplication>
+#include <QWidget>
+#include <QtMath>
+
+QList<GalleryTheme::Preset> GalleryTheme::presets()
+{
+    return {
+        {QCoreApplication::translate("GalleryTheme", "Native"), QColor(236, 236, 236)},
+        {QCoreApplication::translate("GalleryTheme", "Bright"), QColor(110, 110, 110)},
+        {QCoreApplication::translate("GalleryTheme", "Medium (Default)"), QColor(90, 90, 90)},
+        {QCoreApplication::translate("GalleryTheme", "Dark"), QColor(40, 40, 40)},
+    };
+}
+
+GalleryTheme::GalleryTheme(const QColor &background)
+{
+    setBackground(background);
+}
+
+void GalleryTheme::setBackground(const QColor &background)
+{
+    m_background = background;
+
+    // Calculate relative luminance using the formula from WCAG
+    // https://www.w3.org/TR/WCAG20/#relativeluminancedef
+    auto toLinear = [](qreal c) {
+        return c <= 0.03928 ? c / 12.92 : qPow((c + 0.055) / 1.055, 2.4);
+    };
+    qreal luminance = 0.2126 * toLinear(background.redF())
+                      + 0.7152 * toLinear(background.greenF())
+                      + 0.0722 * toLinear(background.blueF());
+    m_text = luminance > 0.5 ? Qt::black : Qt::white;
+}
+
+QPalette GalleryTheme::palette(const QPalette &base) const
+{
+    QColor dimmed = m_text;
+    dimmed.setAlpha(150);
+
+    QPalette palette = base;
+    palette.setColor(QPalette::Window, m_background);
+    palette.setColor(QPalette::WindowText, m_text);
+    palette.setColor(QPalette::PlaceholderText, dimmed);
+    palette.setColor(QPalette::AlternateBase, QColor(200, 200, 200, 30));
+    palette.setColor(QPalette::Mid, QColor(150, 150, 150, 50));
+    return palette;
+}
+
+void GalleryTheme::apply(QWidget *galleryWidget) const
+{
+    galleryWidget->setAutoFillBackground(true);
+    galleryWidget->setPalette(palette(galleryWidget->palette()));
+}
@@ -0,0 +1,41 @@
+#ifndef GALLERYTHEME_H
+#define GALLERYTHEME_H
+
+#include <QColor>
+#include <QList>
+#include <QPalette>
+#include <QString>
+
+class QWidget;
+
+// Colors of the gallery area, derived from its background color.
+// Applied as a single QPalette on the gallery widget; every item inherits it,
+// so switching presets needs no per-widget stylesheets or re-polishing.
+class GalleryTheme
+{
+public:
+    struct Preset {
+        QString name;
+        QColor background;
+    };
+
+    // Background presets offered in the toolbar and by the contact sheet export
+    static QList<Preset> presets();
+
+    explicit GalleryTheme(const QColor &background = QColor(90, 90, 90));
+
+    void setBackground(const QColor &background);
+    QColor background() const { return m_background; }
+    QColor text() const { return m_text; }
+
+    // Window: background, WindowText: text, PlaceholderText: dimmed text,
+    // AlternateBase/Mid: item fill and border
+    QPalette palette(const QPalette &base) const;
+    void apply(QWidget *galleryWidget) const;
+
+private:
+    QColor m_background;
+    QColor m_text;
+};
+
+#endif // GALLERYTHEME_H
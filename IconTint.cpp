@@ -0,0 +1,191 @@
+#include "IconTint.h"
+
+#include "PixmapCache.h"
+
+#include <QElapsedTimer>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ICONTINT_SSE2 1
+#endif
+
+namespace {
+
+// PixmapCache tags next to the backend's own renders, which use the bare
+// backend pointer; backends are heap objects, so the low bits are free
+enum LayerTag : quintptr {
+    WholeCoverage = 1,
+    CurrentColorCoverage = 2,
+    CurrentColorBase = 3
+};
+
+// c × m / 255, rounded, without a division
+inline uint scale(uint c, uint m)
+{
+    const uint v = c * m + 128;
+    return (v + (v >> 8)) >> 8;
+}
+
+// out = base + color × coverage for one row; base may be null
+void tintRow(const uchar *coverage, const quint32 *base, quint32 color, quint32 *out, int count, bool simd)
+{
+    int x = 0;
+#ifdef ICONTINT_SSE2
+    if (simd) {
+        // Four pixels at a time in 16-bit lanes; 255 × 255 fits, so scale()
+        // works unchanged
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i color16 = _mm_unpacklo_epi8(_mm_set1_epi32(int(color)), zero);
+        const __m128i bias = _mm_set1_epi16(128);
+        for (; x + 4 <= count; x += 4) {
+            quint32 four;
+            std::memcpy(&four, coverage + x, sizeof(four));
+            __m128i m = _mm_cvtsi32_si128(int(four));
+            m = _mm_unpacklo_epi8(m, m);
+            m = _mm_unpacklo_epi16(m, m); // Each coverage byte once per channel
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(m, zero), color16), bias);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(m, zero), color16), bias);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            __m128i pixels = _mm_packus_epi16(lo, hi);
+            if (base)
+                pixels = _mm_adds_epu8(pixels, _mm_loadu_si128(reinterpret_cast<const __m128i *>(base + x)));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), pixels);
+        }
+    }
+#else
+    Q_UNUSED(simd)
+#endif
+    for (; x < count; ++x) {
+        quint32 pixel = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            uint channel = scale((color >> shift) & 0xff, coverage[x]);
+            if (base)
+                channel = qMin(255u, channel + ((base[x] >> shift) & 0xff));
+            pixel |= quint32(channel) << shift;
+        }
+        out[x] = pixel;
+    }
+}
+
+// A backend render as premultiplied ARGB32, counted in the backend's stats
+QImage renderImage(RenderBackend *backend, SvgDocument &document, const QSize &size, qreal devicePixelRatio)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QPixmap pixmap = backend->render(document, size, devicePixelRatio);
+    ++backend->stats().renders;
+    backend->stats().renderNs += timer.nsecsElapsed();
+    if (pixmap.isNull())
+        return {};
+    return pixmap.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+} // namespace
+
+bool IconTint::simdAvailable()
+{
+#ifdef ICONTINT_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+QByteArray IconTint::substituteCurrentColor(const QByteArray &svg, const QColor &color)
+{
+    const QByteArray name = color.name(QColor::HexRgb).toLatin1();
+    QByteArray result = svg;
+    result.replace("currentColor", name);
+    result.replace("currentcolor", name);
+    return result;
+}
+
+IconTint::Layers IconTint::render(RenderBackend *backend, SvgDocument &document, const QSize &size, qreal devicePixelRatio, Mode mode)
+{
+    Layers layers;
+    if (mode == Whole) {
+        const QImage image = renderImage(backend, document, size, devicePixelRatio);
+        if (!image.isNull())
+            layers.coverage = image.convertToFormat(QImage::Format_Alpha8);
+        return layers;
+    }
+    if (mode != CurrentColor)
+        return layers;
+
+    // What currentColor adds to a channel is the white render minus the
+    // black one; everything else is in the black render already
+    SvgDocument black(document.path(), substituteCurrentColor(document.data(), Qt::black));
+    SvgDocument white(document.path(), substituteCurrentColor(document.data(), Qt::white));
+    const QImage base = renderImage(backend, black, size, devicePixelRatio);
+    const QImage full = renderImage(backend, white, size, devicePixelRatio);
+    if (base.isNull() || base.size() != full.size())
+        return layers;
+
+    QImage coverage(base.size(), QImage::Format_Alpha8);
+    coverage.setDevicePixelRatio(base.devicePixelRatio());
+    for (int y = 0; y < base.height(); ++y) {
+        const auto *b = reinterpret_cast<const QRgb *>(base.constScanLine(y));
+        const auto *w = reinterpret_cast<const QRgb *>(full.constScanLine(y));
+        uchar *m = coverage.scanLine(y);
+        for (int x = 0; x < base.width(); ++x)
+            m[x] = uchar(qMax(0, qGreen(w[x]) - qGreen(b[x])));
+    }
+    layers.base = base;
+    layers.coverage = coverage;
+    return layers;
+}
+
+QImage IconTint::composite(const Layers &layers, const QColor &color, bool simd)
+{
+    if (layers.isNull())
+        return {};
+
+    // With a base, currentColor was painted opaque and the base carries its
+    // alpha; only the color channels are added
+    const bool hasBase = !layers.base.isNull();
+    const QRgb premultiplied = hasBase ? qRgba(color.red(), color.green(), color.blue(), 0) : qPremultiply(color.rgba());
+
+    QImage result(layers.coverage.size(), QImage::Format_ARGB32_Premultiplied);
+    result.setDevicePixelRatio(layers.coverage.devicePixelRatio());
+    for (int y = 0; y < result.height(); ++y) {
+        tintRow(layers.coverage.constScanLine(y),
+                hasBase ? reinterpret_cast<const quint32 *>(layers.base.constScanLine(y)) : nullptr,
+                premultiplied, reinterpret_cast<quint32 *>(result.scanLine(y)), result.width(), simd);
+    }
+    return result;
+}
+
+QPixmap IconTint::pixmap(RenderBackend *backend, SvgDocument &document, const QSize &size, qreal devicePixelRatio,
+                         QIcon::Mode iconMode, Mode mode, const QColor &color)
+{
+    if (mode == Off || (mode == CurrentColor && !document.content()->usesCurrentColor()))
+        return {};
+
+    // Layers belong to the content, like its renders, and go with it
+    PixmapCache &cache = PixmapCache::instance();
+    const quint64 owner = document.content()->cacheOwner();
+    const quint64 spec = PixmapCache::spec(size, devicePixelRatio, QIcon::Normal);
+    const PixmapCache::Key coverageKey{owner, quintptr(backend) | (mode == Whole ? WholeCoverage : CurrentColorCoverage), spec};
+    const PixmapCache::Key baseKey{owner, quintptr(backend) | CurrentColorBase, spec};
+
+    Layers layers;
+    layers.coverage = cache.findImage(coverageKey);
+    if (mode == CurrentColor && !layers.isNull())
+        layers.base = cache.findImage(baseKey);
+    if (layers.isNull() || (mode == CurrentColor && layers.base.isNull())) {
+        layers = render(backend, document, size, devicePixelRatio, mode);
+        if (layers.isNull())
+            return {};
+        cache.insertImage(coverageKey, layers.coverage);
+        if (!layers.base.isNull())
+            cache.insertImage(baseKey, layers.base);
+    }
+
+    QPixmap pixmap = QPixmap::fromImage(composite(layers, color));
+    if (iconMode != QIcon::Normal)
+        pixmap = QIcon(pixmap).pixmap(size, devicePixelRatio, iconMode);
+    return pixmap;
+}
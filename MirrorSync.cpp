@@ -0,0 +1,248 @@
+#include "MirrorSync.h"
+
+#include "ContentHash.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStandardPaths>
+
+namespace {
+
+constexpr int kManifestVersion = 1;
+
+qint64 msecs(const QDateTime &time)
+{
+    return time.isValid() ? time.toMSecsSinceEpoch() : -1;
+}
+
+} // namespace
+
+QString MirrorSync::Result::summary() const
+{
+    QString text = QString("%1 added, %2 updated, %3 removed, %4 unchanged, %5 bytes transferred")
+                       .arg(added).arg(updated).arg(removed).arg(unchanged).arg(bytesTransferred);
+    if (failed)
+        text += QString(", %1 failed").arg(failed);
+    return text;
+}
+
+MirrorSync::MirrorSync(const FolderSourcePtr &remote, const FolderSourcePtr &mirror)
+    : m_remote(remote)
+    , m_mirror(mirror)
+{
+}
+
+QString MirrorSync::mirrorDirectory(const QString &key)
+{
+    const QString path = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                         + QLatin1String("/mirrors/")
+                         + QString::number(contentHash(key.toUtf8()), 16).rightJustified(16, QLatin1Char('0'));
+    QDir().mkpath(path);
+    return path;
+}
+
+bool MirrorSync::loadManifest()
+{
+    m_manifest.clear();
+    const QByteArray data = m_mirror->read(QLatin1String(kManifestName));
+    if (data.isEmpty())
+        return false;
+
+    const QJsonObject root = QJsonDocument::fromJson(data).object();
+    if (root.value(QLatin1String("version")).toInt() != kManifestVersion)
+        return false;
+
+    const QJsonObject files = root.value(QLatin1String("files")).toObject();
+    for (auto it = files.begin(); it != files.end(); ++it) {
+        const QJsonObject file = it.value().toObject();
+        ManifestEntry entry;
+        entry.size = file.value(QLatin1String("size")).toInteger(-1);
+        entry.lastModified = file.value(QLatin1String("modified")).toInteger(-1);
+        m_manifest.insert(it.key(), entry);
+    }
+    return true;
+}
+
+void MirrorSync::ensureManifest()
+{
+    // A missing or unreadable manifest means the mirror is untrusted:
+    // everything is transferred again
+    if (!m_manifestLoaded) {
+        loadManifest();
+        m_manifestLoaded = true;
+    }
+}
+
+bool MirrorSync::saveManifest() const
+{
+    QJsonObject files;
+    for (auto it = m_manifest.cbegin(); it != m_manifest.cend(); ++it) {
+        QJsonObject file;
+        file.insert(QLatin1String("size"), it->size);
+        file.insert(QLatin1String("modified"), it->lastModified);
+        files.insert(it.key(), file);
+    }
+    QJsonObject root;
+    root.insert(QLatin1String("version"), kManifestVersion);
+    root.insert(QLatin1String("files"), files);
+    return m_mirror->write(QLatin1String(kManifestName), QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
+
+void MirrorSync::invalidate(const QString &fileName)
+{
+    QMutexLocker locker(&m_mutex);
+    ensureManifest();
+    if (m_manifest.remove(fileName))
+        saveManifest();
+}
+
+MirrorSync::Result MirrorSync::sync()
+{
+    QMutexLocker locker(&m_mutex);
+    Result result;
+
+    ensureManifest();
+
+    const QList<FolderEntry> remote = m_remote->list();
+    if (remote.isEmpty() && !m_remote->isReady()) {
+        result.error = QLatin1String("Remote folder is not accessible");
+        return result;
+    }
+
+    // What the mirror actually holds; a file deleted behind our back is fetched again
+    QSet<QString> mirrored;
+    for (const FolderEntry &entry : m_mirror->list())
+        mirrored.insert(entry.name);
+
+    QSet<QString> seen;
+    for (const FolderEntry &entry : remote) {
+        if (entry.name == QLatin1String(kManifestName))
+            continue;
+        seen.insert(entry.name);
+
+        // Without size and time the provider gives no way to detect changes
+        const qint64 lastModified = msecs(entry.lastModified);
+        const bool known = entry.size >= 0 && lastModified >= 0;
+        auto it = m_manifest.constFind(entry.name);
+        if (known && it != m_manifest.constEnd() && mirrored.contains(entry.name)
+            && it->size == entry.size && it->lastModified == lastModified) {
+            ++result.unchanged;
+            continue;
+        }
+
+        const bool isNew = !mirrored.contains(entry.name);
+        const QByteArray data = m_remote->read(entry.name);
+        if ((data.isEmpty() && entry.size != 0) || !m_mirror->write(entry.name, data)) {
+            ++result.failed;
+            m_manifest.remove(entry.name);
+            continue;
+        }
+        result.bytesTransferred += data.size();
+        if (isNew)
+            ++result.added;
+        else
+            ++result.updated;
+
+        if (known)
+            m_manifest.insert(entry.name, ManifestEntry{entry.size, lastModified});
+        else
+            m_manifest.remove(entry.name); // Transferred again next time
+    }
+
+    // Gone from the remote: drop from the mirror too
+    for (const QString &name : mirrored) {
+        if (name == QLatin1String(kManifestName) || seen.contains(name))
+            continue;
+        if (m_mirror->remove(name))
+            ++result.removed;
+        else
+            ++result.failed;
+        m_manifest.remove(name);
+    }
+    for (auto it = m_manifest.begin(); it != m_manifest.end();) {
+        if (seen.contains(it.key()))
+            ++it;
+        else
+            it = m_manifest.erase(it);
+    }
+
+    result.ok = saveManifest();
+    if (!result.ok)
+        result.error = QLatin1String("Cannot write the mirror manifest");
+    return result;
+}
+
+// ── MirroredFolderSource ───────────────────────────────────────
+
+MirroredFolderSource::MirroredFolderSource(const FolderSourcePtr &remote, const FolderSourcePtr &mirror)
+    : m_remote(remote)
+    , m_mirror(mirror)
+    , m_sync(remote, mirror)
+{
+}
+
+QString MirroredFolderSource::displayName() const
+{
+    return m_remote->displayName();
+}
+
+bool MirroredFolderSource::isReady() const
+{
+    return m_remote->isReady();
+}
+
+QList<FolderEntry> MirroredFolderSource::list() const
+{
+    const MirrorSync::Result result = m_sync.sync();
+    qDebug() << "Mirror sync" << displayName() << result.summary() << result.error;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_lastSync = result;
+    }
+
+    QList<FolderEntry> entries = m_mirror->list();
+    entries.removeIf([](const FolderEntry &entry) {
+        return entry.name == QLatin1String(MirrorSync::kManifestName);
+    });
+    return entries;
+}
+
+QByteArray MirroredFolderSource::read(const QString &fileName) const
+{
+    return m_mirror->read(fileName);
+}
+
+bool MirroredFolderSource::write(const QString &fileName, const QByteArray &data)
+{
+    if (!m_remote->write(fileName, data))
+        return false;
+
+    // The remote's new size and time are unknown until the next listing
+    m_mirror->write(fileName, data);
+    m_sync.invalidate(fileName);
+    return true;
+}
+
+bool MirroredFolderSource::remove(const QString &fileName)
+{
+    if (!m_remote->remove(fileName))
+        return false;
+    m_mirror->remove(fileName);
+    m_sync.invalidate(fileName);
+    return true;
+}
+
+QString MirroredFolderSource::localPath(const QString &fileName) const
+{
+    return m_mirror->localPath(fileName);
+}
+
+MirrorSync::Result MirroredFolderSource::lastSync() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastSync;
+}
@@ -0,0 +1,90 @@
+#ifndef MIRRORSYNC_H
+#define MIRRORSYNC_H
+
+#include "FolderSource.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+// Keeps a mirror folder in step with a remote one (a SAF tree) across
+// sessions. A manifest in the mirror records the remote size and
+// modification time of every mirrored file; only files whose metadata
+// changed are transferred, and files gone from the remote are deleted.
+//
+// Both ends are FolderSources, so the sync can run against in-memory
+// fakes and its transfer counts can be checked without a device.
+class MirrorSync
+{
+public:
+    struct Result {
+        bool ok = false;
+        QString error;
+        int added = 0;
+        int updated = 0;
+        int removed = 0;
+        int unchanged = 0;
+        int failed = 0;
+        qint64 bytesTransferred = 0;
+
+        int transferred() const { return added + updated; }
+        QString summary() const;
+    };
+
+    static constexpr const char *kManifestName = ".mirror-manifest.json";
+
+    MirrorSync(const FolderSourcePtr &remote, const FolderSourcePtr &mirror);
+
+    // Blocking; call on the I/O pool
+    Result sync();
+
+    // Forgets what is known about fileName, so the next sync transfers it again
+    void invalidate(const QString &fileName);
+
+    // CacheLocation/mirrors/<hash of key>, created if needed
+    static QString mirrorDirectory(const QString &key);
+
+private:
+    struct ManifestEntry {
+        qint64 size = -1;
+        qint64 lastModified = -1; // ms since epoch
+    };
+
+    bool loadManifest();
+    void ensureManifest();
+    bool saveManifest() const;
+
+    FolderSourcePtr m_remote;
+    FolderSourcePtr m_mirror;
+    QHash<QString, ManifestEntry> m_manifest;
+    bool m_manifestLoaded = false;
+    QMutex m_mutex;
+};
+
+// Serves a remote folder from its local mirror. Listing syncs first, so a
+// load only transfers what changed since the last one; writes go to both.
+class MirroredFolderSource : public FolderSource
+{
+public:
+    MirroredFolderSource(const FolderSourcePtr &remote, const FolderSourcePtr &mirror);
+
+    QString displayName() const override;
+    bool isReady() const override;
+
+    QList<FolderEntry> list() const override;
+    QByteArray read(const QString &fileName) const override;
+    bool write(const QString &fileName, const QByteArray &data) override;
+    bool remove(const QString &fileName) override;
+    QString localPath(const QString &fileName) const override;
+
+    MirrorSync::Result lastSync() const;
+
+private:
+    FolderSourcePtr m_remote;
+    FolderSourcePtr m_mirror;
+    mutable MirrorSync m_sync;
+    mutable QMutex m_mutex;
+    mutable MirrorSync::Result m_lastSync;
+};
+
+#endif // MIRRORSYNC_H
@@ -0,0 +1,144 @@
+#include "PixmapCache.h"
+
+#include <QAtomicInteger>
+#include <QLocale>
+
+namespace {
+
+// Keys listed per owner before evicted ones are pruned from the list
+constexpr int kOwnerKeysPruneAt = 32;
+
+} // namespace
+
+QString PixmapCache::Stats::summary() const
+{
+    const QLocale locale;
+    return QString("Pixmaps: %1 / %2 (%3) · %4 hits · %5 misses · %6 evicted")
+        .arg(locale.formattedDataSize(bytes), locale.formattedDataSize(budget))
+        .arg(count)
+        .arg(hits)
+        .arg(misses)
+        .arg(evictions);
+}
+
+PixmapCache::PixmapCache()
+{
+    m_cache.setMaxCost(kDefaultBudget);
+}
+
+PixmapCache &PixmapCache::instance()
+{
+    static PixmapCache cache;
+    return cache;
+}
+
+quint64 PixmapCache::newOwner()
+{
+    static QAtomicInteger<quint64> next = 0;
+    return ++next;
+}
+
+quint64 PixmapCache::spec(const QSize &size, qreal devicePixelRatio, QIcon::Mode mode, QIcon::State state)
+{
+    // Ratio in 1/100 steps, so 1.25 and 1.5 get their own entries
+    const quint64 ratio = quint64(qRound(devicePixelRatio * 100)) & 0xffff;
+    return (quint64(size.width() & 0xffff) << 48) | (quint64(size.height() & 0xffff) << 32)
+           | (ratio << 16) | (quint64(mode) << 1) | quint64(state);
+}
+
+QPixmap PixmapCache::find(const Key &key)
+{
+    const Entry *entry = lookup(key);
+    return entry ? entry->pixmap : QPixmap();
+}
+
+void PixmapCache::insert(const Key &key, const QPixmap &pixmap)
+{
+    const qint64 bytes = qint64(pixmap.width()) * pixmap.height() * qMax(1, pixmap.depth()) / 8;
+    insertEntry(key, new Entry{pixmap, QImage()}, bytes);
+}
+
+QImage PixmapCache::findImage(const Key &key)
+{
+    const Entry *entry = lookup(key);
+    return entry ? entry->image : QImage();
+}
+
+void PixmapCache::insertImage(const Key &key, const QImage &image)
+{
+    insertEntry(key, new Entry{QPixmap(), image}, image.sizeInBytes());
+}
+
+const PixmapCache::Entry *PixmapCache::lookup(const Key &key)
+{
+    if (const Entry *entry = m_cache.object(key)) {
+        ++m_hits;
+        return entry;
+    }
+    ++m_misses;
+    return nullptr;
+}
+
+void PixmapCache::insertEntry(const Key &key, Entry *entry, qint64 bytes)
+{
+    ++m_inserted;
+    // The entry it replaces is removed, not evicted, and its key is listed
+    // for the owner already
+    const bool replacing = m_cache.contains(key);
+    if (replacing)
+        ++m_removed;
+
+    // Evicts from the least recently used end until the entry fits; one
+    // larger than the whole budget is dropped right away
+    if (!m_cache.insert(key, entry, qMax<qint64>(1, bytes)) || replacing)
+        return;
+
+    QList<Key> &keys = m_ownerKeys[key.owner];
+    if (keys.size() >= kOwnerKeysPruneAt) {
+        keys.removeIf([this](const Key &listed) {
+            return !m_cache.contains(listed);
+        });
+    }
+    keys.append(key);
+}
+
+void PixmapCache::removeOwner(quint64 owner)
+{
+    for (const Key &key : m_ownerKeys.take(owner)) {
+        if (m_cache.remove(key))
+            ++m_removed;
+    }
+}
+
+void PixmapCache::clear()
+{
+    m_removed += m_cache.count();
+    m_cache.clear();
+    m_ownerKeys.clear();
+}
+
+void PixmapCache::setBudget(qint64 bytes)
+{
+    m_cache.setMaxCost(qMax<qint64>(1, bytes));
+}
+
+PixmapCache::Stats PixmapCache::stats() const
+{
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.count = int(m_cache.count());
+    // Whatever went in and is neither there nor explicitly removed was evicted
+    stats.evictions = m_inserted - m_removed - stats.count;
+    stats.bytes = m_cache.totalCost();
+    stats.budget = m_cache.maxCost();
+    return stats;
+}
+
+void PixmapCache::resetStats()
+{
+    m_hits = 0;
+    m_misses = 0;
+    m_inserted = m_cache.count();
+    m_removed = 0;
+}
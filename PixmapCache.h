@@ -0,0 +1,91 @@
+#ifndef PIXMAPCACHE_H
+#define PIXMAPCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QList>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+// Every raster the gallery shows, SVG renders and decoded PNGs alike, under
+// one byte budget. Images that are read back on the CPU rather than drawn
+// (tint masks, see IconTint) are kept as QImage under the same budget.
+// Least recently used pixmaps go first; painting looks pixmaps up again
+// each time, so what is on screen stays and what was scrolled away is
+// evicted. Owners (an SVG's content, a gallery item's PNGs) drop their
+// pixmaps when they go away. GUI thread only, like QPixmap.
+class PixmapCache
+{
+public:
+    struct Key {
+        quint64 owner = 0; // From newOwner(); never reused
+        quint64 tag = 0;   // Owner-defined: render backend, PNG index
+        quint64 spec = 0;  // From spec()
+
+        friend bool operator==(const Key &a, const Key &b)
+        {
+            return a.owner == b.owner && a.tag == b.tag && a.spec == b.spec;
+        }
+        friend size_t qHash(const Key &key, size_t seed = 0)
+        {
+            return qHashMulti(seed, key.owner, key.tag, key.spec);
+        }
+    };
+
+    struct Stats {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+        qint64 bytes = 0;  // Resident in the cache
+        qint64 budget = 0;
+        int count = 0;
+
+        QString summary() const;
+    };
+
+    static constexpr qint64 kDefaultBudget = 64 * 1024 * 1024;
+
+    static PixmapCache &instance();
+
+    static quint64 newOwner();
+    // Packs a request the way QIconEngine::scaledPixmap() gets it
+    static quint64 spec(const QSize &size, qreal devicePixelRatio, QIcon::Mode mode, QIcon::State state = QIcon::Off);
+
+    // Counts a hit or a miss; a miss returns a null pixmap
+    QPixmap find(const Key &key);
+    void insert(const Key &key, const QPixmap &pixmap);
+    QImage findImage(const Key &key);
+    void insertImage(const Key &key, const QImage &image);
+    void removeOwner(quint64 owner);
+    void clear();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return m_cache.maxCost(); }
+
+    Stats stats() const;
+    void resetStats();
+
+private:
+    // One of the two is set
+    struct Entry {
+        QPixmap pixmap;
+        QImage image;
+    };
+
+    PixmapCache();
+
+    const Entry *lookup(const Key &key);
+    void insertEntry(const Key &key, Entry *entry, qint64 bytes);
+
+    QCache<Key, Entry> m_cache;
+    QHash<quint64, QList<Key>> m_ownerKeys; // May list keys already evicted
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+    qint64 m_inserted = 0;
+    qint64 m_removed = 0; // By owners or clear(), not evictions
+};
+
+#endif // PIXMAPCACHE_H
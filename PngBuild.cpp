@@ -0,0 +1,479 @@
+#include "PngBuild.h"
+
+#include "ContentHash.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSvgRenderer>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtEndian>
+
+#if __has_include(<QtZlib/zlib.h>)
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int kManifestVersion = 1;
+
+// Small icons gain little from harder deflate; the optimizing pass pays for it
+constexpr int kFastLevel = 1;
+constexpr int kOptimizedLevel = Z_BEST_COMPRESSION;
+
+enum ColorType : char {
+    Truecolor = 2,
+    Indexed = 3,
+    TruecolorAlpha = 6
+};
+
+qint64 msecs(const QDateTime &time)
+{
+    return time.isValid() ? time.toMSecsSinceEpoch() : -1;
+}
+
+QImage renderAt(QSvgRenderer &renderer, int size)
+{
+    QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    renderer.render(&painter, QRectF(0, 0, size, size));
+    painter.end();
+    return image.convertToFormat(QImage::Format_ARGB32);
+}
+
+// Unfiltered rows, back to back; palette maps colors to indices if given
+QByteArray rawRows(const QImage &image, ColorType type, const QHash<QRgb, int> &palette)
+{
+    const int channels = type == Indexed ? 1 : type == Truecolor ? 3 : 4;
+    QByteArray rows(qsizetype(image.width()) * image.height() * channels, Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar *>(rows.data());
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (type == Indexed) {
+                *out++ = uchar(palette.value(pixels[x]));
+                continue;
+            }
+            *out++ = uchar(qRed(pixels[x]));
+            *out++ = uchar(qGreen(pixels[x]));
+            *out++ = uchar(qBlue(pixels[x]));
+            if (type == TruecolorAlpha)
+                *out++ = uchar(qAlpha(pixels[x]));
+        }
+    }
+    return rows;
+}
+
+bool isOpaque(const QImage &image)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAlpha(pixels[x]) != 255)
+                return false;
+        }
+    }
+    return true;
+}
+
+uchar paeth(int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs(p - a);
+    const int pb = std::abs(p - b);
+    const int pc = std::abs(p - c);
+    return uchar(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+// Prefixes every row with its filter type. Adaptive picks, per row, the
+// filter whose output has the smallest sum of magnitudes, the heuristic
+// libpng uses; otherwise every row is left unfiltered.
+QByteArray filterRows(const QByteArray &rows, int stride, int bytesPerPixel, bool adaptive)
+{
+    const int height = stride ? int(rows.size() / stride) : 0;
+    QByteArray result;
+    result.reserve(rows.size() + height);
+    const QByteArray zero(stride, '\0');
+    QByteArray candidate(stride, Qt::Uninitialized);
+    QByteArray best(stride, Qt::Uninitialized);
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *row = reinterpret_cast<const uchar *>(rows.constData()) + qsizetype(y) * stride;
+        if (!adaptive) {
+            result.append('\0');
+            result.append(reinterpret_cast<const char *>(row), stride);
+            continue;
+        }
+        const uchar *prior = y > 0 ? row - stride : reinterpret_cast<const uchar *>(zero.constData());
+        uchar *out = reinterpret_cast<uchar *>(candidate.data());
+        char bestType = 0;
+        quint64 bestSum = std::numeric_limits<quint64>::max();
+        for (char type = 0; type <= 4; ++type) {
+            quint64 sum = 0;
+            for (int i = 0; i < stride; ++i) {
+                const int a = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+                const int b = prior[i];
+                const int c = i >= bytesPerPixel ? prior[i - bytesPerPixel] : 0;
+                int predicted = 0;
+                switch (type) {
+                case 1: predicted = a; break;
+                case 2: predicted = b; break;
+                case 3: predicted = (a + b) / 2; break;
+                case 4: predicted = paeth(a, b, c); break;
+                }
+                out[i] = uchar(row[i] - predicted);
+                sum += std::abs(int(qint8(out[i])));
+            }
+            if (sum < bestSum) {
+                bestSum = sum;
+                bestType = type;
+                std::memcpy(best.data(), candidate.constData(), stride);
+            }
+        }
+        result.append(bestType);
+        result.append(best);
+    }
+    return result;
+}
+
+void appendChunk(QByteArray &png, const char *type, QByteArrayView data)
+{
+    char length[4];
+    qToBigEndian<quint32>(quint32(data.size()), length);
+    png.append(length, 4);
+    const qsizetype start = png.size();
+    png.append(type, 4);
+    png.append(data.data(), data.size());
+    const uLong crc = crc32(0, reinterpret_cast<const Bytef *>(png.constData() + start), uInt(png.size() - start));
+    char checksum[4];
+    qToBigEndian<quint32>(quint32(crc), checksum);
+    png.append(checksum, 4);
+}
+
+QByteArray pngFile(const QSize &size, ColorType type, const QByteArray &filtered, int level,
+                   const QByteArray &palette = {}, const QByteArray &transparency = {})
+{
+    uLongf compressedSize = compressBound(uLong(filtered.size()));
+    QByteArray compressed(qsizetype(compressedSize), Qt::Uninitialized);
+    if (compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressedSize,
+                  reinterpret_cast<const Bytef *>(filtered.constData()), uLong(filtered.size()), level) != Z_OK)
+        return {};
+    compressed.resize(qsizetype(compressedSize));
+
+    char header[13] = {};
+    qToBigEndian<quint32>(quint32(size.width()), header);
+    qToBigEndian<quint32>(quint32(size.height()), header + 4);
+    header[8] = 8; // Bits per channel or index
+    header[9] = type;
+
+    QByteArray png("\x89PNG\r\n\x1a\n", 8);
+    png.reserve(png.size() + compressed.size() + palette.size() + transparency.size() + 64);
+    appendChunk(png, "IHDR", QByteArrayView(header, sizeof(header)));
+    if (!palette.isEmpty())
+        appendChunk(png, "PLTE", palette);
+    if (!transparency.isEmpty())
+        appendChunk(png, "tRNS", transparency);
+    appendChunk(png, "IDAT", compressed);
+    appendChunk(png, "IEND", QByteArrayView());
+    return png;
+}
+
+// Every color of the image, or an empty list past 256
+QList<QRgb> colorsOf(const QImage &image)
+{
+    QSet<QRgb> colors;
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *pixels = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            colors.insert(pixels[x]);
+            if (colors.size() > 256)
+                return {};
+        }
+    }
+    return QList<QRgb>(colors.cbegin(), colors.cend());
+}
+
+QByteArray indexedPng(const QImage &image, QList<QRgb> colors)
+{
+    // Translucent entries first, so tRNS stops at the last of them
+    std::sort(colors.begin(), colors.end(), [](QRgb a, QRgb b) {
+        return qAlpha(a) != qAlpha(b) ? qAlpha(a) < qAlpha(b) : a < b;
+    });
+    QHash<QRgb, int> indices;
+    QByteArray palette;
+    QByteArray transparency;
+    for (int i = 0; i < colors.size(); ++i) {
+        indices.insert(colors[i], i);
+        palette.append(char(qRed(colors[i])));
+        palette.append(char(qGreen(colors[i])));
+        palette.append(char(qBlue(colors[i])));
+        if (qAlpha(colors[i]) < 255)
+            transparency.append(char(qAlpha(colors[i])));
+    }
+    // Indices are not magnitudes; filtering them rarely helps
+    const QByteArray rows = filterRows(rawRows(image, Indexed, indices), image.width(), 1, false);
+    return pngFile(image.size(), Indexed, rows, kOptimizedLevel, palette, transparency);
+}
+
+} // namespace
+
+QString PngBuild::Result::summary() const
+{
+    QString text = QString("%1 built, %2 unchanged, %3 removed, %4 PNG(s) written, %5 bytes")
+                       .arg(built).arg(unchanged).arg(removed).arg(pngsWritten).arg(bytesWritten);
+    if (failed)
+        text += QString(", %1 failed").arg(failed);
+    return text;
+}
+
+PngBuild::PngBuild(const FolderSourcePtr &source, const FolderSourcePtr &output, const Options &options)
+    : m_source(source)
+    , m_output(output)
+    , m_options(options)
+{
+}
+
+QString PngBuild::pngName(const QString &svgFile, int size)
+{
+    // completeBaseName() without a QFileInfo; called for every file on every build
+    const qsizetype dot = svgFile.lastIndexOf(QLatin1Char('.'));
+    return QString("%1_%2.png").arg(dot < 0 ? svgFile : svgFile.left(dot)).arg(size);
+}
+
+QList<int> PngBuild::parseSizes(const QString &text)
+{
+    static const QRegularExpression separator(QStringLiteral("[,;\\s]+"));
+    QList<int> sizes;
+    for (const QString &part : text.split(separator, Qt::SkipEmptyParts)) {
+        const int size = part.toInt();
+        if (size >= 8 && size <= 1024 && !sizes.contains(size))
+            sizes.append(size);
+    }
+    return sizes;
+}
+
+QByteArray PngBuild::encode(const QImage &image, bool optimize)
+{
+    const QImage pixels = image.convertToFormat(QImage::Format_ARGB32);
+    const ColorType type = isOpaque(pixels) ? Truecolor : TruecolorAlpha;
+    const int bytesPerPixel = type == Truecolor ? 3 : 4;
+    const QByteArray rows = rawRows(pixels, type, {});
+    const int stride = pixels.width() * bytesPerPixel;
+
+    QByteArray png = pngFile(pixels.size(), type, filterRows(rows, stride, bytesPerPixel, false), kFastLevel);
+    if (!optimize)
+        return png;
+
+    // Lossless either way; the smallest of the candidates wins
+    const QByteArray filtered = pngFile(pixels.size(), type, filterRows(rows, stride, bytesPerPixel, true), kOptimizedLevel);
+    if (!filtered.isEmpty() && filtered.size() < png.size())
+        png = filtered;
+    const QList<QRgb> colors = colorsOf(pixels);
+    if (!colors.isEmpty()) {
+        const QByteArray indexed = indexedPng(pixels, colors);
+        if (!indexed.isEmpty() && indexed.size() < png.size())
+            png = indexed;
+    }
+    return png;
+}
+
+QString PngBuild::settingsKey() const
+{
+    QStringList sizes;
+    for (int size : m_options.sizes)
+        sizes.append(QString::number(size));
+    return QString("sizes=%1 optimize=%2").arg(sizes.join(QLatin1Char(','))).arg(int(m_options.optimize));
+}
+
+void PngBuild::loadManifest()
+{
+    m_manifest.clear();
+    m_manifestSizes.clear();
+    m_manifestCurrent = false;
+    const QByteArray data = m_output->read(QLatin1String(kManifestName));
+    if (data.isEmpty())
+        return;
+
+    const QJsonObject root = QJsonDocument::fromJson(data).object();
+    if (root.value(QLatin1String("version")).toInt() != kManifestVersion)
+        return;
+
+    m_manifestCurrent = root.value(QLatin1String("settings")).toString() == settingsKey();
+    for (const QJsonValue &size : root.value(QLatin1String("sizes")).toArray())
+        m_manifestSizes.append(size.toInt());
+    const QJsonObject files = root.value(QLatin1String("files")).toObject();
+    for (auto it = files.begin(); it != files.end(); ++it) {
+        // Hashes are hex strings; JSON numbers are doubles
+        const QJsonArray file = it.value().toArray();
+        ManifestEntry entry;
+        entry.hash = file.at(0).toString().toULongLong(nullptr, 16);
+        entry.size = file.at(1).toInteger(-1);
+        entry.lastModified = file.at(2).toInteger(-1);
+        m_manifest.insert(it.key(), entry);
+    }
+}
+
+bool PngBuild::saveManifest() const
+{
+    // An array per file keeps the manifest of a large set small to parse
+    QJsonObject files;
+    for (auto it = m_manifest.cbegin(); it != m_manifest.cend(); ++it)
+        files.insert(it.key(), QJsonArray{QString::number(it->hash, 16), it->size, it->lastModified});
+    QJsonArray sizes;
+    for (int size : m_manifestSizes)
+        sizes.append(size);
+    QJsonObject root;
+    root.insert(QLatin1String("version"), kManifestVersion);
+    root.insert(QLatin1String("settings"), settingsKey());
+    root.insert(QLatin1String("sizes"), sizes);
+    root.insert(QLatin1String("files"), files);
+    return m_output->write(QLatin1String(kManifestName), QJsonDocument(root).toJson(QJsonDocument::Compact));
+}
+
+PngBuild::Built PngBuild::build(const Pending &pending) const
+{
+    Built result;
+    result.svgFile = pending.svg.name;
+    result.entry.size = pending.svg.size;
+    result.entry.lastModified = msecs(pending.svg.lastModified);
+
+    const QByteArray data = m_source->read(pending.svg.name);
+    if (data.isEmpty())
+        return result;
+    result.entry.hash = contentHash(data);
+    if (pending.reusable && pending.builtFrom == result.entry.hash) {
+        // Touched, not changed
+        result.ok = true;
+        return result;
+    }
+
+    // A renderer of its own: builds run on several threads
+    QSvgRenderer renderer(data);
+    if (!renderer.isValid())
+        return result;
+    renderer.setAspectRatioMode(Qt::KeepAspectRatio);
+    for (int size : m_options.sizes) {
+        const QByteArray png = encode(renderAt(renderer, size), m_options.optimize);
+        if (png.isEmpty() || !m_output->write(pngName(pending.svg.name, size), png))
+            return result;
+        ++result.pngs;
+        result.bytes += png.size();
+    }
+    result.rendered = true;
+    result.ok = true;
+    return result;
+}
+
+PngBuild::Result PngBuild::run(const Progress &progress)
+{
+    Result result;
+    if (m_options.sizes.isEmpty()) {
+        result.error = QLatin1String("No sizes to build");
+        return result;
+    }
+
+    loadManifest();
+    if (m_options.force)
+        m_manifestCurrent = false;
+
+    const QList<FolderEntry> listing = m_source->list();
+    if (listing.isEmpty() && !m_source->isReady()) {
+        result.error = QLatin1String("Source folder is not accessible");
+        return result;
+    }
+    QSet<QString> present;
+    for (const FolderEntry &entry : m_output == m_source ? listing : m_output->list())
+        present.insert(entry.name);
+
+    // Same size and time as recorded, and every PNG still there: nothing to read
+    QList<Pending> pending;
+    QSet<QString> seen;
+    for (const FolderEntry &entry : listing) {
+        if (!entry.name.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive))
+            continue;
+        seen.insert(entry.name);
+
+        const auto known = m_manifest.constFind(entry.name);
+        const bool reusable = m_manifestCurrent && known != m_manifest.constEnd()
+                              && std::all_of(m_options.sizes.cbegin(), m_options.sizes.cend(), [&](int size) {
+                                     return present.contains(pngName(entry.name, size));
+                                 });
+        const qint64 lastModified = msecs(entry.lastModified);
+        if (reusable && entry.size >= 0 && lastModified >= 0
+            && known->size == entry.size && known->lastModified == lastModified) {
+            ++result.unchanged;
+            continue;
+        }
+        pending.append(Pending{entry, reusable, reusable ? known->hash : 0});
+    }
+
+    // PNGs of SVGs that are gone, and of sizes no longer built
+    auto removePng = [&](const QString &name) {
+        if (!present.contains(name))
+            return;
+        if (m_output->remove(name))
+            ++result.removed;
+        else
+            ++result.failed;
+    };
+    for (auto it = m_manifest.begin(); it != m_manifest.end();) {
+        const bool gone = !seen.contains(it.key());
+        for (int size : std::as_const(m_manifestSizes)) {
+            if (gone || !m_options.sizes.contains(size))
+                removePng(pngName(it.key(), size));
+        }
+        it = gone ? m_manifest.erase(it) : std::next(it);
+    }
+    // Built with other settings, so nothing recorded holds any more
+    if (!m_manifestCurrent)
+        m_manifest.clear();
+
+    // Results in listing order as they complete; the manifest is only
+    // touched here, never from the workers
+    QFuture<Built> future = QtConcurrent::mapped(QThreadPool::globalInstance(), pending,
+                                                 [this](const Pending &item) { return build(item); });
+    bool canceled = false;
+    for (int i = 0; i < pending.size(); ++i) {
+        const Built built = future.resultAt(i);
+        if (!built.ok) {
+            ++result.failed;
+            m_manifest.remove(built.svgFile); // Built again next time
+        } else {
+            if (built.rendered)
+                ++result.built;
+            else
+                ++result.unchanged;
+            result.pngsWritten += built.pngs;
+            result.bytesWritten += built.bytes;
+            m_manifest.insert(built.svgFile, built.entry);
+        }
+        if (progress && !progress(i + 1, int(pending.size()))) {
+            future.cancel();
+            future.waitForFinished();
+            canceled = true;
+            break;
+        }
+    }
+
+    // What was built before a cancel is kept
+    m_manifestSizes = m_options.sizes;
+    m_manifestCurrent = true;
+    result.ok = saveManifest() && !canceled;
+    if (canceled)
+        result.error = QLatin1String("Canceled");
+    else if (!result.ok)
+        result.error = QLatin1String("Cannot write the build manifest");
+    return result;
+}
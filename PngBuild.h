@@ -0,0 +1,102 @@
+#ifndef PNGBUILD_H
+#define PNGBUILD_H
+
+#include "FolderSource.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QString>
+
+#include <functional>
+
+// Renders every SVG of a folder to the PNG sizes the gallery pairs with it
+// (icon.svg → icon_16.png, icon_32.png, ...). A manifest in the output
+// folder records the content hash each set was built from, so a rebuild
+// only renders SVGs whose content changed. Size and modification time are
+// checked first; a file is only read and hashed when they differ.
+//
+// Only PNGs the build wrote itself are ever replaced or deleted, so
+// hand-made ones next to them are safe as long as their sizes differ.
+class PngBuild
+{
+public:
+    struct Options {
+        QList<int> sizes = {16, 24, 32, 48};
+        // Palette reduction, filtered rows and maximum deflate: smaller
+        // files, the same pixels, several times the encoding time
+        bool optimize = false;
+        bool force = false; // Build everything, as if there were no manifest
+    };
+
+    struct Result {
+        bool ok = false;
+        QString error;
+        int built = 0;     // SVGs rendered
+        int unchanged = 0; // Skipped on metadata or content hash
+        int removed = 0;   // PNGs of SVGs that are gone, or of dropped sizes
+        int failed = 0;
+        int pngsWritten = 0;
+        qint64 bytesWritten = 0;
+
+        QString summary() const;
+    };
+
+    // Called after each SVG that had to be looked at; return false to cancel
+    using Progress = std::function<bool(int done, int total)>;
+
+    static constexpr const char *kManifestName = ".png-build.json";
+
+    PngBuild(const FolderSourcePtr &source, const FolderSourcePtr &output, const Options &options = Options());
+
+    // Blocking; reads, renders and encodes on the global thread pool
+    Result run(const Progress &progress = {});
+
+    // icon.svg at 16 px → icon_16.png
+    static QString pngName(const QString &svgFile, int size);
+    // "16, 32 48" → {16, 32, 48}; entries outside 8 to 1024 are dropped
+    static QList<int> parseSizes(const QString &text);
+
+    // An 8-bit PNG of the image: RGB or RGBA, or a palette when optimizing
+    static QByteArray encode(const QImage &image, bool optimize);
+
+private:
+    struct ManifestEntry {
+        quint64 hash = 0;
+        qint64 size = -1;
+        qint64 lastModified = -1; // ms since epoch
+    };
+
+    // An SVG to read, with the hash its PNGs were built from if they are
+    // all there and were built with the current settings
+    struct Pending {
+        FolderEntry svg;
+        bool reusable = false;
+        quint64 builtFrom = 0;
+    };
+
+    // What one SVG came to, on a worker thread
+    struct Built {
+        QString svgFile;
+        ManifestEntry entry;
+        bool rendered = false;
+        bool ok = false;
+        int pngs = 0;
+        qint64 bytes = 0;
+    };
+
+    QString settingsKey() const;
+    void loadManifest();
+    bool saveManifest() const;
+    Built build(const Pending &pending) const;
+
+    FolderSourcePtr m_source;
+    FolderSourcePtr m_output;
+    Options m_options;
+    QHash<QString, ManifestEntry> m_manifest;
+    QList<int> m_manifestSizes; // What the manifest's PNGs were built at
+    bool m_manifestCurrent = false; // Built with the same settings
+};
+
+#endif // PNGBUILD_H
@@ -3,11 +3,54 @@ SOURCES += \
     main.cpp \
     SvgGallery.cpp \
     AndroidFolder.cpp \
+    Benchmark.cpp \
+    ContactSheet.cpp \
+    ContentHash.cpp \
+    FolderCompare.cpp \
+    FolderSource.cpp \
+    GalleryLoader.cpp \
+    GalleryTheme.cpp \
+    IconTint.cpp \
+    MirrorSync.cpp \
+    PixmapCache.cpp \
+    PngBuild.cpp \
+    RenderBackend.cpp \
+    SessionSnapshot.cpp \
+    SvgDisplayList.cpp \
+    SvgDocument.cpp \
+    SvgInspector.cpp \
+    SvgLint.cpp \
+    SvgMetadata.cpp \
+    SvgOptimizer.cpp \
+    SvgPathParser.cpp \
+    VisualDiff.cpp \
 
 HEADERS += \
     SvgGallery.h \
     SvgPair.h \
     AndroidFolder.h \
+    Benchmark.h \
+    ContactSheet.h \
+    ContentHash.h \
+    FolderCompare.h \
+    FolderSource.h \
+    GalleryLoader.h \
+    GalleryTheme.h \
+    IconTint.h \
+    MirrorSync.h \
+    PixmapCache.h \
+    PngBuild.h \
+    RenderBackend.h \
+    SessionSnapshot.h \
+    SvgDisplayList.h \
+    SvgDocument.h \
+    SvgIconEngine.h \
+    SvgInspector.h \
+    SvgLint.h \
+    SvgMetadata.h \
+    SvgOptimizer.h \
+    SvgPathParser.h \
+    VisualDiff.h \
 
 OTHER_FILES += \
     AndroidFolder.md \
@@ -0,0 +1,172 @@
+#include "RenderBackend.h"
+
+#include "PixmapCache.h"
+
+#include <QElapsedTimer>
+#include <QIconEngine>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QSvgRenderer>
+
+namespace {
+
+// Qt's SVG icon plugin, as QIcon(path) uses it
+class QtBackend : public RenderBackend
+{
+public:
+    QString id() const override { return QStringLiteral("qt"); }
+    QString name() const override { return QStringLiteral("Qt"); }
+
+    QPixmap render(SvgDocument &document, const QSize &size, qreal devicePixelRatio) override
+    {
+        return document.nativeIcon().pixmap(size, devicePixelRatio);
+    }
+};
+
+// QSvgRenderer on the shared, already parsed document
+class CustomBackend : public RenderBackend
+{
+public:
+    QString id() const override { return QStringLiteral("custom"); }
+    QString name() const override { return QStringLiteral("Custom"); }
+
+    QPixmap render(SvgDocument &document, const QSize &size, qreal devicePixelRatio) override
+    {
+        QSvgRenderer *renderer = document.renderer();
+        if (!renderer->isValid())
+            return {};
+
+        // Render at device pixels; the painter works in logical coordinates
+        QPixmap p(size * devicePixelRatio);
+        p.setDevicePixelRatio(devicePixelRatio);
+        p.fill(Qt::transparent);
+        QPainter painter(&p);
+        renderer->render(&painter, QRectF(QPointF(), size));
+        return p;
+    }
+};
+
+// Replays the compiled display list, no XML involved
+class CompiledBackend : public RenderBackend
+{
+public:
+    QString id() const override { return QStringLiteral("compiled"); }
+    QString name() const override { return QStringLiteral("Compiled"); }
+
+    QPixmap render(SvgDocument &document, const QSize &size, qreal devicePixelRatio) override
+    {
+        const SvgDisplayList &list = document.displayList();
+        if (!list.isValid())
+            return {};
+
+        QPixmap p(size * devicePixelRatio);
+        p.setDevicePixelRatio(devicePixelRatio);
+        p.fill(Qt::transparent);
+        QPainter painter(&p);
+        list.replay(&painter, QRectF(QPointF(), size));
+        return p;
+    }
+};
+
+// Serves pixmaps for one document through one backend and keeps the statistics.
+// The pixmaps live in PixmapCache under the document's content, so files with
+// identical bytes share them and everything counts against one budget.
+struct BackendIconEngine : QIconEngine
+{
+    RenderBackend *backend;
+    SvgDocumentPtr document;
+
+    BackendIconEngine(RenderBackend *backend, SvgDocumentPtr const& document)
+        : backend(backend), document(document) {}
+
+    QPixmap pixmap(
+        QSize const& size,
+        QIcon::Mode mode,
+        QIcon::State state) override
+    {
+        return scaledPixmap(size, mode, state, 1.0);
+    }
+
+    // QIcon::pixmap(size, devicePixelRatio) ends up here; size is logical
+    QPixmap scaledPixmap(
+        QSize const& size,
+        QIcon::Mode mode,
+        QIcon::State state,
+        qreal scale) override
+    {
+        PixmapCache &cache = PixmapCache::instance();
+        const PixmapCache::Key key{document->content()->cacheOwner(), quintptr(backend),
+                                   PixmapCache::spec(size, scale, mode, state)};
+        QPixmap p = cache.find(key);
+        if (!p.isNull()) {
+            ++backend->stats().hits;
+            return p;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        p = backend->render(*document, size, scale);
+        if (!p.isNull() && mode != QIcon::Normal) {
+            QIcon icon(p);
+            p = icon.pixmap(size, scale, mode, state);
+        }
+        ++backend->stats().renders;
+        backend->stats().renderNs += timer.nsecsElapsed();
+
+        cache.insert(key, p);
+        return p;
+    }
+
+    void paint(
+        QPainter* painter,
+        QRect const& rect,
+        QIcon::Mode mode,
+        QIcon::State state) override
+    {
+        QPixmap p = scaledPixmap(rect.size(), mode, state, painter->device()->devicePixelRatio());
+        painter->drawPixmap(rect, p);
+    }
+
+    QIconEngine* clone() const override {
+        return new BackendIconEngine(backend, document);
+    }
+};
+
+} // namespace
+
+QIcon RenderBackend::icon(const SvgDocumentPtr &document)
+{
+    return QIcon(new BackendIconEngine(this, document));
+}
+
+RenderBackendRegistry::RenderBackendRegistry()
+{
+    registerBackend(new QtBackend);
+    registerBackend(new CustomBackend);
+    registerBackend(new CompiledBackend);
+}
+
+RenderBackendRegistry::~RenderBackendRegistry()
+{
+    qDeleteAll(m_backends);
+}
+
+RenderBackendRegistry &RenderBackendRegistry::instance()
+{
+    static RenderBackendRegistry registry;
+    return registry;
+}
+
+void RenderBackendRegistry::registerBackend(RenderBackend *backend)
+{
+    m_backends.append(backend);
+}
+
+RenderBackend *RenderBackendRegistry::backend(const QString &id) const
+{
+    for (RenderBackend *backend : m_backends) {
+        if (backend->id() == id)
+            return backend;
+    }
+    return nullptr;
+}
@@ -0,0 +1,64 @@
+#ifndef RENDERBACKEND_H
+#define RENDERBACKEND_H
+
+#include "SvgDocument.h"
+
+#include <QIcon>
+#include <QList>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+// One way of turning an SVG document into pixels
+class RenderBackend
+{
+public:
+    struct Stats {
+        qint64 renders = 0;  // Pixmaps actually rendered (cache misses)
+        qint64 renderNs = 0; // Time spent rendering them
+        qint64 hits = 0;     // Pixmap requests served from the icon cache
+
+        double averageMs() const { return renders ? renderNs / 1e6 / renders : 0.0; }
+        double hitRate() const { return hits + renders ? double(hits) / (hits + renders) : 0.0; }
+    };
+
+    virtual ~RenderBackend() = default;
+
+    virtual QString id() const = 0;
+    virtual QString name() const = 0;
+
+    // Renders the document into a transparent pixmap of the given logical size.
+    // The pixmap has size * devicePixelRatio pixels and carries that ratio.
+    virtual QPixmap render(SvgDocument &document, const QSize &size, qreal devicePixelRatio = 1.0) = 0;
+
+    // Icon that renders through this backend, caching pixmaps per size, pixel ratio and mode
+    QIcon icon(const SvgDocumentPtr &document);
+
+    Stats &stats() { return m_stats; }
+    const Stats &stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+private:
+    Stats m_stats;
+};
+
+// Process-wide list of the available backends
+class RenderBackendRegistry
+{
+public:
+    static RenderBackendRegistry &instance();
+    ~RenderBackendRegistry();
+
+    // Takes ownership
+    void registerBackend(RenderBackend *backend);
+
+    QList<RenderBackend*> backends() const { return m_backends; }
+    RenderBackend *backend(const QString &id) const;
+
+private:
+    RenderBackendRegistry();
+
+    QList<RenderBackend*> m_backends;
+};
+
+#endif // RENDERBACKEND_H
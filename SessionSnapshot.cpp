@@ -0,0 +1,199 @@
+#include "SessionSnapshot.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <climits>
+
+using namespace SessionSnapshotFormat;
+
+static_assert(sizeof(Header) == 40, "Header layout is part of the file format");
+static_assert(sizeof(Item) == 56 && sizeof(Png) == 40, "Layout is part of the file format");
+
+namespace {
+
+QString pendingPath(const QString &path)
+{
+    return path + QLatin1String(".new");
+}
+
+// Appends 8-byte aligned, so every string and buffer can be used in place
+quint64 appendToBlob(QByteArray &blob, const void *data, qsizetype size)
+{
+    const quint64 offset = blob.size();
+    blob.append(static_cast<const char *>(data), size);
+    blob.append((8 - blob.size() % 8) % 8, '\0');
+    return offset;
+}
+
+bool inBlob(quint64 offset, quint64 length, quint64 blobSize)
+{
+    return offset <= blobSize && length <= blobSize - offset;
+}
+
+} // namespace
+
+QString SessionSnapshot::defaultPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+           + QLatin1String("/session.snapshot");
+}
+
+bool SessionSnapshot::save(const QString &path, const Session &session)
+{
+    QByteArray blob;
+    QList<Item> items;
+    QList<Png> pngs;
+    items.reserve(session.items.size());
+
+    Header header = {};
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.iconSize = session.iconSize;
+    header.background = session.background.rgba();
+    header.folderOffset = quint32(appendToBlob(blob, session.folder.constData(), session.folder.size() * 2));
+    header.folderLength = quint32(session.folder.size());
+
+    for (const SessionSnapshot::Item &item : session.items) {
+        Item record = {};
+        record.nameOffset = quint32(appendToBlob(blob, item.name.constData(), item.name.size() * 2));
+        record.nameLength = quint32(item.name.size());
+        record.dataOffset = appendToBlob(blob, item.data.constData(), item.data.size());
+        record.dataLength = quint32(item.data.size());
+        record.size = item.size;
+        record.lastModified = item.lastModified;
+        record.contentHash = item.contentHash;
+        record.firstPng = quint32(pngs.size());
+        record.pngCount = quint32(item.pngs.size());
+        items.append(record);
+
+        for (const SessionSnapshot::Png &png : item.pngs) {
+            Png pngRecord = {};
+            pngRecord.nameOffset = quint32(appendToBlob(blob, png.name.constData(), png.name.size() * 2));
+            pngRecord.nameLength = quint32(png.name.size());
+            pngRecord.dataOffset = appendToBlob(blob, png.data.constData(), png.data.size());
+            pngRecord.dataLength = quint32(png.data.size());
+            pngRecord.size = png.size;
+            pngRecord.lastModified = png.lastModified;
+            pngs.append(pngRecord);
+        }
+    }
+    // Names are addressed with 32 bits
+    if (quint64(blob.size()) > UINT_MAX)
+        return false;
+    header.itemCount = quint32(items.size());
+    header.pngCount = quint32(pngs.size());
+    header.blobSize = blob.size();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(pendingPath(path));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(items.constData()), items.size() * sizeof(Item));
+    file.write(reinterpret_cast<const char *>(pngs.constData()), pngs.size() * sizeof(Png));
+    file.write(blob);
+    if (!file.commit())
+        return false;
+
+    // Replacing fails on Windows while the old snapshot is mapped by this
+    // process; load() completes the swap on the next launch
+    QFile::remove(path);
+    return QFile::rename(pendingPath(path), path) || QFile::exists(pendingPath(path));
+}
+
+SessionSnapshot SessionSnapshot::load(const QString &path)
+{
+    if (QFile::exists(pendingPath(path))) {
+        QFile::remove(path);
+        QFile::rename(pendingPath(path), path);
+    }
+
+    auto file = QSharedPointer<QFile>::create(path);
+    if (!file->open(QIODevice::ReadOnly))
+        return {};
+
+    SessionSnapshot snapshot;
+    if (uchar *mapped = file->map(0, file->size())) {
+        snapshot.m_data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), file->size());
+        snapshot.m_file = file;
+    } else {
+        snapshot.m_data = file->readAll();
+    }
+
+    if (!snapshot.decode())
+        return {};
+    return snapshot;
+}
+
+bool SessionSnapshot::decode()
+{
+    if (m_data.size() < qsizetype(sizeof(Header)))
+        return false;
+
+    const auto *h = reinterpret_cast<const Header *>(m_data.constData());
+    if (h->magic != kMagic || h->version != kVersion)
+        return false;
+    const quint64 tables = sizeof(Header) + quint64(h->itemCount) * sizeof(Item) + quint64(h->pngCount) * sizeof(Png);
+    if (quint64(m_data.size()) != tables + h->blobSize)
+        return false;
+
+    const auto *items = reinterpret_cast<const Item *>(h + 1);
+    const auto *pngs = reinterpret_cast<const Png *>(items + h->itemCount);
+    const char *blob = m_data.constData() + tables;
+
+    // Every range is checked before anything points into it
+    auto string = [&](quint32 offset, quint32 length, QString *result) {
+        if (offset % 2 || !inBlob(offset, quint64(length) * 2, h->blobSize))
+            return false;
+        *result = QString::fromRawData(reinterpret_cast<const QChar *>(blob + offset), length);
+        return true;
+    };
+    auto bytes = [&](quint64 offset, quint32 length, QByteArray *result) {
+        if (!inBlob(offset, length, h->blobSize))
+            return false;
+        *result = QByteArray::fromRawData(blob + offset, length);
+        return true;
+    };
+
+    Session session;
+    if (!string(h->folderOffset, h->folderLength, &session.folder))
+        return false;
+    session.iconSize = h->iconSize;
+    session.background = QColor::fromRgba(h->background);
+    session.items.reserve(h->itemCount);
+
+    for (quint32 i = 0; i < h->itemCount; ++i) {
+        const Item &record = items[i];
+        if (quint64(record.firstPng) + record.pngCount > h->pngCount)
+            return false;
+
+        SessionSnapshot::Item item;
+        if (!string(record.nameOffset, record.nameLength, &item.name)
+            || !bytes(record.dataOffset, record.dataLength, &item.data)) {
+            return false;
+        }
+        item.contentHash = record.contentHash;
+        item.size = record.size;
+        item.lastModified = record.lastModified;
+
+        item.pngs.reserve(record.pngCount);
+        for (quint32 j = record.firstPng; j < record.firstPng + record.pngCount; ++j) {
+            SessionSnapshot::Png png;
+            if (!string(pngs[j].nameOffset, pngs[j].nameLength, &png.name)
+                || !bytes(pngs[j].dataOffset, pngs[j].dataLength, &png.data)) {
+                return false;
+            }
+            png.size = pngs[j].size;
+            png.lastModified = pngs[j].lastModified;
+            item.pngs.append(png);
+        }
+        session.items.append(item);
+    }
+
+    m_session = session;
+    return true;
+}
@@ -0,0 +1,111 @@
+#ifndef SESSIONSNAPSHOT_H
+#define SESSIONSNAPSHOT_H
+
+#include <QByteArray>
+#include <QColor>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+
+class QFile;
+
+// On-disk layout of a session snapshot (native byte order, 8-byte aligned):
+//   Header | Item[itemCount] | Png[pngCount] | blob
+// Offsets point into the blob. Names are UTF-16 and file contents are raw,
+// so a mapped snapshot is used in place: nothing is parsed or copied.
+namespace SessionSnapshotFormat {
+
+constexpr quint32 kMagic = 0x53535653; // "SVSS"
+constexpr quint32 kVersion = 1;
+
+struct Header {
+    quint32 magic;
+    quint32 version;
+    qint32 iconSize;
+    quint32 background; // QRgb
+    quint32 itemCount;
+    quint32 pngCount;
+    quint32 folderOffset;
+    quint32 folderLength; // In UTF-16 code units
+    quint64 blobSize;
+};
+
+// An SVG and, in Png[firstPng, firstPng + pngCount), the PNGs named after it
+struct Item {
+    quint64 dataOffset;
+    quint32 dataLength;
+    quint32 nameOffset;
+    quint32 nameLength;
+    quint32 firstPng;
+    quint32 pngCount;
+    quint32 reserved;
+    qint64 size;          // As listed by the folder, -1 if unknown
+    qint64 lastModified;  // ms since epoch, -1 if unknown
+    quint64 contentHash;  // contentHash() of the data; also names its display list
+};
+
+struct Png {
+    quint64 dataOffset;
+    quint32 dataLength;
+    quint32 nameOffset;
+    quint32 nameLength;
+    quint32 reserved;
+    qint64 size;
+    qint64 lastModified;
+};
+
+} // namespace SessionSnapshotFormat
+
+// The last gallery session: folder, view settings and every item's bytes
+// with the folder metadata they were read at. Restoring maps the file and
+// builds the gallery straight from it; the folder is checked afterwards.
+class SessionSnapshot
+{
+public:
+    struct Png {
+        QString name;
+        QByteArray data;
+        qint64 size = -1;
+        qint64 lastModified = -1;
+    };
+
+    struct Item {
+        QString name;
+        QByteArray data;
+        quint64 contentHash = 0;
+        qint64 size = -1;
+        qint64 lastModified = -1;
+        QList<Png> pngs;
+    };
+
+    struct Session {
+        QString folder;
+        int iconSize = 32;
+        QColor background;
+        QList<Item> items;
+    };
+
+    SessionSnapshot() = default;
+
+    // AppDataLocation/session.snapshot
+    static QString defaultPath();
+
+    static bool save(const QString &path, const Session &session);
+
+    // Maps the file. The names and bytes in session() point into the mapping,
+    // which stays alive as long as any copy of this snapshot does.
+    static SessionSnapshot load(const QString &path);
+
+    bool isValid() const { return !m_data.isEmpty(); }
+    const Session &session() const { return m_session; }
+    qsizetype byteSize() const { return m_data.size(); }
+
+private:
+    bool decode();
+
+    QByteArray m_data;
+    QSharedPointer<QFile> m_file;
+    Session m_session;
+};
+
+#endif // SESSIONSNAPSHOT_H
@@ -0,0 +1,492 @@
+#include "SvgDisplayList.h"
+
+#include "ContentHash.h"
+
+#include <QDir>
+#include <QFile>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPainterPathStroker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QSvgRenderer>
+
+#include <climits>
+
+using namespace SvgDisplayListFormat;
+
+static_assert(sizeof(Header) == 32, "Header layout is part of the file format");
+static_assert(sizeof(Command) == 76, "Command layout is part of the file format");
+static_assert(sizeof(Stop) == 8 && sizeof(Point) == 8, "Layout is part of the file format");
+
+namespace {
+
+// Paint engine that turns every draw call into device-space fill commands
+class RecordingEngine : public QPaintEngine
+{
+public:
+    RecordingEngine() : QPaintEngine(QPaintEngine::AllFeatures) {}
+
+    bool begin(QPaintDevice *) override { return true; }
+    bool end() override { return true; }
+    Type type() const override { return QPaintEngine::User; }
+
+    void updateState(const QPaintEngineState &state) override
+    {
+        const QPaintEngine::DirtyFlags dirty = state.state();
+        if (dirty & DirtyTransform)
+            m_transform = state.transform();
+        if (dirty & DirtyPen)
+            m_pen = state.pen();
+        if (dirty & DirtyBrush)
+            m_brush = state.brush();
+        if (dirty & DirtyOpacity)
+            m_opacity = state.opacity();
+        if (dirty & DirtyClipEnabled)
+            addClipEnabled(state.isClipEnabled());
+        if (dirty & DirtyClipRegion) {
+            QPainterPath path;
+            path.addRegion(state.clipRegion());
+            addClip(m_transform.map(path), state.clipOperation());
+        }
+        if (dirty & DirtyClipPath)
+            addClip(m_transform.map(state.clipPath()), state.clipOperation());
+    }
+
+    using QPaintEngine::drawPolygon;
+
+    void drawPath(const QPainterPath &path) override
+    {
+        record(path, true);
+    }
+
+    void drawPolygon(const QPointF *points, int pointCount, PolygonDrawMode mode) override
+    {
+        if (pointCount < 2)
+            return;
+
+        QPainterPath path(points[0]);
+        for (int i = 1; i < pointCount; ++i)
+            path.lineTo(points[i]);
+        if (mode != PolylineMode)
+            path.closeSubpath();
+        path.setFillRule(mode == OddEvenMode ? Qt::OddEvenFill : Qt::WindingFill);
+        record(path, mode != PolylineMode);
+    }
+
+    void drawPixmap(const QRectF &, const QPixmap &, const QRectF &) override
+    {
+        m_flags |= Lossy;
+    }
+
+    QByteArray finish(const QSizeF &size) const
+    {
+        Header header;
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.width = float(size.width());
+        header.height = float(size.height());
+        header.commandCount = quint32(m_commands.size());
+        header.stopCount = quint32(m_stops.size());
+        header.elementCount = quint32(m_points.size());
+        header.flags = m_flags;
+
+        QByteArray data;
+        data.reserve(sizeof(Header) + m_commands.size() * sizeof(Command)
+                     + m_stops.size() * sizeof(Stop) + m_points.size() * (sizeof(Point) + 1));
+        data.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        data.append(reinterpret_cast<const char *>(m_commands.constData()), m_commands.size() * sizeof(Command));
+        data.append(reinterpret_cast<const char *>(m_stops.constData()), m_stops.size() * sizeof(Stop));
+        data.append(reinterpret_cast<const char *>(m_points.constData()), m_points.size() * sizeof(Point));
+        data.append(reinterpret_cast<const char *>(m_types.constData()), m_types.size());
+        return data;
+    }
+
+private:
+    void record(const QPainterPath &path, bool fill)
+    {
+        const QRectF bounds = path.boundingRect();
+
+        if (fill && m_brush.style() != Qt::NoBrush) {
+            QPainterPath devicePath = m_transform.map(path);
+            devicePath.setFillRule(path.fillRule());
+            addFill(devicePath, m_brush, bounds);
+        }
+
+        if (m_pen.style() == Qt::NoPen || m_pen.brush().style() == Qt::NoBrush)
+            return;
+
+        if (m_pen.isCosmetic()) {
+            // Cosmetic widths are in device pixels: stroke after transforming
+            QPainterPathStroker stroker(m_pen);
+            stroker.setWidth(qMax(m_pen.widthF(), 1.0));
+            addFill(stroker.createStroke(m_transform.map(path)), m_pen.brush(), bounds);
+        } else {
+            const QPainterPath outline = QPainterPathStroker(m_pen).createStroke(path);
+            addFill(m_transform.map(outline), m_pen.brush(), bounds);
+        }
+    }
+
+    void addFill(const QPainterPath &devicePath, const QBrush &brush, const QRectF &logicalBounds)
+    {
+        Command command = {};
+        command.type = Fill;
+        command.mode = quint8(devicePath.fillRule());
+        command.opacity = float(m_opacity);
+        command.color = brush.color().rgba();
+
+        const QGradient *gradient = brush.gradient();
+        if (brush.style() != Qt::SolidPattern && !gradient) {
+            // Texture and hatch brushes are not representable
+            m_flags |= Lossy;
+            return;
+        }
+
+        QTransform brushTransform = brush.transform();
+        if (gradient) {
+            const QTransform boundsTransform(logicalBounds.width(), 0, 0, logicalBounds.height(),
+                                             logicalBounds.x(), logicalBounds.y());
+            if (gradient->coordinateMode() == QGradient::ObjectBoundingMode)
+                brushTransform = boundsTransform * brushTransform;
+            else if (gradient->coordinateMode() == QGradient::ObjectMode)
+                brushTransform = brushTransform * boundsTransform;
+
+            command.spread = quint8(gradient->spread());
+            command.firstStop = quint32(m_stops.size());
+            command.stopCount = quint32(gradient->stops().size());
+            for (const QGradientStop &stop : gradient->stops())
+                m_stops.append({float(stop.first), stop.second.rgba()});
+
+            switch (gradient->type()) {
+            case QGradient::LinearGradient: {
+                const auto *linear = static_cast<const QLinearGradient *>(gradient);
+                command.brushType = Linear;
+                setFloats(command.gradient, {linear->start().x(), linear->start().y(),
+                                             linear->finalStop().x(), linear->finalStop().y()});
+                break;
+            }
+            case QGradient::RadialGradient: {
+                const auto *radial = static_cast<const QRadialGradient *>(gradient);
+                command.brushType = Radial;
+                setFloats(command.gradient, {radial->center().x(), radial->center().y(),
+                                             radial->centerRadius(), radial->focalPoint().x(),
+                                             radial->focalPoint().y(), radial->focalRadius()});
+                break;
+            }
+            case QGradient::ConicalGradient: {
+                const auto *conical = static_cast<const QConicalGradient *>(gradient);
+                command.brushType = Conical;
+                setFloats(command.gradient, {conical->center().x(), conical->center().y(),
+                                             conical->angle()});
+                break;
+            }
+            default:
+                m_flags |= Lossy;
+                return;
+            }
+        }
+        brushTransform *= m_transform;
+        setFloats(command.brushTransform, {brushTransform.m11(), brushTransform.m12(),
+                                           brushTransform.m21(), brushTransform.m22(),
+                                           brushTransform.dx(), brushTransform.dy()});
+
+        appendPath(devicePath, command);
+        m_commands.append(command);
+    }
+
+    void addClip(const QPainterPath &devicePath, Qt::ClipOperation operation)
+    {
+        Command command = {};
+        command.type = Clip;
+        command.mode = quint8(operation);
+        appendPath(devicePath, command);
+        m_commands.append(command);
+    }
+
+    void addClipEnabled(bool enabled)
+    {
+        Command command = {};
+        command.type = ClipEnabled;
+        command.mode = enabled ? 1 : 0;
+        m_commands.append(command);
+    }
+
+    void appendPath(const QPainterPath &path, Command &command)
+    {
+        command.firstElement = quint32(m_points.size());
+        command.elementCount = quint32(path.elementCount());
+        for (int i = 0; i < path.elementCount(); ++i) {
+            const QPainterPath::Element &e = path.elementAt(i);
+            m_points.append({float(e.x), float(e.y)});
+            m_types.append(quint8(e.type));
+        }
+    }
+
+    static void setFloats(float *target, std::initializer_list<qreal> values)
+    {
+        for (qreal value : values)
+            *target++ = float(value);
+    }
+
+    QTransform m_transform;
+    QPen m_pen;
+    QBrush m_brush;
+    qreal m_opacity = 1.0;
+    quint32 m_flags = 0;
+
+    QList<Command> m_commands;
+    QList<Stop> m_stops;
+    QList<Point> m_points;
+    QList<quint8> m_types;
+};
+
+class RecordingDevice : public QPaintDevice
+{
+public:
+    explicit RecordingDevice(const QSize &size) : m_size(size) {}
+
+    QPaintEngine *paintEngine() const override { return &m_engine; }
+    RecordingEngine &engine() { return m_engine; }
+
+protected:
+    int metric(PaintDeviceMetric metric) const override
+    {
+        switch (metric) {
+        case PdmWidth: return m_size.width();
+        case PdmHeight: return m_size.height();
+        case PdmWidthMM: return qRound(m_size.width() * 25.4 / 96);
+        case PdmHeightMM: return qRound(m_size.height() * 25.4 / 96);
+        case PdmNumColors: return INT_MAX;
+        case PdmDepth: return 32;
+        case PdmDpiX:
+        case PdmDpiY:
+        case PdmPhysicalDpiX:
+        case PdmPhysicalDpiY: return 96;
+        case PdmDevicePixelRatio: return 1;
+        default: return QPaintDevice::metric(metric);
+        }
+    }
+
+private:
+    QSize m_size;
+    mutable RecordingEngine m_engine;
+};
+
+} // namespace
+
+SvgDisplayList SvgDisplayList::compile(const QByteArray &svg)
+{
+    QSvgRenderer renderer(svg);
+    if (!renderer.isValid())
+        return {};
+
+    QSize size = renderer.defaultSize();
+    if (size.isEmpty())
+        size = QSize(64, 64);
+
+    RecordingDevice device(size);
+    QPainter painter(&device);
+    renderer.render(&painter, QRectF(QPointF(), size));
+    painter.end();
+
+    SvgDisplayList list;
+    list.m_data = device.engine().finish(size);
+    return list;
+}
+
+SvgDisplayList SvgDisplayList::load(const QString &path)
+{
+    auto file = QSharedPointer<QFile>::create(path);
+    if (!file->open(QIODevice::ReadOnly))
+        return {};
+
+    SvgDisplayList list;
+    if (uchar *mapped = file->map(0, file->size())) {
+        list.m_data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), file->size());
+        list.m_file = file;
+    } else {
+        list.m_data = file->readAll();
+    }
+
+    if (!list.validate())
+        return {};
+    return list;
+}
+
+QString SvgDisplayList::cacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + QLatin1String("/displaylists/");
+}
+
+SvgDisplayList SvgDisplayList::cached(const QByteArray &svg)
+{
+    const QString path = cacheDirectory()
+                         + QString::number(contentHash(svg), 16).rightJustified(16, QLatin1Char('0'))
+                         + QLatin1String(".svdl");
+
+    SvgDisplayList list = load(path);
+    if (list.isValid())
+        return list;
+
+    list = compile(svg);
+    if (list.isValid()) {
+        QDir().mkpath(cacheDirectory());
+        list.save(path);
+    }
+    return list;
+}
+
+bool SvgDisplayList::save(const QString &path) const
+{
+    if (!isValid())
+        return false;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    file.write(m_data);
+    return file.commit();
+}
+
+const Header *SvgDisplayList::header() const
+{
+    return reinterpret_cast<const Header *>(m_data.constData());
+}
+
+bool SvgDisplayList::isLossy() const
+{
+    return isValid() && (header()->flags & Lossy);
+}
+
+QSizeF SvgDisplayList::defaultSize() const
+{
+    if (!isValid())
+        return {};
+    return QSizeF(header()->width, header()->height);
+}
+
+bool SvgDisplayList::validate() const
+{
+    if (m_data.size() < qsizetype(sizeof(Header)))
+        return false;
+
+    const Header *h = header();
+    if (h->magic != kMagic || h->version != kVersion || h->width <= 0 || h->height <= 0)
+        return false;
+
+    const quint64 expected = sizeof(Header) + quint64(h->commandCount) * sizeof(Command)
+                             + quint64(h->stopCount) * sizeof(Stop)
+                             + quint64(h->elementCount) * (sizeof(Point) + 1);
+    if (quint64(m_data.size()) != expected)
+        return false;
+
+    const auto *commands = reinterpret_cast<const Command *>(h + 1);
+    for (quint32 i = 0; i < h->commandCount; ++i) {
+        const Command &c = commands[i];
+        if (quint64(c.firstElement) + c.elementCount > h->elementCount
+            || quint64(c.firstStop) + c.stopCount > h->stopCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SvgDisplayList::replay(QPainter *painter, const QRectF &bounds) const
+{
+    if (!isValid())
+        return;
+
+    const Header *h = header();
+    const auto *commands = reinterpret_cast<const Command *>(h + 1);
+    const auto *stops = reinterpret_cast<const Stop *>(commands + h->commandCount);
+    const auto *points = reinterpret_cast<const Point *>(stops + h->stopCount);
+    const auto *types = reinterpret_cast<const quint8 *>(points + h->elementCount);
+
+    const qreal scale = qMin(bounds.width() / h->width, bounds.height() / h->height);
+
+    painter->save();
+    painter->translate(bounds.x() + (bounds.width() - h->width * scale) / 2,
+                       bounds.y() + (bounds.height() - h->height * scale) / 2);
+    painter->scale(scale, scale);
+    painter->setPen(Qt::NoPen);
+    painter->setRenderHint(QPainter::Antialiasing);
+    const qreal baseOpacity = painter->opacity();
+
+    auto buildPath = [&](const Command &c) {
+        QPainterPath path;
+        path.reserve(int(c.elementCount));
+        const quint32 end = c.firstElement + c.elementCount;
+        for (quint32 i = c.firstElement; i < end; ++i) {
+            const Point &p = points[i];
+            switch (types[i]) {
+            case QPainterPath::MoveToElement:
+                path.moveTo(p.x, p.y);
+                break;
+            case QPainterPath::LineToElement:
+                path.lineTo(p.x, p.y);
+                break;
+            case QPainterPath::CurveToElement:
+                if (i + 2 < end) {
+                    path.cubicTo(p.x, p.y, points[i + 1].x, points[i + 1].y,
+                                 points[i + 2].x, points[i + 2].y);
+                }
+                i += 2;
+                break;
+            default:
+                break;
+            }
+        }
+        return path;
+    };
+
+    for (quint32 index = 0; index < h->commandCount; ++index) {
+        const Command &c = commands[index];
+        switch (c.type) {
+        case Fill: {
+            QPainterPath path = buildPath(c);
+            path.setFillRule(Qt::FillRule(c.mode));
+
+            QBrush brush;
+            if (c.brushType == Solid) {
+                brush = QBrush(QColor::fromRgba(c.color));
+            } else {
+                QGradientStops gradientStops;
+                gradientStops.reserve(c.stopCount);
+                for (quint32 s = c.firstStop; s < c.firstStop + c.stopCount; ++s)
+                    gradientStops.append({stops[s].position, QColor::fromRgba(stops[s].color)});
+
+                const float *g = c.gradient;
+                QGradient gradient;
+                if (c.brushType == Linear)
+                    gradient = QLinearGradient(g[0], g[1], g[2], g[3]);
+                else if (c.brushType == Radial)
+                    gradient = QRadialGradient(QPointF(g[0], g[1]), g[2], QPointF(g[3], g[4]), g[5]);
+                else
+                    gradient = QConicalGradient(g[0], g[1], g[2]);
+                gradient.setStops(gradientStops);
+                gradient.setSpread(QGradient::Spread(c.spread));
+                brush = QBrush(gradient);
+            }
+            const float *t = c.brushTransform;
+            brush.setTransform(QTransform(t[0], t[1], t[2], t[3], t[4], t[5]));
+
+            painter->setOpacity(baseOpacity * c.opacity);
+            painter->fillPath(path, brush);
+            break;
+        }
+        case Clip:
+            painter->setClipPath(buildPath(c), Qt::ClipOperation(c.mode));
+            break;
+        case ClipEnabled:
+            painter->setClipping(c.mode != 0);
+            break;
+        default:
+            break;
+        }
+    }
+
+    painter->restore();
+}
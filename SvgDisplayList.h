@@ -0,0 +1,115 @@
+#ifndef SVGDISPLAYLIST_H
+#define SVGDISPLAYLIST_H
+
+#include <QByteArray>
+#include <QRectF>
+#include <QSharedPointer>
+#include <QSizeF>
+#include <QString>
+
+class QFile;
+class QPainter;
+
+// On-disk layout of a compiled display list (host byte order, 4-byte aligned):
+//   Header | Command[commandCount] | Stop[stopCount] | Point[elementCount] | quint8 types[elementCount]
+// The structs are written and mapped as they are, so a file is only valid on
+// the machine that compiled it; it lives in the local cache directory, and a
+// file from another byte order fails the magic check and is recompiled.
+// Paths are stored with every transform pre-applied, strokes are converted
+// to fills, and gradients are resolved to logical coordinates. Replaying
+// needs no XML and no style resolution.
+namespace SvgDisplayListFormat {
+
+constexpr quint32 kMagic = 0x4C445653; // "SVDL"
+constexpr quint32 kVersion = 1;
+
+enum Flags : quint32 {
+    Lossy = 0x1, // Something could not be recorded (embedded images, patterns)
+};
+
+enum CommandType : quint8 {
+    Fill = 0,
+    Clip = 1,
+    ClipEnabled = 2,
+};
+
+enum BrushType : quint8 {
+    Solid = 0,
+    Linear = 1,
+    Radial = 2,
+    Conical = 3,
+};
+
+struct Header {
+    quint32 magic;
+    quint32 version;
+    float width;  // Recorded size, replay scales from here
+    float height;
+    quint32 commandCount;
+    quint32 stopCount;
+    quint32 elementCount;
+    quint32 flags;
+};
+
+struct Command {
+    quint8 type;
+    quint8 brushType;
+    quint8 mode;    // Fill: Qt::FillRule, Clip: Qt::ClipOperation, ClipEnabled: 0/1
+    quint8 spread;  // QGradient::Spread
+    quint32 color;  // QRgb
+    float opacity;
+    quint32 firstElement;
+    quint32 elementCount;
+    quint32 firstStop;
+    quint32 stopCount;
+    float gradient[6];       // Linear: x1 y1 x2 y2, radial: cx cy r fx fy fr, conical: cx cy angle
+    float brushTransform[6]; // m11 m12 m21 m22 dx dy
+};
+
+struct Stop {
+    float position;
+    quint32 color;
+};
+
+struct Point {
+    float x;
+    float y;
+};
+
+} // namespace SvgDisplayListFormat
+
+// A QSvgRenderer render recorded into a compact, replayable binary form
+class SvgDisplayList
+{
+public:
+    SvgDisplayList() = default;
+
+    // Records a render of the SVG. Returns an invalid list if it does not parse.
+    static SvgDisplayList compile(const QByteArray &svg);
+
+    // Memory-maps a list written by save()
+    static SvgDisplayList load(const QString &path);
+
+    // Loads the list for this content from the cache, compiling it on a miss
+    static SvgDisplayList cached(const QByteArray &svg);
+    static QString cacheDirectory();
+
+    bool save(const QString &path) const;
+
+    bool isValid() const { return !m_data.isEmpty(); }
+    bool isLossy() const;
+    QSizeF defaultSize() const;
+    qsizetype byteSize() const { return m_data.size(); }
+
+    // Draws into bounds, keeping the aspect ratio and centering
+    void replay(QPainter *painter, const QRectF &bounds) const;
+
+private:
+    bool validate() const;
+    const SvgDisplayListFormat::Header *header() const;
+
+    QByteArray m_data;
+    QSharedPointer<QFile> m_file; // Keeps the mapping alive
+};
+
+#endif // SVGDISPLAYLIST_H
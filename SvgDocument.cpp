@@ -0,0 +1,176 @@
+#include "SvgDocument.h"
+
+#include "ContentHash.h"
+#include "PixmapCache.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSvgRenderer>
+#include <QWeakPointer>
+
+namespace {
+
+// Live contents by hash. Entries expire with the last document using them.
+QMutex internMutex;
+QHash<quint64, QWeakPointer<SvgContent>> internedContents;
+
+// Qt's SVG icon engine only loads files, but it also restores itself from a
+// QIcon stream: engine key, then what QSvgIconEngine::write() produces.
+// Building that stream hands it the bytes we already have.
+QIcon iconFromMemory(const QByteArray &svg)
+{
+    QByteArray serialized;
+    QDataStream out(&serialized, QIODevice::WriteOnly);
+    out << QStringLiteral("svg")
+        << QHash<int, QString>() // File names, none
+        << int(1)                // Buffers are compressed
+        << QHash<int, QByteArray>{{(QIcon::Normal << 4) | QIcon::Off, qCompress(svg)}}
+        << int(0);               // No added pixmaps
+
+    QIcon icon;
+    QDataStream in(serialized);
+    in >> icon;
+    return icon;
+}
+
+// The stream is private to the plugin and unversioned; if it changes, the
+// engine still loads but draws nothing. Checked once on an opaque square.
+bool iconFromMemoryWorks()
+{
+    static const bool works = [] {
+        const QIcon icon = iconFromMemory(QByteArrayLiteral(
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"8\" height=\"8\">"
+            "<rect width=\"8\" height=\"8\"/></svg>"));
+        const QImage image = icon.pixmap(QSize(8, 8), 1.0).toImage();
+        const bool ok = !image.isNull() && qAlpha(image.pixel(4, 4)) == 255;
+        if (!ok)
+            qWarning() << "Qt's SVG icon engine does not load from memory; the Qt backend reads files";
+        return ok;
+    }();
+    return works;
+}
+
+} // namespace
+
+// ── SvgContent ─────────────────────────────────────────────────
+
+SvgContentPtr SvgContent::intern(const QByteArray &data)
+{
+    return intern(data, contentHash(data));
+}
+
+SvgContentPtr SvgContent::intern(const QByteArray &data, quint64 hash)
+{
+    // Released after the lock, in case it is the last reference
+    SvgContentPtr existing;
+    QMutexLocker locker(&internMutex);
+
+    auto it = internedContents.find(hash);
+    if (it != internedContents.end())
+        existing = it->toStrongRef();
+    if (existing && existing->m_data == data)
+        return existing;
+
+    SvgContentPtr content(new SvgContent(data, hash));
+    // A hash collision with live content stays unshared
+    if (!existing) {
+        content->m_interned = true;
+        internedContents.insert(hash, content);
+    }
+    return content;
+}
+
+SvgContent::SvgContent(const QByteArray &data, quint64 hash)
+    : m_data(data)
+    , m_hash(hash)
+    , m_cacheOwner(PixmapCache::newOwner())
+{
+}
+
+SvgContent::~SvgContent()
+{
+    PixmapCache::instance().removeOwner(m_cacheOwner);
+    if (!m_interned)
+        return;
+    QMutexLocker locker(&internMutex);
+    auto it = internedContents.find(m_hash);
+    if (it != internedContents.end() && it->isNull())
+        internedContents.erase(it);
+}
+
+QSvgRenderer *SvgContent::renderer()
+{
+    if (!m_renderer) {
+        m_renderer = std::make_unique<QSvgRenderer>(m_data);
+        m_renderer->setAspectRatioMode(Qt::KeepAspectRatio);
+    }
+    return m_renderer.get();
+}
+
+const SvgDisplayList &SvgContent::displayList()
+{
+    if (!m_displayList.isValid())
+        m_displayList = SvgDisplayList::cached(m_data);
+    return m_displayList;
+}
+
+QIcon SvgContent::nativeIcon()
+{
+    if (m_nativeIcon.isNull() && iconFromMemoryWorks())
+        m_nativeIcon = iconFromMemory(m_data);
+    return m_nativeIcon;
+}
+
+bool SvgContent::usesCurrentColor()
+{
+    // The keyword is case-insensitive, but these are the spellings in use
+    if (m_usesCurrentColor < 0)
+        m_usesCurrentColor = m_data.contains("currentColor") || m_data.contains("currentcolor");
+    return m_usesCurrentColor;
+}
+
+// ── SvgDocument ────────────────────────────────────────────────
+
+SvgDocument::SvgDocument(const QString &path, const QByteArray &data)
+    : m_path(path)
+    , m_content(SvgContent::intern(data))
+{
+}
+
+SvgDocument::SvgDocument(const QString &path, const QByteArray &data, quint64 contentHash)
+    : m_path(path)
+    , m_content(SvgContent::intern(data, contentHash))
+{
+}
+
+SvgDocument::~SvgDocument() = default;
+
+QSharedPointer<SvgDocument> SvgDocument::fromFile(const QString &path)
+{
+    QByteArray data;
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly))
+        data = file.readAll();
+    return QSharedPointer<SvgDocument>::create(path, data);
+}
+
+void SvgDocument::setData(const QByteArray &data)
+{
+    m_content = SvgContent::intern(data);
+}
+
+QIcon SvgDocument::nativeIcon()
+{
+    const QIcon icon = m_content->nativeIcon();
+
+    // Engine plugin missing or stream format changed (see iconFromMemoryWorks()):
+    // fall back to the file
+    if (icon.isNull() && QFile::exists(m_path))
+        return QIcon(m_path);
+    return icon;
+}
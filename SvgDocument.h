@@ -0,0 +1,86 @@
+#ifndef SVGDOCUMENT_H
+#define SVGDOCUMENT_H
+
+#include "SvgDisplayList.h"
+
+#include <QByteArray>
+#include <QIcon>
+#include <QSharedPointer>
+#include <QString>
+
+#include <memory>
+
+class QSvgRenderer;
+
+// The bytes of an SVG plus the parsed forms and rasters built from them.
+// Content is interned by hash: documents with identical bytes (aliases,
+// copies per theme folder) share one SvgContent, so they are parsed and
+// rendered once. Each form is built on first use; rasters live in PixmapCache.
+class SvgContent
+{
+public:
+    // The live content for these bytes, or a new one
+    static QSharedPointer<SvgContent> intern(const QByteArray &data);
+    // Same, for bytes whose contentHash() is already known (session snapshots)
+    static QSharedPointer<SvgContent> intern(const QByteArray &data, quint64 hash);
+
+    ~SvgContent();
+
+    quint64 hash() const { return m_hash; }
+    const QByteArray &data() const { return m_data; }
+
+    QSvgRenderer *renderer();
+    const SvgDisplayList &displayList();
+    QIcon nativeIcon(); // Qt's own SVG icon engine, null if it cannot load from memory
+    bool usesCurrentColor(); // Paints anything in currentColor, so it follows a theme color
+
+    // Owner of this content's renders in PixmapCache; they go with the content
+    quint64 cacheOwner() const { return m_cacheOwner; }
+
+private:
+    SvgContent(const QByteArray &data, quint64 hash);
+
+    QByteArray m_data;
+    quint64 m_hash;
+    bool m_interned = false;
+    std::unique_ptr<QSvgRenderer> m_renderer;
+    SvgDisplayList m_displayList;
+    QIcon m_nativeIcon;
+    int m_usesCurrentColor = -1; // Not looked for yet
+    quint64 m_cacheOwner;
+};
+
+using SvgContentPtr = QSharedPointer<SvgContent>;
+
+// One SVG file: its name and its (possibly shared) content.
+// Everything renders from data(); the path is only a name and may not exist.
+class SvgDocument
+{
+public:
+    SvgDocument(const QString &path, const QByteArray &data);
+    SvgDocument(const QString &path, const QByteArray &data, quint64 contentHash);
+    ~SvgDocument();
+
+    static QSharedPointer<SvgDocument> fromFile(const QString &path);
+
+    const QString &path() const { return m_path; }
+    const QByteArray &data() const { return m_content->data(); }
+    quint64 contentHash() const { return m_content->hash(); }
+    const SvgContentPtr &content() const { return m_content; }
+
+    // Moves this document to the content for the new bytes; documents that
+    // shared the old content keep it
+    void setData(const QByteArray &data);
+
+    QSvgRenderer *renderer() { return m_content->renderer(); }
+    const SvgDisplayList &displayList() { return m_content->displayList(); }
+    QIcon nativeIcon(); // Qt's own SVG icon engine, as QIcon(path) would use
+
+private:
+    QString m_path;
+    SvgContentPtr m_content;
+};
+
+using SvgDocumentPtr = QSharedPointer<SvgDocument>;
+
+#endif // SVGDOCUMENT_H
@@ -1,35 +1,109 @@
 #include "SvgGallery.h"
 
+#include "ContactSheet.h"
+#include "ContentHash.h"
+#include "FolderCompare.h"
+#include "MirrorSync.h"
+#include "PixmapCache.h"
+#include "PngBuild.h"
 #include "ScintillaRelay.h"
+#include "SvgInspector.h"
+#include "SvgOptimizer.h"
 
 #include <QCheckBox>
+#include <QCloseEvent>
+#include <QComboBox>
 #include <QColorDialog>
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
-#include <QFile>
+#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QHBoxLayout>
+#include <QInputDialog>
+#include <QLocale>
+#include <QMap>
+#include <QMessageBox>
 #include <QPalette>
+#include <QPointer>
+#include <QProgressDialog>
 #include <QPushButton>
-#include <QRegularExpression>
 #include <QScrollBar>
+#include <QSet>
+#include <QShortcut>
+#include <QSignalBlocker>
 #include <QSplitter>
-#include <QStandardPaths>
+#include <QStatusBar>
+#include <QTabBar>
+#include <QTabWidget>
 #include <QTextStream>
+#include <QTimer>
+#include <QToolButton>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+
+// Orders and groupings offered above the gallery, as combo item data
+enum SortKey { SortByName, SortBySize, SortByComplexity, SortByAspectRatio };
+enum Grouping { NoGrouping, GroupByAspectRatio, GroupByComplexity, GroupByEffects, GroupByGeometry };
+
+// Scintilla indicators for lint findings; 8 is INDICATOR_CONTAINER, the
+// first one left to applications. Annotations use a style past the
+// predefined ones.
+constexpr int kLintWarningIndicator = 8;
+constexpr int kLintSevereIndicator = 9;
+constexpr int kLintAnnotationStyle = 40;
+
+// Open editor documents keep their text, styles and undo history in memory;
+// past this, the least recently used ones without unsaved changes are closed
+constexpr qint64 kEditorDocumentBudget = 32 * 1024 * 1024;
+
+qint64 msecsOf(const QDateTime &time)
+{
+    return time.isValid() ? time.toMSecsSinceEpoch() : -1;
+}
+
+FolderEntry folderEntry(const QString &name, qint64 size, qint64 lastModified)
+{
+    return FolderEntry{name, size, lastModified >= 0 ? QDateTime::fromMSecsSinceEpoch(lastModified) : QDateTime()};
+}
+
+// Without both size and time a file cannot be shown to be unchanged
+bool sameFile(const FolderEntry &listed, const FolderEntry &known)
+{
+    return listed.size >= 0 && listed.lastModified.isValid()
+           && listed.size == known.size && listed.lastModified == known.lastModified;
+}
+
+} // namespace
+
 SvgGallery::SvgGallery(QWidget *parent)
     : QMainWindow(parent)
-    , m_currentPath("")
     , m_backgroundColor(QColor(90, 90, 90)) // Medium dark as default
     , m_editorVisible(false)
 {
+    connect(&m_sessionListWatcher, &QFutureWatcherBase::finished, this, &SvgGallery::onSessionListed);
+    connect(&m_sessionReadWatcher, &QFutureWatcherBase::finished, this, &SvgGallery::onSessionFilesRead);
+    connect(&m_metadataWatcher, &QFutureWatcherBase::finished, this, &SvgGallery::onMetadataReady);
+    connect(&m_lintWatcher, &QFutureWatcherBase::finished, this, &SvgGallery::onLintFinished);
+
     initUI();
+    addTab();
     QCoreApplication::setAttribute(Qt::AA_SynthesizeMouseForUnhandledTouchEvents);
 }
 
+SvgGallery::~SvgGallery()
+{
+    // Their widgets and loaders are children of the window
+    qDeleteAll(m_documents);
+    qDeleteAll(m_tabs);
+}
+
 void SvgGallery::initUI()
 {
     setWindowTitle(tr("SVG Gallery Viewer"));
@@ -58,6 +132,26 @@ void SvgGallery::initUI()
     connect(loadBtn, &QPushButton::clicked, this, &SvgGallery::loadSvgs);
     controlsLayout->addWidget(loadBtn);
 
+    QPushButton *optimizeFolderBtn = new QPushButton(tr("Optimize All..."), this);
+    optimizeFolderBtn->setToolTip(tr("Optimize every loaded SVG and report parse/render cost before and after"));
+    connect(optimizeFolderBtn, &QPushButton::clicked, this, &SvgGallery::optimizeFolder);
+    controlsLayout->addWidget(optimizeFolderBtn);
+
+    QPushButton *exportSheetBtn = new QPushButton(tr("Export Sheet..."), this);
+    exportSheetBtn->setToolTip(tr("Export the shown SVGs as one PNG or multi-page PDF, per icon size and background preset"));
+    connect(exportSheetBtn, &QPushButton::clicked, this, &SvgGallery::exportContactSheet);
+    controlsLayout->addWidget(exportSheetBtn);
+
+    QPushButton *buildPngsBtn = new QPushButton(tr("Build PNGs..."), this);
+    buildPngsBtn->setToolTip(tr("Render every SVG in the folder to name_<size>.png; only changed SVGs are rendered again"));
+    connect(buildPngsBtn, &QPushButton::clicked, this, &SvgGallery::buildPngs);
+    controlsLayout->addWidget(buildPngsBtn);
+
+    QPushButton *compareBtn = new QPushButton(tr("Compare..."), this);
+    compareBtn->setToolTip(tr("Compare two versions of an icon folder and show what was added, removed or changed"));
+    connect(compareBtn, &QPushButton::clicked, this, &SvgGallery::compareFolders);
+    controlsLayout->addWidget(compareBtn);
+
     mainLayout->addLayout(controlsLayout);
 
     // Filter
@@ -67,43 +161,50 @@ void SvgGallery::initUI()
     m_filterInput->setClearButtonEnabled(true);
     connect(m_filterInput, &QLineEdit::textChanged, this, &SvgGallery::filterGallery);
     filterLayout->addWidget(m_filterInput, 1);
+
+    // Sorting and grouping use metadata extracted in the background after each load
+    m_sortCombo = new QComboBox(this);
+    m_sortCombo->addItem(tr("Sort by name"), SortByName);
+    m_sortCombo->addItem(tr("Largest files first"), SortBySize);
+    m_sortCombo->addItem(tr("Most complex first"), SortByComplexity);
+    m_sortCombo->addItem(tr("Widest first"), SortByAspectRatio);
+    m_sortCombo->setToolTip(tr("Complexity counts elements and path segments"));
+    connect(m_sortCombo, &QComboBox::currentIndexChanged, this, [this] {
+        m_tab->sortKey = m_sortCombo->currentData().toInt();
+        arrangeGallery(m_tab);
+    });
+    filterLayout->addWidget(m_sortCombo);
+
+    m_groupCombo = new QComboBox(this);
+    m_groupCombo->addItem(tr("No groups"), NoGrouping);
+    m_groupCombo->addItem(tr("Group by aspect ratio"), GroupByAspectRatio);
+    m_groupCombo->addItem(tr("Group by complexity"), GroupByComplexity);
+    m_groupCombo->addItem(tr("Group by effects used"), GroupByEffects);
+    m_groupCombo->addItem(tr("Group by geometry issues"), GroupByGeometry);
+    connect(m_groupCombo, &QComboBox::currentIndexChanged, this, [this] {
+        m_tab->grouping = m_groupCombo->currentData().toInt();
+        arrangeGallery(m_tab);
+    });
+    filterLayout->addWidget(m_groupCombo);
+
     filterLayout->addStretch();
     mainLayout->addLayout(filterLayout);
 
     // Background color presets
     QHBoxLayout *bgPresetsLayout = new QHBoxLayout();
 
-    QPushButton *bgPresetNative = new QPushButton(tr("Native"), this);
-    bgPresetNative->setToolTip("RGB(236, 236, 236)");
-    connect(bgPresetNative, &QPushButton::clicked, this, [this] {
-        m_backgroundColor = QColor(236, 236, 236);
-        updateBackgroundColor();
-    });
-    bgPresetsLayout->addWidget(bgPresetNative);
-
-    QPushButton *bgPresetBright = new QPushButton(tr("Bright"), this);
-    bgPresetBright->setToolTip("RGB(110, 110, 110)");
-    connect(bgPresetBright, &QPushButton::clicked, this, [this] {
-        m_backgroundColor = QColor(110, 110, 110);
-        updateBackgroundColor();
-    });
-    bgPresetsLayout->addWidget(bgPresetBright);
-
-    QPushButton *bgPresetMedium = new QPushButton(tr("Medium (Default)"), this);
-    bgPresetMedium->setToolTip("RGB(90, 90, 90)");
-    connect(bgPresetMedium, &QPushButton::clicked, this, [this] {
-        m_backgroundColor = QColor(90, 90, 90);
-        updateBackgroundColor();
-    });
-    bgPresetsLayout->addWidget(bgPresetMedium);
-
-    QPushButton *bgPresetDark = new QPushButton(tr("Dark"), this);
-    bgPresetDark->setToolTip("RGB(40, 40, 40)");
-    connect(bgPresetDark, &QPushButton::clicked, this, [this] {
-        m_backgroundColor = QColor(40, 40, 40);
-        updateBackgroundColor();
-    });
-    bgPresetsLayout->addWidget(bgPresetDark);
+    for (const GalleryTheme::Preset &preset : GalleryTheme::presets()) {
+        QPushButton *presetBtn = new QPushButton(preset.name, this);
+        presetBtn->setToolTip(QString("RGB(%1, %2, %3)")
+                                  .arg(preset.background.red())
+                                  .arg(preset.background.green())
+                                  .arg(preset.background.blue()));
+        connect(presetBtn, &QPushButton::clicked, this, [this, color = preset.background] {
+            m_backgroundColor = color;
+            updateBackgroundColor();
+        });
+        bgPresetsLayout->addWidget(presetBtn);
+    }
 
     QPushButton *bgColorBtn = new QPushButton(tr("Custom Color..."), this);
     connect(bgColorBtn, &QPushButton::clicked, this, [this]{
@@ -115,13 +216,65 @@ void SvgGallery::initUI()
     });
     bgPresetsLayout->addWidget(bgColorBtn);
 
-    QCheckBox *ch_customEngine = new QCheckBox(tr("Custom engine"));
-    ch_customEngine->setToolTip(tr("Toggle and reload if icons scale incorrectly."));
-    ch_customEngine->setChecked(false);
-    connect(ch_customEngine, &QCheckBox::clicked, this, [this](bool checked){
-        m_customEngine = checked;
+    // Render backends: one at a time, or all side by side; switching is live
+    QComboBox *backendCombo = new QComboBox(this);
+    for (RenderBackend *backend : RenderBackendRegistry::instance().backends())
+        backendCombo->addItem(tr("%1 engine").arg(backend->name()), backend->id());
+    backendCombo->addItem(tr("All engines side by side"));
+    backendCombo->setToolTip(tr("Qt: Qt's SVG icon engine, as QIcon(path) uses it. Custom: QSvgRenderer on the shared parsed document.\n"
+                                "Compiled: replays cached display lists without parsing XML."));
+    m_backends = {RenderBackendRegistry::instance().backends().first()};
+    connect(backendCombo, &QComboBox::currentIndexChanged, this, [this, backendCombo](int index){
+        RenderBackend *backend = RenderBackendRegistry::instance().backend(backendCombo->itemData(index).toString());
+        setBackends(backend ? QList<RenderBackend*>{backend} : RenderBackendRegistry::instance().backends());
+    });
+    bgPresetsLayout->addWidget(backendCombo);
+
+    // Device pixel ratio: the screen's, or simulated so 1.25x-2x renders can be
+    // compared on a 1x desktop; simulated icons are shown pixel for pixel
+    QComboBox *ratioCombo = new QComboBox(this);
+    ratioCombo->addItem(tr("Screen DPR"), QVariant::fromValue(QList<qreal>{0}));
+    for (qreal ratio : {1.0, 1.25, 1.5, 2.0})
+        ratioCombo->addItem(tr("%1× DPR").arg(ratio), QVariant::fromValue(QList<qreal>{ratio}));
+    ratioCombo->addItem(tr("All DPRs side by side"), QVariant::fromValue(QList<qreal>{1.0, 1.25, 1.5, 2.0}));
+    ratioCombo->setToolTip(tr("Renders SVGs at icon size × device pixel ratio pixels"));
+    connect(ratioCombo, &QComboBox::currentIndexChanged, this, [this, ratioCombo](int index){
+        setPixelRatios(ratioCombo->itemData(index).value<QList<qreal>>());
+    });
+    bgPresetsLayout->addWidget(ratioCombo);
+
+    // Tint: recolored from cached masks, the way a themed client does it;
+    // switching colors is live for the whole gallery
+    QComboBox *tintCombo = new QComboBox(this);
+    tintCombo->addItem(tr("Original colors"), IconTint::Off);
+    tintCombo->addItem(tr("Tint whole icon"), IconTint::Whole);
+    tintCombo->addItem(tr("Tint currentColor"), IconTint::CurrentColor);
+    tintCombo->setToolTip(tr("Whole icon: monochrome icons in the tint color. currentColor: only what the SVG paints in currentColor,\n"
+                             "other icons keep their colors. The tint follows the theme's text color unless one is chosen."));
+    connect(tintCombo, &QComboBox::currentIndexChanged, this, [this, tintCombo](int index){
+        setTint(IconTint::Mode(tintCombo->itemData(index).toInt()), m_tintColor);
+    });
+    bgPresetsLayout->addWidget(tintCombo);
+
+    QPushButton *tintColorBtn = new QPushButton(tr("Tint Color..."), this);
+    connect(tintColorBtn, &QPushButton::clicked, this, [this]{
+        QColor color = QColorDialog::getColor(m_tintColor.isValid() ? m_tintColor : m_theme.text(), this, tr("Choose Tint Color"));
+        if (color.isValid())
+            setTint(m_tintMode, color);
+    });
+    bgPresetsLayout->addWidget(tintColorBtn);
+
+    QPushButton *themeTintBtn = new QPushButton(tr("Theme Tint"), this);
+    themeTintBtn->setToolTip(tr("Tint with the text color of the background preset"));
+    connect(themeTintBtn, &QPushButton::clicked, this, [this]{
+        setTint(m_tintMode, QColor());
     });
-    bgPresetsLayout->addWidget(ch_customEngine);
+    bgPresetsLayout->addWidget(themeTintBtn);
+
+    QPushButton *statsBtn = new QPushButton(tr("Engine Stats"), this);
+    statsBtn->setToolTip(tr("Render time and cache hit rate per engine since the last reset"));
+    connect(statsBtn, &QPushButton::clicked, this, &SvgGallery::showBackendStats);
+    bgPresetsLayout->addWidget(statsBtn);
 
     bgPresetsLayout->addStretch();
     mainLayout->addLayout(bgPresetsLayout);
@@ -179,20 +332,24 @@ void SvgGallery::initUI()
     m_infoLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
     mainLayout->addWidget(m_infoLabel);
 
-    // Scroll area for gallery
-    m_scrollArea = new QScrollArea(this);
-    m_scrollArea->setWidgetResizable(true);
-    m_scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    m_scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-
-    // Gallery widget
-    m_galleryWidget = new QWidget();
-    m_galleryLayout = new QGridLayout(m_galleryWidget);
-    m_galleryLayout->setSpacing(15);
-    m_galleryLayout->setAlignment(Qt::AlignTop | Qt::AlignLeft);
-
-    m_scrollArea->setWidget(m_galleryWidget);
-    mainLayout->addWidget(m_scrollArea);
+    // One scroll area per folder; addTab() creates them
+    m_tabWidget = new QTabWidget(this);
+    m_tabWidget->setDocumentMode(true);
+    m_tabWidget->setTabsClosable(true);
+    m_tabWidget->setMovable(false); // m_tabs is in tab order
+    QToolButton *newTabBtn = new QToolButton(this);
+    newTabBtn->setText("+");
+    newTabBtn->setToolTip(tr("New tab for another folder (Ctrl+T)"));
+    newTabBtn->setShortcut(QKeySequence::AddTab);
+    connect(newTabBtn, &QToolButton::clicked, this, &SvgGallery::addTab);
+    m_tabWidget->setCornerWidget(newTabBtn, Qt::TopRightCorner);
+    connect(m_tabWidget, &QTabWidget::tabCloseRequested, this, &SvgGallery::closeTab);
+    connect(m_tabWidget, &QTabWidget::currentChanged, this, &SvgGallery::switchTab);
+    QShortcut *closeTabShortcut = new QShortcut(QKeySequence::Close, this);
+    connect(closeTabShortcut, &QShortcut::activated, this, [this] {
+        closeTab(m_tabWidget->currentIndex());
+    });
+    mainLayout->addWidget(m_tabWidget);
 
     m_splitter->addWidget(galleryContainer);
 
@@ -209,20 +366,43 @@ void SvgGallery::initUI()
 
     editorHeaderLayout->addStretch();
 
-    m_saveButton = new QPushButton(tr("Save && Reload"), this);
-    m_saveButton->setToolTip(tr("Save changes and reload SVG"));
+    m_optimizeButton = new QPushButton(tr("Optimize"), this);
+    m_optimizeButton->setToolTip(tr("Optimize the document in the editor (undoable, not saved)"));
+    connect(m_optimizeButton, &QPushButton::clicked, this, &SvgGallery::optimizeCurrentSvg);
+    editorHeaderLayout->addWidget(m_optimizeButton);
+
+    QPushButton *inspectButton = new QPushButton(tr("Inspect"), this);
+    inspectButton->setToolTip(tr("Pan and zoom the saved SVG up to 64×, with an optional pixel grid"));
+    connect(inspectButton, &QPushButton::clicked, this, &SvgGallery::inspectCurrentSvg);
+    editorHeaderLayout->addWidget(inspectButton);
+
+    m_saveButton = new QPushButton(tr("Save"), this);
+    m_saveButton->setToolTip(tr("Save changes and update the preview"));
     connect(m_saveButton, &QPushButton::clicked, this, &SvgGallery::saveSvgContent);
     editorHeaderLayout->addWidget(m_saveButton);
 
     QPushButton *closeEditorBtn = new QPushButton("×", this);
     closeEditorBtn->setFixedSize(24, 24);
     closeEditorBtn->setStyleSheet("font-size: 18px; font-weight: bold;");
-    closeEditorBtn->setToolTip(tr("Close editor"));
+    closeEditorBtn->setToolTip(tr("Close editor; open documents are kept until their tabs are closed"));
     connect(closeEditorBtn, &QPushButton::clicked, this, &SvgGallery::closeEditor);
     editorHeaderLayout->addWidget(closeEditorBtn);
 
     editorLayout->addLayout(editorHeaderLayout);
 
+    // Open documents; switching back to one is instant, nothing is re-read or re-lexed
+    m_documentTabs = new QTabBar(this);
+    m_documentTabs->setDocumentMode(true);
+    m_documentTabs->setTabsClosable(true);
+    m_documentTabs->setExpanding(false);
+    m_documentTabs->setElideMode(Qt::ElideMiddle);
+    connect(m_documentTabs, &QTabBar::currentChanged, this, [this](int index) {
+        if (EditorDocument *document = m_documents.value(index))
+            showDocument(document);
+    });
+    connect(m_documentTabs, &QTabBar::tabCloseRequested, this, &SvgGallery::requestCloseDocument);
+    editorLayout->addWidget(m_documentTabs);
+
     m_editor = nullptr;
 
     QLabel *placeholder = new QLabel(tr("Double-click an SVG to view source"), this);
@@ -235,27 +415,169 @@ void SvgGallery::initUI()
     m_editorContainer->hide();
     m_splitter->setSizes({800, 0});
 
+    // Pixmap cache budget and readout; polled, so painting does not pay for it
+    m_budgetCombo = new QComboBox(this);
+    for (int mib : {16, 32, 64, 128, 256, 512})
+        m_budgetCombo->addItem(tr("%1 MiB pixmap budget").arg(mib), qint64(mib) * 1024 * 1024);
+    const qint64 budget = PixmapCache::instance().budget(); // --pixmap-budget may have set any value
+    if (m_budgetCombo->findData(budget) < 0)
+        m_budgetCombo->addItem(tr("%1 pixmap budget").arg(QLocale().formattedDataSize(budget)), budget);
+    m_budgetCombo->setCurrentIndex(m_budgetCombo->findData(budget));
+    m_budgetCombo->setToolTip(tr("Memory for rendered SVGs and decoded PNGs; items scrolled out of view are evicted first"));
+    connect(m_budgetCombo, &QComboBox::currentIndexChanged, this, [this](int index) {
+        PixmapCache::instance().setBudget(m_budgetCombo->itemData(index).toLongLong());
+        updateCacheStatus();
+    });
+    m_cacheLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(m_cacheLabel);
+    statusBar()->addPermanentWidget(m_budgetCombo);
+    QTimer *cacheTimer = new QTimer(this);
+    connect(cacheTimer, &QTimer::timeout, this, &SvgGallery::updateCacheStatus);
+    cacheTimer->start(500);
+    updateCacheStatus();
+
     updateBackgroundColor();
 }
 
+// ============================================================================
+// Tabs
+// ============================================================================
+
+void SvgGallery::addTab()
+{
+    FolderTab *tab = new FolderTab;
+    tab->scrollArea = new QScrollArea(this);
+    tab->scrollArea->setWidgetResizable(true);
+    tab->scrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    tab->scrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    tab->galleryWidget = new QWidget();
+    tab->galleryLayout = new QGridLayout(tab->galleryWidget);
+    tab->galleryLayout->setSpacing(15);
+    tab->galleryLayout->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+    tab->scrollArea->setWidget(tab->galleryWidget);
+    m_theme.apply(tab->galleryWidget);
+
+    // Tabs load independently; a folder keeps loading in the background
+    tab->loader = new GalleryLoader(this);
+    connect(tab->loader, &GalleryLoader::listed, this, [this, tab](int svgCount, int) {
+        onFolderListed(tab, svgCount);
+    });
+    connect(tab->loader, &GalleryLoader::itemLoaded, this, [this, tab](int index, const GalleryLoader::Item &item) {
+        onItemLoaded(tab, index, item);
+    });
+    connect(tab->loader, &GalleryLoader::finished, this, [this, tab](bool canceled) {
+        onLoadFinished(tab, canceled);
+    });
+
+    m_tabs.append(tab);
+    m_tabWidget->setCurrentIndex(m_tabWidget->addTab(tab->scrollArea, tr("New Tab")));
+    m_pathInput->setFocus();
+}
+
+void SvgGallery::closeTab(int index)
+{
+    // The window always shows a tab; the last one is emptied instead
+    FolderTab *tab = m_tabs.value(index);
+    if (!tab)
+        return;
+    if (m_tabs.size() == 1) {
+        tab->loader->cancel();
+        if (tab == m_sessionTab)
+            cancelSessionValidation();
+        closeDocuments(tab);
+        clearGallery(tab);
+        tab->source.clear();
+        tab->currentPath.clear();
+        tab->folderEntries.clear();
+        m_pathInput->clear();
+        updateTabTitle(tab);
+        showInfo(tr("Load a directory to view SVG files."));
+        return;
+    }
+
+    tab->loader->cancel();
+    delete tab->loader;
+    if (tab == m_sessionTab)
+        cancelSessionValidation();
+    closeDocuments(tab);
+    clearGallery(tab);
+    m_tabs.removeAt(index);
+    m_tabWidget->removeTab(index); // Switches to a neighbor if it was current
+    if (m_tab == tab) {
+        m_tab = nullptr;
+        switchTab(m_tabWidget->currentIndex());
+    }
+    delete tab->scrollArea;
+    delete tab;
+}
+
+void SvgGallery::switchTab(int index)
+{
+    FolderTab *tab = m_tabs.value(index);
+    if (!tab || tab == m_tab)
+        return;
+
+    // Only the controls change; the tab's items are laid out already and
+    // their pixmaps are still in the shared cache
+    if (m_tab)
+        m_tab->pathText = m_pathInput->text();
+    m_tab = tab;
+    {
+        const QSignalBlocker pathBlocker(m_pathInput);
+        const QSignalBlocker filterBlocker(m_filterInput);
+        const QSignalBlocker sortBlocker(m_sortCombo);
+        const QSignalBlocker groupBlocker(m_groupCombo);
+        m_pathInput->setText(tab->pathText);
+        m_filterInput->setText(tab->filterText);
+        m_sortCombo->setCurrentIndex(m_sortCombo->findData(tab->sortKey));
+        m_groupCombo->setCurrentIndex(m_groupCombo->findData(tab->grouping));
+    }
+
+    if (tab->loader->isRunning())
+        showInfo(tr("Loading %1...").arg(tab->loader->source()->displayName()));
+    else if (!tab->comparison.isEmpty())
+        showInfo(tab->comparison);
+    else if (!tab->svgPairs.isEmpty())
+        showInfo(tr("%1 SVG file(s) from: %2").arg(tab->svgPairs.size()).arg(tab->currentPath));
+    else
+        showInfo(tr("Load a directory to view SVG files."));
+}
+
+void SvgGallery::updateTabTitle(FolderTab *tab)
+{
+    const int index = int(m_tabs.indexOf(tab));
+    if (index < 0 || !tab->comparison.isEmpty()) // Comparisons are titled when shown
+        return;
+    const QString name = QFileInfo(tab->currentPath).fileName();
+    m_tabWidget->setTabText(index, name.isEmpty() ? (tab->currentPath.isEmpty() ? tr("New Tab") : tab->currentPath) : name);
+    m_tabWidget->setTabToolTip(index, tab->currentPath);
+}
+
+QList<SvgPair*> SvgGallery::allSvgPairs() const
+{
+    QList<SvgPair*> result;
+    for (const FolderTab *tab : m_tabs)
+        result.append(tab->svgPairs);
+    return result;
+}
+
+void SvgGallery::updateCacheStatus()
+{
+    const QString text = PixmapCache::instance().stats().summary();
+    if (m_cacheLabel->text() != text)
+        m_cacheLabel->setText(text);
+}
+
 void SvgGallery::browseDirectory()
 {
 #ifdef Q_OS_ANDROID
-    if (!m_androidFolder) {
-        m_androidFolder = new AndroidFolder(this);
-        connect(m_androidFolder, &AndroidFolder::ready, this, [this](bool ok) {
-            if (ok) {
-                m_pathInput->setText(m_androidFolder->treeUri());
-                loadSvgs();
-            }
-        });
-    }
-    m_androidFolder->openDialog();
+    androidFolder()->openDialog();
 #else
     QString directory = QFileDialog::getExistingDirectory(
         this,
         tr("Select Directory Containing SVG Files"),
-        m_currentPath.isEmpty() ? QDir::homePath() : m_currentPath);
+        m_tab->currentPath.isEmpty() ? QDir::homePath() : m_tab->currentPath);
 
     if (!directory.isEmpty()) {
         m_pathInput->setText(directory);
@@ -264,6 +586,23 @@ void SvgGallery::browseDirectory()
 #endif
 }
 
+#ifdef Q_OS_ANDROID
+AndroidFolder *SvgGallery::androidFolder()
+{
+    // Comes back with the tree picked in the last run, if it is still granted
+    if (!m_androidFolder) {
+        m_androidFolder = new AndroidFolder(this);
+        connect(m_androidFolder, &AndroidFolder::ready, this, [this](bool ok) {
+            if (ok) {
+                m_pathInput->setText(m_androidFolder->treeUri());
+                loadSvgs();
+            }
+        });
+    }
+    return m_androidFolder;
+}
+#endif
+
 // ============================================================================
 // Message display helpers
 // ============================================================================
@@ -296,236 +635,594 @@ void SvgGallery::showInfo(const QString &message)
 
 void SvgGallery::updateBackgroundColor()
 {
-    QPalette palette = m_galleryWidget->palette();
-    palette.setColor(QPalette::Window, m_backgroundColor);
-    m_galleryWidget->setAutoFillBackground(true);
-    m_galleryWidget->setPalette(palette);
+    // One palette per tab; items inherit it in a single pass
+    m_theme.setBackground(m_backgroundColor);
+    for (FolderTab *tab : std::as_const(m_tabs))
+        m_theme.apply(tab->galleryWidget);
+    if (m_inspector)
+        m_inspector->setBackground(m_backgroundColor);
+}
 
-    // Calculate text color based on background brightness
-    updateTextColors();
+void SvgGallery::clearGallery(FolderTab *tab)
+{
+    // Deleted now, not later, so their pixmaps leave the cache before the next folder fills it
+    qDeleteAll(tab->svgPairs);
+    tab->svgPairs.clear();
+    tab->firstWithContent.clear();
+
+    for (const GalleryGroup &group : std::as_const(tab->groups))
+        delete group.header;
+    tab->groups.clear();
+    qDeleteAll(tab->compareRows);
+    tab->compareRows.clear();
+    tab->comparison.clear();
+    pruneContentIndex();
 }
 
-void SvgGallery::updateTextColors()
+void SvgGallery::pruneContentIndex()
 {
-    // Calculate relative luminance using the formula from WCAG
-    // https://www.w3.org/TR/WCAG20/#relativeluminancedef
-    qreal r = m_backgroundColor.redF();
-    qreal g = m_backgroundColor.greenF();
-    qreal b = m_backgroundColor.blueF();
+    // Results stay while any tab shows their content. Extractions and lint
+    // batches already running are left to finish: other tabs may wait for
+    // them, and what they add for content no longer shown goes next time.
+    QSet<quint64> shown;
+    for (const SvgPair *widget : allSvgPairs())
+        shown.insert(widget->document()->contentHash());
+    for (auto it = m_metadata.begin(); it != m_metadata.end();)
+        it = shown.contains(it.key()) ? std::next(it) : m_metadata.erase(it);
+    for (auto it = m_lint.begin(); it != m_lint.end();)
+        it = shown.contains(it.key()) ? std::next(it) : m_lint.erase(it);
+}
 
-    // Convert to linear RGB
-    auto toLinear = [](qreal c) {
-        return c <= 0.03928 ? c / 12.92 : qPow((c + 0.055) / 1.055, 2.4);
-    };
+FolderSourcePtr SvgGallery::createSource(const QString &path, QString *error)
+{
+    FolderSourcePtr source;
+#ifdef Q_OS_ANDROID
+    // The folder is the picked tree; a path names it only when restoring
+    if (!androidFolder()->isReady() || (!path.isEmpty() && path != m_androidFolder->treeUri())) {
+        *error = tr("Please select a directory first.");
+        return {};
+    }
+    // Served from a local mirror; each load only transfers what changed in the tree
+    source = QSharedPointer<MirroredFolderSource>::create(
+        QSharedPointer<AndroidFolderSource>::create(m_androidFolder),
+        QSharedPointer<LocalFolderSource>::create(MirrorSync::mirrorDirectory(m_androidFolder->treeUri())));
+#else
+    if (path.isEmpty()) {
+        *error = tr("Please enter a directory path.");
+        return {};
+    }
 
-    qreal luminance = 0.2126 * toLinear(r) + 0.7152 * toLinear(g) + 0.0722 * toLinear(b);
-    QColor textColor = luminance > 0.5 ? Qt::black : Qt::white;
+    QDir dir(path);
+    if (!dir.exists()) {
+        *error = tr("Error: Directory does not exist: %1").arg(path);
+        return {};
+    }
+    source = QSharedPointer<LocalFolderSource>::create(path);
+#endif
 
-    for (SvgPair *widget : m_svgPairs) {
-        widget->setTextColor(textColor);
+    // --simulate-latency: behave like slow storage without local paths
+    if (m_simulatedLatencyMs > 0) {
+        SimulatedFolderSource::Latency latency;
+        latency.listMs = 10 * m_simulatedLatencyMs;
+        latency.readMs = m_simulatedLatencyMs;
+        source = QSharedPointer<SimulatedFolderSource>::create(source, latency);
     }
+    return source;
 }
 
-void SvgGallery::clearGallery()
+void SvgGallery::loadSvgs()
 {
-    for (SvgPair *widget : m_svgPairs)
-        widget->deleteLater();
-    m_svgPairs.clear();
+    // A comparison is kept; the folder opens next to it
+    if (!m_tab->comparison.isEmpty()) {
+        const QString path = m_pathInput->text();
+        addTab();
+        m_pathInput->setText(path);
+    }
+
+    QString error;
+    const FolderSourcePtr source = createSource(m_pathInput->text().trimmed(), &error);
+    if (!source) {
+        showError(error);
+        return;
+    }
+
+    // The load replaces whatever the restored session would have become
+    if (m_tab == m_sessionTab)
+        cancelSessionValidation();
+
+    // Listing and reading run on the I/O pool; items are added as they arrive
+    showInfo(tr("Listing %1...").arg(source->displayName()));
+    m_tab->loader->start(source);
 }
 
-void SvgGallery::loadSvgs()
+void SvgGallery::onFolderListed(FolderTab *tab, int svgCount)
 {
-#ifdef Q_OS_ANDROID
-    if (!m_androidFolder || !m_androidFolder->isReady()) {
-        showError(tr("Please select a directory first."));
+    if (svgCount == 0) {
+        if (tab == m_tab)
+            showWarning(tr("No SVG files found in: %1").arg(tab->loader->source()->displayName()));
         return;
     }
 
-    QStringList allFiles = m_androidFolder->fileNames();
-    QStringList svgFiles, allPngFiles;
-    for (const QString &f : allFiles) {
-        if (f.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive))
-            svgFiles.append(f);
-        else if (f.endsWith(QLatin1String(".png"), Qt::CaseInsensitive))
-            allPngFiles.append(f);
-    }
-    svgFiles.sort();
-    allPngFiles.sort();
+    clearGallery(tab);
+    tab->source = tab->loader->source();
+    tab->folderEntries.clear();
+    if (tab == m_tab)
+        showInfo(tr("Loading %1 SVG file(s)...").arg(svgCount));
+}
 
-    if (svgFiles.isEmpty()) {
-        showWarning(tr("No SVG files found."));
-        return;
+void SvgGallery::onItemLoaded(FolderTab *tab, int index, const GalleryLoader::Item &item)
+{
+    if (tab == m_tab) {
+        showInfo(tr("Loading %1 of %2: %3")
+                     .arg(index + 1)
+                     .arg(tab->loader->stats().svgCount)
+                     .arg(item.svgFile));
     }
 
-    // SAFはファイルパスを持たないので、キャッシュディレクトリに一時書き出し
-    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
-                       + QLatin1String("/svggallery/");
-    QDir().mkpath(cacheDir);
+    // The bytes go straight to rendering; content another tab has loaded
+    // already is interned, so it is not parsed or rendered again
+    SvgDocumentPtr document = SvgDocumentPtr::create(svgPath(tab, item.svgFile), item.svgData);
 
-    showInfo(tr("Loading %1 SVG file(s)...").arg(svgFiles.size()));
-    QCoreApplication::processEvents();
-    clearGallery();
+    QList<FolderFile> pngs;
+    for (int i = 0; i < item.pngFiles.size(); ++i)
+        pngs.append(FolderFile{item.pngFiles[i], item.pngData[i]});
 
-    int totalPngsFound = 0;
-    for (int index = 0; index < svgFiles.size(); ++index) {
-        const QString &svgFile = svgFiles[index];
-        showInfo(tr("Loading %1 of %2: %3").arg(index + 1).arg(svgFiles.size()).arg(svgFile));
-        QCoreApplication::processEvents();
+    SvgPair *svgWidget = createSvgPair(document, pngs);
+    tab->galleryLayout->addWidget(svgWidget, index, 0);
+    tab->svgPairs.append(svgWidget);
+    markDuplicate(tab, svgWidget);
+}
 
-        // SVGをキャッシュに書き出す
-        QString svgPath = cacheDir + svgFile;
-        QByteArray svgData = m_androidFolder->read(svgFile);
-        if (!svgData.isEmpty()) {
-            QFile f(svgPath);
-            if (f.open(QIODevice::WriteOnly)) {
-                f.write(svgData);
-                f.close();
-            }
-        }
+QString SvgGallery::svgPath(const FolderTab *tab, const QString &fileName) const
+{
+    // SAF files have no path, so they are named by file name and saved back
+    // through the source
+    const QString path = tab->source ? tab->source->localPath(fileName) : QString();
+    return path.isEmpty() ? fileName : path;
+}
 
-        // PNGのマッチング
-        QString baseName = QFileInfo(svgFile).completeBaseName();
-        QStringList matchingPngs;
-        QRegularExpression pngPattern(
-            QString("^%1(_\\d+)?\\.png$").arg(QRegularExpression::escape(baseName)));
-        for (const QString &pngFile : allPngFiles) {
-            if (pngPattern.match(pngFile).hasMatch()) {
-                QString pngPath = cacheDir + pngFile;
-                QByteArray pngData = m_androidFolder->read(pngFile);
-                if (!pngData.isEmpty()) {
-                    QFile f(pngPath);
-                    if (f.open(QIODevice::WriteOnly)) {
-                        f.write(pngData);
-                        f.close();
-                    }
-                }
-                matchingPngs.append(pngPath);
-            }
-        }
-        totalPngsFound += matchingPngs.size();
+SvgPair *SvgGallery::createSvgPair(const SvgDocumentPtr &document, const QList<FolderFile> &pngs)
+{
+    SvgPair *svgWidget = new SvgPair(document, pngs, m_iconSize, m_backends, m_pixelRatios, this);
+    svgWidget->setTint(m_tintMode, m_tintColor);
+    queueLint(svgWidget);
+    startLint();
+    connect(svgWidget, &SvgPair::doubleClicked, this, &SvgGallery::showSvgContent);
+    return svgWidget;
+}
+
+void SvgGallery::markDuplicate(FolderTab *tab, SvgPair *widget)
+{
+    // Identical bytes already share one parsed document and its rasters
+    // (see SvgContent); the gallery only has to say so within a folder
+    SvgPair *&first = tab->firstWithContent[widget->document()->contentHash()];
+    if (!first)
+        first = widget;
+    if (first != widget && first->document()->content() == widget->document()->content())
+        widget->setDuplicateOf(QFileInfo(first->svgPath()).fileName());
+    else
+        widget->setDuplicateOf(QString());
+}
 
-        SvgPair *svgWidget = new SvgPair(svgPath, matchingPngs, m_iconSize, m_customEngine, this);
-        connect(svgWidget, &SvgPair::doubleClicked, this, &SvgGallery::showSvgContent);
-        m_galleryLayout->addWidget(svgWidget, index, 0);
-        m_svgPairs.append(svgWidget);
+void SvgGallery::updateDuplicates(FolderTab *tab)
+{
+    // Edits move a file to other content, so recompute from the start
+    tab->firstWithContent.clear();
+    for (SvgPair *widget : std::as_const(tab->svgPairs))
+        markDuplicate(tab, widget);
+}
+
+void SvgGallery::onLoadFinished(FolderTab *tab, bool canceled)
+{
+    const GalleryLoader::Stats &stats = tab->loader->stats();
+    if (canceled || stats.svgCount == 0)
+        return;
+
+    const QString folder = tab->source->displayName();
+    tab->currentPath = folder;
+    updateTabTitle(tab);
+    for (const FolderEntry &entry : tab->loader->entries())
+        tab->folderEntries.insert(entry.name, entry);
+
+    // Content the other tabs show too: parsed and rendered once for all of them
+    QSet<quint64> elsewhere;
+    for (const FolderTab *other : std::as_const(m_tabs)) {
+        if (other == tab)
+            continue;
+        for (const SvgPair *widget : other->svgPairs)
+            elsewhere.insert(widget->document()->contentHash());
+    }
+    int duplicates = 0;
+    int shared = 0;
+    for (SvgPair *widget : std::as_const(tab->svgPairs)) {
+        if (!widget->duplicateOf().isEmpty())
+            ++duplicates;
+        if (elsewhere.contains(widget->document()->contentHash()))
+            ++shared;
     }
 
-    m_currentPath = m_androidFolder->treeUri();
-    QString message = tr("Loaded %1 SVG file(s)").arg(svgFiles.size());
-    if (totalPngsFound > 0)
-        message += tr(" with %1 corresponding PNG(s)").arg(totalPngsFound);
-    showSuccess(message);
-    updateTextColors();
+    if (tab == m_tab) {
+        QString message = tr("Loaded %1 SVG file(s)").arg(stats.svgCount);
+        if (stats.pngCount > 0)
+            message += tr(" with %1 corresponding PNG(s)").arg(stats.pngCount);
+        message += tr(" from: %1").arg(folder);
+        if (duplicates > 0)
+            message += tr("\n%1 duplicate(s) share the content of another file").arg(duplicates);
+        if (shared > 0)
+            message += tr("\n%1 SVG(s) are identical to ones in other tabs and share their renders").arg(shared);
+        showSuccess(message);
+    }
+    qDebug() << "Loaded" << stats.svgCount << "items in" << stats.totalNs / 1e6 << "ms,"
+             << "first after" << stats.firstItemNs / 1e6 << "ms,"
+             << stats.filesRead << "files /" << stats.bytesRead << "bytes read,"
+             << shared << "shared with other tabs";
+    updateMetadata();
+    if (tab == m_tab)
+        saveSession();
+}
 
-#else
-    // ── デスクトップ（既存コード） ────────────────────────────
-    QString path = m_pathInput->text().trimmed();
-    if (path.isEmpty()) {
-        showError(tr("Please enter a directory path."));
+void SvgGallery::updateMetadata()
+{
+    // One extraction at a time; whatever changes meanwhile is picked up after it
+    if (m_metadataWatcher.isRunning()) {
+        m_metadataStale = true;
         return;
     }
 
-    QDir dir(path);
-    if (!dir.exists()) {
-        showError(tr("Error: Directory does not exist: %1").arg(path));
+    QList<QByteArray> data;
+    QSet<quint64> queued;
+    m_metadataHashes.clear();
+    for (SvgPair *widget : allSvgPairs()) {
+        const quint64 hash = widget->document()->contentHash();
+        if (m_metadata.contains(hash) || queued.contains(hash))
+            continue;
+        queued.insert(hash);
+        m_metadataHashes.append(hash);
+        data.append(widget->document()->data());
+    }
+    if (!data.isEmpty())
+        m_metadataWatcher.setFuture(SvgMetadata::extractAsync(data));
+}
+
+void SvgGallery::onMetadataReady()
+{
+    if (m_metadataWatcher.isCanceled())
         return;
+
+    const QList<SvgMetadata> results = m_metadataWatcher.future().results();
+    for (qsizetype i = 0; i < results.size() && i < m_metadataHashes.size(); ++i)
+        m_metadata.insert(m_metadataHashes[i], results[i]);
+    m_metadataHashes.clear();
+
+    for (SvgPair *widget : allSvgPairs()) {
+        const auto it = m_metadata.constFind(widget->document()->contentHash());
+        if (it != m_metadata.constEnd())
+            widget->setDetails(it->summary());
+    }
+
+    if (std::exchange(m_metadataStale, false))
+        updateMetadata();
+    for (FolderTab *tab : std::as_const(m_tabs)) {
+        if (tab->sortKey != SortByName || tab->grouping != NoGrouping)
+            arrangeGallery(tab);
     }
+}
 
-    QStringList svgFiles = dir.entryList(QStringList("*.svg"), QDir::Files, QDir::Name);
-    if (svgFiles.isEmpty()) {
-        showWarning(tr("No SVG files found in: %1").arg(path));
+void SvgGallery::queueLint(SvgPair *widget)
+{
+    const quint64 hash = widget->document()->contentHash();
+    const auto it = m_lint.constFind(hash);
+    if (it != m_lint.constEnd()) {
+        widget->setLint(*it);
         return;
     }
+    if (m_lintQueued.contains(hash))
+        return;
+    m_lintQueued.insert(hash);
+    m_lintPending.append(hash);
+    m_lintPendingData.append(widget->document()->data());
+}
 
-    showInfo(tr("Loading %1 SVG file(s)...").arg(svgFiles.size()));
-    QCoreApplication::processEvents();
+void SvgGallery::startLint()
+{
+    // One batch at a time; items created meanwhile form the next one
+    if (m_lintWatcher.isRunning() || m_lintPending.isEmpty())
+        return;
+    m_lintHashes = std::exchange(m_lintPending, {});
+    m_lintWatcher.setFuture(SvgLint::runAsync(std::exchange(m_lintPendingData, {})));
+}
 
-    QStringList allPngFiles = dir.entryList(QStringList("*.png"), QDir::Files, QDir::Name);
-    clearGallery();
+void SvgGallery::onLintFinished()
+{
+    if (m_lintWatcher.isCanceled())
+        return;
 
-    int totalPngsFound = 0;
-    for (int index = 0; index < svgFiles.size(); ++index) {
-        showInfo(tr("Loading %1 of %2: %3")
-                     .arg(index + 1)
-                     .arg(svgFiles.size())
-                     .arg(svgFiles[index]));
-        QCoreApplication::processEvents();
+    const QList<SvgLint::Report> results = m_lintWatcher.future().results();
+    QSet<quint64> done;
+    for (qsizetype i = 0; i < results.size() && i < m_lintHashes.size(); ++i) {
+        m_lint.insert(m_lintHashes[i], results[i]);
+        m_lintQueued.remove(m_lintHashes[i]);
+        done.insert(m_lintHashes[i]);
+    }
+    m_lintHashes.clear();
 
-        QString svgFile = svgFiles[index];
-        QString svgPath = dir.absoluteFilePath(svgFile);
-        QFileInfo svgInfo(svgFile);
-        QString baseName = svgInfo.completeBaseName();
-
-        QStringList matchingPngs;
-        QRegularExpression pngPattern(
-            QString("^%1(_\\d+)?\\.png$").arg(QRegularExpression::escape(baseName)));
-        for (const QString &pngFile : allPngFiles) {
-            if (pngPattern.match(pngFile).hasMatch())
-                matchingPngs.append(dir.absoluteFilePath(pngFile));
-        }
-        totalPngsFound += matchingPngs.size();
+    for (SvgPair *widget : allSvgPairs()) {
+        const quint64 hash = widget->document()->contentHash();
+        if (done.contains(hash))
+            widget->setLint(m_lint.value(hash));
+    }
 
-        SvgPair *svgWidget = new SvgPair(svgPath, matchingPngs, m_iconSize, m_customEngine, this);
-        connect(svgWidget, &SvgPair::doubleClicked, this, &SvgGallery::showSvgContent);
-        m_galleryLayout->addWidget(svgWidget, index, 0);
-        m_svgPairs.append(svgWidget);
+    startLint();
+    if (m_lintWatcher.isRunning() || m_tab->loader->isRunning())
+        return;
+    int flagged = 0;
+    for (SvgPair *widget : std::as_const(m_tab->svgPairs)) {
+        if (!m_lint.value(widget->document()->contentHash()).isClean())
+            ++flagged;
     }
+    if (flagged > 0) {
+        statusBar()->showMessage(tr("%1 of %2 SVG(s) use constructs that are slow to render; see the badges")
+                                     .arg(flagged).arg(m_tab->svgPairs.size()), 10000);
+    }
+}
 
-    m_currentPath = path;
-    QString message = tr("Loaded %1 SVG file(s)").arg(svgFiles.size());
-    if (totalPngsFound > 0)
-        message += tr(" with %1 corresponding PNG(s)").arg(totalPngsFound);
-    message += tr(" from: %1").arg(path);
+int SvgGallery::groupOf(const SvgMetadata *metadata, int grouping) const
+{
+    // The last group of each grouping collects what has no metadata (yet)
+    switch (grouping) {
+    case GroupByAspectRatio: {
+        const float ratio = metadata ? metadata->aspectRatio() : 0;
+        if (ratio <= 0)
+            return 3;
+        return ratio > 1.05f ? 1 : ratio < 0.95f ? 2 : 0;
+    }
+    case GroupByComplexity: {
+        if (!metadata || !metadata->isValid())
+            return 4;
+        const int complexity = metadata->complexity();
+        return complexity < 16 ? 0 : complexity < 128 ? 1 : complexity < 1024 ? 2 : 3;
+    }
+    case GroupByEffects:
+        if (!metadata || !metadata->isValid())
+            return 6;
+        if (metadata->has(SvgMetadata::UsesFilters))
+            return 0;
+        if (metadata->has(SvgMetadata::UsesMasks) || metadata->has(SvgMetadata::UsesClipPaths))
+            return 1;
+        if (metadata->has(SvgMetadata::UsesGradients))
+            return 2;
+        if (metadata->has(SvgMetadata::UsesText))
+            return 3;
+        if (metadata->has(SvgMetadata::UsesImages))
+            return 4;
+        return 5;
+    case GroupByGeometry:
+        if (!metadata || !metadata->isValid())
+            return 4;
+        if (metadata->has(SvgMetadata::ExceedsViewBox))
+            return 0;
+        if (metadata->has(SvgMetadata::OffPixelGrid))
+            return 1;
+        if (metadata->has(SvgMetadata::PathErrors))
+            return 2;
+        return 3;
+    default:
+        return 0;
+    }
+}
 
-    showSuccess(message);
-    updateTextColors();
-#endif
+QString SvgGallery::groupName(int grouping, int group) const
+{
+    static const char *const aspectRatio[] = {
+        QT_TR_NOOP("Square"), QT_TR_NOOP("Wide"), QT_TR_NOOP("Tall"), QT_TR_NOOP("Unknown size")};
+    static const char *const complexity[] = {
+        QT_TR_NOOP("Simple (under 16 elements and segments)"), QT_TR_NOOP("Moderate (16 to 127)"),
+        QT_TR_NOOP("Complex (128 to 1023)"), QT_TR_NOOP("Very complex (1024 or more)"), QT_TR_NOOP("Not analyzed")};
+    static const char *const effects[] = {
+        QT_TR_NOOP("Uses filters"), QT_TR_NOOP("Uses masks or clip paths"), QT_TR_NOOP("Uses gradients"),
+        QT_TR_NOOP("Uses text"), QT_TR_NOOP("Embeds images"), QT_TR_NOOP("Plain shapes"), QT_TR_NOOP("Not analyzed")};
+    static const char *const geometry[] = {
+        QT_TR_NOOP("Drawn outside the viewBox"), QT_TR_NOOP("Off the pixel grid"), QT_TR_NOOP("Broken path data"),
+        QT_TR_NOOP("Clean geometry"), QT_TR_NOOP("Not analyzed")};
+
+    switch (grouping) {
+    case GroupByAspectRatio:
+        return tr(aspectRatio[group]);
+    case GroupByComplexity:
+        return tr(complexity[group]);
+    case GroupByEffects:
+        return tr(effects[group]);
+    case GroupByGeometry:
+        return tr(geometry[group]);
+    default:
+        return QString();
+    }
 }
 
-void SvgGallery::updateIconSizes()
+void SvgGallery::arrangeGallery(FolderTab *tab)
 {
-    if (m_svgPairs.isEmpty())
+    // Items still arriving take rows in load order; the gallery is arranged
+    // again once their metadata is in
+    if (tab->loader->isRunning())
         return;
 
-    // Calculate the relative scroll position before resize
-    QScrollBar *vScrollBar = m_scrollArea->verticalScrollBar();
-    double scrollRatio = 0.0;
-    if (vScrollBar->maximum() > 0) {
-        scrollRatio = static_cast<double>(vScrollBar->value()) / vScrollBar->maximum();
+    QElapsedTimer timer;
+    timer.start();
+    const int sortKey = tab->sortKey;
+    const int grouping = tab->grouping;
+
+    // Keys are gathered into one flat array first, so sorting does not chase
+    // pointers; the stable sort keeps name order among equal keys
+    struct Entry {
+        int group;
+        float key;
+        SvgPair *widget;
+    };
+    QList<Entry> entries;
+    entries.reserve(tab->svgPairs.size());
+    constexpr float kUnknown = std::numeric_limits<float>::max(); // Sorts last
+    for (SvgPair *widget : std::as_const(tab->svgPairs)) {
+        const auto it = m_metadata.constFind(widget->document()->contentHash());
+        const SvgMetadata *metadata = it != m_metadata.constEnd() ? &*it : nullptr;
+        float key = 0;
+        if (sortKey != SortByName) {
+            key = kUnknown;
+            if (metadata && sortKey == SortBySize)
+                key = -float(metadata->fileSize);
+            else if (metadata && metadata->isValid() && sortKey == SortByComplexity)
+                key = -float(metadata->complexity());
+            else if (metadata && metadata->aspectRatio() > 0 && sortKey == SortByAspectRatio)
+                key = -metadata->aspectRatio();
+        }
+        entries.append({groupOf(metadata, grouping), key, widget});
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.group != b.group ? a.group < b.group : a.key < b.key;
+    });
+    const qint64 sortNs = timer.nsecsElapsed();
+
+    for (SvgPair *widget : std::as_const(tab->svgPairs))
+        tab->galleryLayout->removeWidget(widget);
+    for (const GalleryGroup &group : std::as_const(tab->groups))
+        delete group.header;
+    tab->groups.clear();
+
+    int row = 0;
+    for (qsizetype i = 0; i < entries.size(); ++i) {
+        if (grouping != NoGrouping && (i == 0 || entries[i].group != entries[i - 1].group)) {
+            QLabel *header = new QLabel(tab->galleryWidget);
+            header->setStyleSheet("font-weight: bold; padding: 5px;");
+            tab->galleryLayout->addWidget(header, row++, 0);
+            tab->groups.append({header, groupName(grouping, entries[i].group), {}});
+        }
+        tab->galleryLayout->addWidget(entries[i].widget, row++, 0);
+        if (!tab->groups.isEmpty())
+            tab->groups.last().items.append(entries[i].widget);
+    }
+    updateGroupHeaders(tab);
+    qDebug() << "Arranged" << entries.size() << "items: sorted in" << sortNs / 1e6 << "ms, laid out in"
+             << (timer.nsecsElapsed() - sortNs) / 1e6 << "ms";
+}
+
+void SvgGallery::updateGroupHeaders(const FolderTab *tab)
+{
+    // Headers count what the filter lets through and hide when that is nothing
+    for (const GalleryGroup &group : tab->groups) {
+        const qsizetype visible = std::count_if(group.items.cbegin(), group.items.cend(), [](const SvgPair *widget) {
+            return !widget->isHidden();
+        });
+        group.header->setText(tr("%1 (%2)").arg(group.name).arg(visible));
+        group.header->setVisible(visible > 0);
     }
+}
 
-    // Update icon sizes
-    for (SvgPair *widget : m_svgPairs)
-        widget->setIconSize(m_iconSize);
+void SvgGallery::updateIconSizes()
+{
+    // Every tab, so switching to another one does not have to catch up.
+    // Tabs may open or close while events are processed below, so the
+    // scroll areas are remembered rather than their tabs' indexes.
+    QList<QPair<QPointer<QScrollArea>, double>> scrollRatios;
+    for (const FolderTab *tab : std::as_const(m_tabs)) {
+        // Calculate the relative scroll position before resize
+        const QScrollBar *vScrollBar = tab->scrollArea->verticalScrollBar();
+        scrollRatios.append({tab->scrollArea,
+                             vScrollBar->maximum() > 0 ? double(vScrollBar->value()) / vScrollBar->maximum() : 0.0});
+
+        for (SvgPair *widget : tab->svgPairs)
+            widget->setIconSize(m_iconSize);
+        tab->galleryWidget->updateGeometry();
+    }
 
     // Force layout update
-    m_galleryWidget->updateGeometry();
     QCoreApplication::processEvents();
 
-    // Restore the relative scroll position
-    if (vScrollBar->maximum() > 0) {
-        vScrollBar->setValue(static_cast<int>(scrollRatio * vScrollBar->maximum()));
+    // Restore the relative scroll positions
+    for (const auto &[scrollArea, ratio] : std::as_const(scrollRatios)) {
+        if (!scrollArea)
+            continue;
+        QScrollBar *vScrollBar = scrollArea->verticalScrollBar();
+        if (vScrollBar->maximum() > 0)
+            vScrollBar->setValue(static_cast<int>(ratio * vScrollBar->maximum()));
+    }
+}
+
+void SvgGallery::setBackends(const QList<RenderBackend*> &backends)
+{
+    m_backends = backends;
+    for (RenderBackend *backend : RenderBackendRegistry::instance().backends())
+        backend->resetStats();
+
+    // Icons are recreated in place, the gallery itself is not rebuilt
+    for (SvgPair *widget : allSvgPairs())
+        widget->setBackends(m_backends);
+}
+
+void SvgGallery::setPixelRatios(const QList<qreal> &pixelRatios)
+{
+    m_pixelRatios = pixelRatios;
+    for (SvgPair *widget : allSvgPairs())
+        widget->setPixelRatios(m_pixelRatios);
+}
+
+void SvgGallery::setTint(IconTint::Mode mode, const QColor &color)
+{
+    m_tintMode = mode;
+    m_tintColor = color;
+    // Items only repaint; each composites from its cached mask when shown
+    for (SvgPair *widget : allSvgPairs())
+        widget->setTint(m_tintMode, m_tintColor);
+}
+
+void SvgGallery::showBackendStats()
+{
+    QStringList lines;
+    for (RenderBackend *backend : RenderBackendRegistry::instance().backends()) {
+        const RenderBackend::Stats &stats = backend->stats();
+        lines.append(tr("%1: %2 render(s), %3 ms avg, %4 ms total, %5 cache hit(s), %6% hit rate")
+                         .arg(backend->name())
+                         .arg(stats.renders)
+                         .arg(stats.averageMs(), 0, 'f', 3)
+                         .arg(stats.renderNs / 1e6, 0, 'f', 1)
+                         .arg(stats.hits)
+                         .arg(stats.hitRate() * 100, 0, 'f', 1));
     }
+    showInfo(lines.join('\n'));
 }
 
 void SvgGallery::filterGallery()
 {
-    QString filterText = m_filterInput->text().trimmed();
+    m_tab->filterText = m_filterInput->text();
+    const QString filterText = m_tab->filterText.trimmed();
+    const int visibleCount = applyFilter(m_tab);
+    const qsizetype total = m_tab->svgPairs.size() + qMax<qsizetype>(0, m_tab->compareRows.size() - 1);
+
+    if (!filterText.isEmpty()) {
+        showInfo(tr("Showing %1 of %2 items matching '%3'")
+                     .arg(visibleCount).arg(total).arg(filterText));
+    } else if (total > 0) {
+        showSuccess(tr("Showing all %1 items").arg(total));
+    }
+}
+
+int SvgGallery::applyFilter(const FolderTab *tab)
+{
+    const QString filterText = tab->filterText.trimmed();
     int visibleCount = 0;
 
-    for (SvgPair *widget : m_svgPairs) {
+    for (SvgPair *widget : tab->svgPairs) {
         QFileInfo fileInfo(widget->svgPath());
         bool matches = filterText.isEmpty() || fileInfo.fileName().contains(filterText, Qt::CaseInsensitive);
         widget->setVisible(matches);
         if (matches) visibleCount++;
     }
-
-    if (!filterText.isEmpty()) {
-        showInfo(tr("Showing %1 of %2 items matching '%3'")
-                     .arg(visibleCount).arg(m_svgPairs.size()).arg(filterText));
-    } else if (!m_svgPairs.isEmpty()) {
-        showSuccess(tr("Showing all %1 items").arg(m_svgPairs.size()));
+    // Comparison rows are named after their files, both names for a rename
+    for (qsizetype i = 1; i < tab->compareRows.size(); ++i) {
+        bool matches = filterText.isEmpty() || tab->compareRows[i]->objectName().contains(filterText, Qt::CaseInsensitive);
+        tab->compareRows[i]->setVisible(matches);
+        if (matches) visibleCount++;
     }
+    updateGroupHeaders(tab);
+    return visibleCount;
 }
 
 void SvgGallery::setupScintilla()
@@ -572,24 +1269,40 @@ void SvgGallery::setupScintilla()
     m_editor->set_wrap_mode(ScintillaRelay::WrapWord);              // 単語境界でラップ
     m_editor->set_wrap_indent_mode(ScintillaRelay::WrapIndentSame);  // 元の行と同じインデント
     m_editor->set_wrap_visual_flags(ScintillaRelay::WrapVisualFlagEnd);  // 行末にインジケータ表示
+
+    // Style only what is painted; the rest is lexed in idle time, and
+    // edits re-lex from the damaged line onwards (Scintilla's end-styled mark)
+    m_editor->set_idle_styling(ScintillaRelay::IdleStylingAfterVisible);
+
+    // Lint findings: a translucent box over the offending start tag, and
+    // what it costs in an annotation below its line
+    m_editor->indic_set_style(kLintWarningIndicator, 8);  // INDIC_STRAIGHTBOX
+    m_editor->indic_set_fore(kLintWarningIndicator, RGB(230, 160, 30));
+    m_editor->indic_set_alpha(kLintWarningIndicator, 60);
+    m_editor->indic_set_style(kLintSevereIndicator, 8);
+    m_editor->indic_set_fore(kLintSevereIndicator, RGB(220, 60, 50));
+    m_editor->indic_set_alpha(kLintSevereIndicator, 80);
+    m_editor->style_set_fore(kLintAnnotationStyle, RGB(230, 190, 120));
+    m_editor->style_set_back(kLintAnnotationStyle, RGB(60, 50, 35));
+    m_editor->style_set_size(kLintAnnotationStyle, 9);
+    m_editor->annotation_set_visible(2);                   // ANNOTATION_BOXED
+
+    // Styles belong to the view and are configured once per editor; the
+    // lexer belongs to each document, see setXMLLexer()
+    applyXMLHighlighting();
 }
 
-void SvgGallery::applyXMLHighlighting()
+bool SvgGallery::setXMLLexer()
 {
-    if (!m_editor || !m_editor->is_available()) {
-        showError(tr("applyXMLHighlighting: No Editor: %1").arg(m_editor->error_string()));
-        return;
-    }
-
     if (!m_editor->is_lexilla_available()) {
         showError(tr(
-            "applyXMLHighlighting: No Lexilla: %1").arg(m_editor->error_string()));
-        return;
+            "setXMLLexer: No Lexilla: %1").arg(m_editor->error_string()));
+        return false;
     }
 
     if (!m_editor->set_lexer("xml")) {
         showError("Failed to set XML lexer");
-        return;
+        return false;
     }
 
     m_editor->set_keywords(0,
@@ -604,6 +1317,15 @@ void SvgGallery::applyXMLHighlighting()
         "transform translate rotate scale matrix id class style "
         "points stroke-linecap stroke-linejoin stroke-dasharray "
         "gradientTransform gradientUnits offset stop-color stop-opacity");
+    return true;
+}
+
+void SvgGallery::applyXMLHighlighting()
+{
+    if (!m_editor || !m_editor->is_available()) {
+        showError(tr("applyXMLHighlighting: No Editor: %1").arg(m_editor->error_string()));
+        return;
+    }
 
     auto RGB = [](int r, int g, int b) {
         return ((unsigned long)(((unsigned char)(r)|((unsigned short)((unsigned char)(g))<<8))|(((unsigned long)(unsigned char)(b))<<16)));
@@ -626,97 +1348,791 @@ void SvgGallery::applyXMLHighlighting()
     m_editor->style_set_bold(11, true);
     m_editor->style_set_fore(12, RGB(204, 120, 50));
 
-    m_editor->colorize(0, -1);
-    qDebug() << "XML syntax highlighting applied";
+    qDebug() << "XML syntax highlighting configured";
 }
 
-void SvgGallery::showSvgContent(const QString &svgPath)
+void SvgGallery::colorizeVisibleRange()
 {
-    m_currentSvgPath = svgPath;
+    if (!m_editor || !m_editor->is_available())
+        return;
 
+    // Visible lines plus a margin on both sides, so short scrolls are already styled
+    constexpr int kMarginLines = 100;
+    const int firstLine = m_editor->doc_line_from_visible(m_editor->first_visible_line());
+    const int startLine = qMax(0, firstLine - kMarginLines);
+    const int endLine = qMin(m_editor->line_count(),
+                             firstLine + m_editor->lines_on_screen() + kMarginLines);
+
+    m_editor->colorize(m_editor->position_from_line(startLine),
+                       m_editor->position_from_line(endLine));
+}
+
+void SvgGallery::markLintFindings()
+{
+    if (!m_editor || !m_editor->is_available())
+        return;
+
+    // Linted from the buffer, so the marks match what is being edited
+    const QByteArray text = m_editor->text();
+    const SvgLint::Report report = SvgLint::run(text);
+    for (int indicator : {kLintWarningIndicator, kLintSevereIndicator}) {
+        m_editor->set_indicator_current(indicator);
+        m_editor->indicator_clear_range(0, int(text.size()));
+    }
+    m_editor->annotation_clear_all();
+
+    QMap<int, QStringList> notes; // By line
+    for (const SvgLint::Finding &finding : report.findings) {
+        m_editor->set_indicator_current(finding.severity == SvgLint::Severe ? kLintSevereIndicator : kLintWarningIndicator);
+        m_editor->indicator_fill_range(finding.offset, finding.length);
+        notes[m_editor->line_from_position(finding.offset)].append(
+            QString("⚠ %1 (~%2): %3").arg(SvgLint::ruleName(finding.rule)).arg(qRound(finding.cost)).arg(finding.message));
+    }
+    for (auto it = notes.cbegin(); it != notes.cend(); ++it) {
+        m_editor->annotation_set_text(it.key(), it->join(QLatin1Char('\n')).toUtf8().constData());
+        m_editor->annotation_set_style(it.key(), kLintAnnotationStyle);
+    }
+}
+
+void SvgGallery::showSvgContent(const QString &svgPath)
+{
     if (!m_editor) {
         m_editor = new ScintillaRelay(m_editorContainer);
-        QLayoutItem *item = m_editorContainer->layout()->itemAt(1);
+        // After the header and the document tabs
+        QLayoutItem *item = m_editorContainer->layout()->itemAt(2);
         if (item && item->widget()) {
             item->widget()->deleteLater();
         }
         qobject_cast<QVBoxLayout*>(m_editorContainer->layout())->addWidget(m_editor);
         setupScintilla();
+
+        // Scintilla's save point left or reached: the tab being edited shows
+        // whether it has unsaved changes as they happen
+        connect(m_editor, &ScintillaRelay::save_point_changed, this, [this](bool dirty) {
+            if (!m_document)
+                return;
+            m_document->modified = dirty;
+            updateDocumentTab(m_document);
+        });
     }
+    if (!m_editor->is_available())
+        return;
 
-    QFile file(svgPath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        qDebug() << "Failed to open SVG file:" << svgPath;
+    // Double-clicked, so in the current tab; the gallery already holds the bytes
+    SvgPair *widget = findSvgPair(m_tab, svgPath);
+    if (!widget) {
+        qDebug() << "SVG not in gallery:" << svgPath;
         return;
     }
+    const QByteArray data = widget->document()->data();
+    const quint64 hash = widget->document()->contentHash();
+
+    EditorDocument *document = findDocument(m_tab, svgPath);
+    if (document) {
+        // Still lexed, with its caret and undo history; only content written
+        // behind its back (Optimize All, a restored session) is taken over,
+        // and never over unsaved edits
+        showDocument(document);
+        if (hash != document->savedHash && !isModified(document)) {
+            // One undo step back to what was there, not an empty buffer
+            m_editor->begin_undo_action();
+            m_editor->clear_all();
+            m_editor->insert_text(0, data.constData());
+            m_editor->end_undo_action();
+            m_editor->set_save_point();
+            document->savedHash = hash;
+            colorizeVisibleRange();
+            markLintFindings();
+        }
+    } else {
+        document = new EditorDocument;
+        // One reference for the gallery; the editor holds another while showing it
+        document->doc = m_editor->create_document(data.size(), 0);
+        document->svgPath = svgPath;
+        document->tab = m_tab;
+        document->source = m_tab->source;
+        document->savedHash = hash;
+        document->bytes = 2 * qint64(data.size());
+        m_documents.append(document);
+        {
+            const QSignalBlocker blocker(m_documentTabs);
+            m_documentTabs->addTab(QString());
+        }
+        updateDocumentTab(document);
+        showDocument(document);
+
+        // Always editable; loading is not an edit to undo
+        setXMLLexer();
+        m_editor->set_readonly(false);
+        m_editor->insert_text(0, data.constData());
+        m_editor->empty_undo_buffer();
+        m_editor->set_save_point();
+        m_editor->goto_pos(0);
+        colorizeVisibleRange();
+        markLintFindings();
+    }
+
+    if (!m_editorVisible) {
+        m_editorContainer->show();
+        m_splitter->setSizes({500, 400});
+        m_editorVisible = true;
+    }
+    trimDocuments();
+}
 
-    QString content = file.readAll();
-    file.close();
+SvgGallery::EditorDocument *SvgGallery::findDocument(const FolderTab *tab, const QString &svgPath) const
+{
+    for (EditorDocument *document : m_documents) {
+        if (document->tab == tab && document->svgPath == svgPath)
+            return document;
+    }
+    return nullptr;
+}
 
-    QFileInfo fileInfo(svgPath);
-    m_editorTitle->setText(tr("SVG Source: %1").arg(fileInfo.fileName()));
+void SvgGallery::showDocument(EditorDocument *document)
+{
+    document->lastUsed = ++m_documentClock;
+    {
+        const QSignalBlocker blocker(m_documentTabs);
+        m_documentTabs->setCurrentIndex(m_documents.indexOf(document));
+    }
+    m_editorTitle->setText(tr("SVG Source: %1").arg(QFileInfo(document->svgPath).fileName()));
+    if (document == m_document)
+        return;
 
-    // Always editable
-    m_editor->set_readonly(false);
-    m_editor->clear_all();
+    // Caret and scroll are the view's; everything else stays with the document
+    if (m_document) {
+        m_document->caret = m_editor->current_pos();
+        m_document->anchor = m_editor->anchor();
+        m_document->firstLine = m_editor->first_visible_line();
+        m_document->modified = m_editor->modify();
+        m_document->bytes = 2 * qint64(m_editor->length());
+        updateDocumentTab(m_document);
+    }
+    m_document = document;
+    m_editor->set_doc_pointer(document->doc);
+    m_editor->set_sel(document->anchor, document->caret);
+    m_editor->set_first_visible_line(document->firstLine);
+    document->modified = m_editor->modify();
+    updateDocumentTab(document);
+
+    // Styled already where it was shown before, so this is usually free
+    colorizeVisibleRange();
+}
 
-    QByteArray utf8 = content.toUtf8();
-    m_editor->insert_text(0, utf8.constData());
+void SvgGallery::closeDocument(EditorDocument *document)
+{
+    const int index = m_documents.indexOf(document);
+    if (index < 0)
+        return;
 
-    applyXMLHighlighting();
-    m_editor->goto_pos(0);
+    if (document == m_document) {
+        // The most recently used other one takes its place
+        EditorDocument *next = nullptr;
+        for (EditorDocument *other : std::as_const(m_documents)) {
+            if (other != document && (!next || other->lastUsed > next->lastUsed))
+                next = other;
+        }
+        if (next) {
+            showDocument(next);
+        } else {
+            m_editor->set_doc_pointer(0); // A new empty one, so this one is let go
+            m_document = nullptr;
+            m_editorTitle->setText(tr("SVG Source"));
+            closeEditor();
+        }
+    }
 
-    if (!m_editorVisible) {
-        m_editorContainer->show();
-        m_splitter->setSizes({500, 400});
-        m_editorVisible = true;
+    m_documents.removeAt(index);
+    {
+        const QSignalBlocker blocker(m_documentTabs);
+        m_documentTabs->removeTab(index);
+    }
+    // The editor does not hold it any more, so this frees it
+    m_editor->release_document(document->doc);
+    delete document;
+}
+
+void SvgGallery::closeDocuments(const FolderTab *tab)
+{
+    // Unsaved changes go with the tab, as they did with the single document
+    const QList<EditorDocument*> documents = m_documents;
+    for (EditorDocument *document : documents) {
+        if (document->tab == tab)
+            closeDocument(document);
+    }
+}
+
+void SvgGallery::requestCloseDocument(int index)
+{
+    EditorDocument *document = m_documents.value(index);
+    if (!document)
+        return;
+
+    if (isModified(document)) {
+        const auto answer = QMessageBox::question(
+            this, tr("Close"),
+            tr("Discard unsaved changes to %1?").arg(QFileInfo(document->svgPath).fileName()),
+            QMessageBox::Discard | QMessageBox::Cancel, QMessageBox::Cancel);
+        if (answer != QMessageBox::Discard)
+            return;
+    }
+    closeDocument(document);
+}
+
+bool SvgGallery::isModified(const EditorDocument *document) const
+{
+    return document == m_document ? m_editor->modify() : document->modified;
+}
+
+void SvgGallery::updateDocumentTab(EditorDocument *document)
+{
+    const int index = m_documents.indexOf(document);
+    const QString fileName = QFileInfo(document->svgPath).fileName();
+    m_documentTabs->setTabText(index, isModified(document) ? tr("%1 *").arg(fileName) : fileName);
+    m_documentTabs->setTabToolTip(index, QDir::toNativeSeparators(document->svgPath));
+}
+
+void SvgGallery::trimDocuments()
+{
+    if (m_document)
+        m_document->bytes = 2 * qint64(m_editor->length());
+    qint64 total = 0;
+    for (const EditorDocument *document : std::as_const(m_documents))
+        total += document->bytes;
+    if (total <= kEditorDocumentBudget)
+        return;
+
+    // The one shown and unsaved ones stay, whatever the total
+    QList<EditorDocument*> byAge = m_documents;
+    std::sort(byAge.begin(), byAge.end(), [](const EditorDocument *a, const EditorDocument *b) {
+        return a->lastUsed < b->lastUsed;
+    });
+    for (EditorDocument *document : std::as_const(byAge)) {
+        if (total <= kEditorDocumentBudget)
+            break;
+        if (document == m_document || isModified(document))
+            continue;
+        total -= document->bytes;
+        closeDocument(document);
     }
 }
 
 void SvgGallery::saveSvgContent()
 {
-    if (!m_editor || m_currentSvgPath.isEmpty()) {
+    if (!m_editor || !m_document) {
         qDebug() << "No SVG to save";
         return;
     }
+    EditorDocument *document = m_document;
     QByteArray content = m_editor->text();
+    const QString fileName = QFileInfo(document->svgPath).fileName();
 
-    // キャッシュに書き込む（既存コード）
-    QFile file(m_currentSvgPath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        showError(tr("Error: Failed to save %1").arg(QFileInfo(m_currentSvgPath).fileName()));
+    // Nothing changed since the last load or save: skip the write entirely
+    const quint64 hash = contentHash(content);
+    if (hash == document->savedHash) {
+        m_editor->set_save_point(); // Edited and undone, so clean again
+        showInfo(tr("No changes to save: %1").arg(fileName));
         return;
     }
-    file.write(content);
-    file.close();
 
-#ifdef Q_OS_ANDROID
-    // SAFの元フォルダにも書き戻す
-    if (m_androidFolder && m_androidFolder->isReady()) {
-        const QString fileName = QFileInfo(m_currentSvgPath).fileName();
-        if (!m_androidFolder->write(fileName, content)) {
-            showError(tr("Error: Failed to save to original folder: %1").arg(fileName));
+    // 元フォルダに直接書き込む（ローカルは QSaveFile でアトミック、SAF は AndroidFolder::write）
+    if (!document->source || !document->source->write(fileName, content)) {
+        showError(tr("Error: Failed to save %1").arg(fileName));
+        return;
+    }
+
+    document->savedHash = hash;
+    document->modified = false;
+    m_editor->set_save_point();
+    updateDocumentTab(document);
+    showSuccess(tr("Saved: %1").arg(fileName));
+    reloadCurrentSvg(content);
+    markLintFindings();
+}
+
+void SvgGallery::reloadCurrentSvg(const QByteArray &content)
+{
+    if (!m_document) return;
+
+    // Only the preview is refreshed; the editor keeps caret, scroll and undo history
+    if (SvgPair *widget = findSvgPair(m_document->tab, m_document->svgPath)) {
+        widget->reloadSvg(content);
+        queueLint(widget);
+        startLint();
+    }
+    updateDuplicates(m_document->tab);
+    updateMetadata();
+}
+
+SvgPair *SvgGallery::findSvgPair(const FolderTab *tab, const QString &svgPath) const
+{
+    for (SvgPair *widget : tab->svgPairs) {
+        if (widget->svgPath() == svgPath)
+            return widget;
+    }
+    return nullptr;
+}
+
+void SvgGallery::optimizeCurrentSvg()
+{
+    if (!m_editor || !m_document) {
+        qDebug() << "No SVG to optimize";
+        return;
+    }
+    const QString fileName = QFileInfo(m_document->svgPath).fileName();
+
+    QByteArray optimized;
+    const SvgOptimizer::Report report = SvgOptimizer().run(m_editor->text(), &optimized, m_iconSize);
+    if (!report.ok) {
+        showError(tr("Error: Cannot optimize %1: %2").arg(fileName, report.error));
+        return;
+    }
+
+    // Replace the buffer through the editor so the change stays undoable,
+    // as one step rather than an empty buffer and an insertion
+    m_editor->begin_undo_action();
+    m_editor->clear_all();
+    m_editor->insert_text(0, optimized.constData());
+    m_editor->end_undo_action();
+    m_editor->goto_pos(0);
+    colorizeVisibleRange();
+    markLintFindings();
+
+    const QString message = tr("Optimized %1 (not saved): %2").arg(fileName, report.summary());
+    if (report.pixelsChanged())
+        showWarning(message);
+    else
+        showSuccess(message);
+}
+
+void SvgGallery::inspectCurrentSvg()
+{
+    // The gallery's document, so the view follows saves and shares the parse
+    SvgPair *widget = m_document ? findSvgPair(m_document->tab, m_document->svgPath) : nullptr;
+    if (!widget) {
+        qDebug() << "No SVG to inspect";
+        return;
+    }
+
+    if (!m_inspector) {
+        m_inspectorWindow = new QWidget(this, Qt::Window);
+        m_inspectorWindow->resize(800, 600);
+        QVBoxLayout *layout = new QVBoxLayout(m_inspectorWindow);
+        QHBoxLayout *controls = new QHBoxLayout();
+
+        QComboBox *zoomCombo = new QComboBox(m_inspectorWindow);
+        for (int zoom = 1; zoom <= SvgInspector::kMaxZoom; zoom *= 2)
+            zoomCombo->addItem(tr("%1×").arg(zoom), zoom);
+        controls->addWidget(zoomCombo);
+
+        QCheckBox *gridCheck = new QCheckBox(tr("Pixel grid"), m_inspectorWindow);
+        gridCheck->setToolTip(tr("Lines between the SVG's own pixels, from 4× up"));
+        controls->addWidget(gridCheck);
+
+        controls->addStretch();
+        QLabel *hint = new QLabel(tr("Drag to pan; Ctrl+wheel or +/- to zoom"), m_inspectorWindow);
+        hint->setStyleSheet("color: gray;");
+        controls->addWidget(hint);
+        layout->addLayout(controls);
+
+        m_inspector = new SvgInspector(m_inspectorWindow);
+        m_inspector->setBackground(m_backgroundColor);
+        layout->addWidget(m_inspector, 1);
+
+        connect(zoomCombo, &QComboBox::currentIndexChanged, this, [this, zoomCombo](int index) {
+            m_inspector->setZoom(zoomCombo->itemData(index).toInt());
+        });
+        connect(m_inspector, &SvgInspector::zoomChanged, zoomCombo, [zoomCombo](int zoom) {
+            const QSignalBlocker blocker(zoomCombo);
+            zoomCombo->setCurrentIndex(zoomCombo->findData(zoom));
+        });
+        connect(gridCheck, &QCheckBox::toggled, m_inspector, &SvgInspector::setPixelGrid);
+    }
+
+    // Shown first, so the zoom that fits is worked out for the real size
+    m_inspectorWindow->setWindowTitle(tr("Inspect: %1").arg(widget->fileName()));
+    m_inspectorWindow->show();
+    m_inspectorWindow->raise();
+    m_inspectorWindow->activateWindow();
+    m_inspector->setDocument(widget->document());
+    m_inspector->setFocus();
+}
+
+void SvgGallery::optimizeFolder()
+{
+    // The loop below processes events; the tab to write to is this one
+    FolderTab *tab = m_tab;
+    if (tab->svgPairs.isEmpty()) {
+        showError(tr("Please load a directory first."));
+        return;
+    }
+
+    const auto answer = QMessageBox::question(
+        this, tr("Optimize All"),
+        tr("Optimize and overwrite %1 SVG file(s)?\n"
+           "Files whose rendering would change are reported and left untouched.")
+            .arg(tab->svgPairs.size()));
+    if (answer != QMessageBox::Yes || !m_tabs.contains(tab))
+        return;
+
+    const QList<SvgPair*> pairs = tab->svgPairs;
+    const SvgOptimizer optimizer;
+    SvgOptimizer::Metrics before, after;
+    int written = 0;
+    QStringList flagged, failed;
+
+    // Modal, so the window cannot start another run or act on the tab meanwhile
+    QProgressDialog progress(tr("Optimizing..."), tr("Cancel"), 0, int(tab->svgPairs.size()), this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    for (int index = 0; index < pairs.size(); ++index) {
+        progress.setValue(index);
+        QCoreApplication::processEvents();
+
+        // A load finishing or a session restore may have replaced the
+        // items, or the tab may be gone; neither is safe to touch
+        if (!m_tabs.contains(tab) || tab->svgPairs != pairs) {
+            showWarning(tr("Optimize All stopped: the folder changed meanwhile. %1 file(s) were written.").arg(written));
             return;
         }
+        if (progress.wasCanceled())
+            break;
+
+        SvgPair *widget = pairs[index];
+        const QString svgPath = widget->svgPath();
+        const QString fileName = QFileInfo(svgPath).fileName();
+        progress.setLabelText(tr("Optimizing %1").arg(fileName));
+
+        const QByteArray original = widget->document()->data();
+
+        QByteArray optimized;
+        const SvgOptimizer::Report report = optimizer.run(original, &optimized, m_iconSize);
+        if (!report.ok) {
+            failed.append(fileName);
+            continue;
+        }
+
+        before.bytes += report.before.bytes;
+        before.parseMs += report.before.parseMs;
+        before.renderMs += report.before.renderMs;
+
+        // Flagged, grown and unwritten files keep their original content,
+        // so the totals count it
+        const auto keepOriginal = [&] {
+            after.bytes += report.before.bytes;
+            after.parseMs += report.before.parseMs;
+            after.renderMs += report.before.renderMs;
+        };
+        if (report.pixelsChanged()) {
+            flagged.append(fileName);
+            keepOriginal();
+            continue;
+        }
+        if (report.after.bytes >= report.before.bytes) {
+            keepOriginal();
+            continue;
+        }
+        if (!tab->source || !tab->source->write(fileName, optimized)) {
+            failed.append(fileName);
+            keepOriginal();
+            continue;
+        }
+        after.bytes += report.after.bytes;
+        after.parseMs += report.after.parseMs;
+        after.renderMs += report.after.renderMs;
+        widget->reloadSvg(optimized);
+        queueLint(widget);
+        ++written;
     }
-#endif
+    const bool canceled = progress.wasCanceled();
+    progress.reset();
+    startLint();
+    updateDuplicates(tab);
+    updateMetadata();
+
+    const QLocale locale;
+    QString message = tr("Optimized %1 of %2 SVG file(s): %3 → %4, parse %5 → %6 ms, render %7 → %8 ms")
+                          .arg(written)
+                          .arg(tab->svgPairs.size())
+                          .arg(locale.formattedDataSize(before.bytes), locale.formattedDataSize(after.bytes))
+                          .arg(before.parseMs, 0, 'f', 1)
+                          .arg(after.parseMs, 0, 'f', 1)
+                          .arg(before.renderMs, 0, 'f', 1)
+                          .arg(after.renderMs, 0, 'f', 1);
+    if (canceled)
+        message += tr(" (canceled)");
+    if (!flagged.isEmpty())
+        message += tr("\nSkipped, rendering would change: %1").arg(flagged.join(", "));
+    if (!failed.isEmpty())
+        message += tr("\nFailed: %1").arg(failed.join(", "));
+
+    if (flagged.isEmpty() && failed.isEmpty() && !canceled)
+        showSuccess(message);
+    else
+        showWarning(message);
+}
 
-    showSuccess(tr("Saved and reloading: %1").arg(QFileInfo(m_currentSvgPath).fileName()));
-    reloadCurrentSvg();
+void SvgGallery::exportContactSheet()
+{
+    QList<SvgDocumentPtr> documents;
+    for (SvgPair *widget : m_tab->svgPairs) {
+        if (!widget->isHidden()) // The filter hides what it does not match
+            documents.append(widget->document());
+    }
+    if (documents.isEmpty()) {
+        showError(tr("Please load a directory first."));
+        return;
+    }
+
+    bool ok = false;
+    const QString sizesText = QInputDialog::getText(
+        this, tr("Export Sheet"), tr("Icon sizes, one section per size and background preset:"),
+        QLineEdit::Normal, QString::number(m_iconSize), &ok);
+    if (!ok)
+        return;
+    const QList<int> sizes = PngBuild::parseSizes(sizesText);
+    if (sizes.isEmpty()) {
+        showError(tr("Error: No valid icon size in '%1' (8 to 1024)").arg(sizesText));
+        return;
+    }
+
+    const QString path = QFileDialog::getSaveFileName(
+        this, tr("Export Sheet"), QDir(m_tab->currentPath).filePath("contact-sheet.png"),
+        tr("PNG image (*.png);;PDF document (*.pdf)"));
+    if (path.isEmpty())
+        return;
+
+    ContactSheet::Options options;
+    for (int size : sizes) {
+        for (const GalleryTheme::Preset &preset : GalleryTheme::presets())
+            options.sections.append({size, preset.background, tr("%1 px on %2, %3 icon(s)").arg(size).arg(preset.name).arg(documents.size())});
+    }
+    ContactSheet sheet(documents, options);
+
+    QProgressDialog progress(tr("Exporting %1...").arg(QFileInfo(path).fileName()), tr("Cancel"), 0, 0, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    auto report = [&progress](int done, int total) {
+        progress.setMaximum(total);
+        progress.setValue(done);
+        QCoreApplication::processEvents();
+        return !progress.wasCanceled();
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool pdf = path.endsWith(QLatin1String(".pdf"), Qt::CaseInsensitive);
+    const bool written = pdf ? sheet.writePdf(path, report) : sheet.writePng(path, report);
+    const bool canceled = progress.wasCanceled();
+    progress.reset();
+
+    if (!written) {
+        if (canceled)
+            showWarning(tr("Export canceled"));
+        else
+            showError(tr("Error: Failed to export %1: %2").arg(path, sheet.errorString()));
+        return;
+    }
+    QString message = tr("Exported %1 icon(s) in %2 section(s) to %3 in %4 s")
+                          .arg(documents.size())
+                          .arg(options.sections.size())
+                          .arg(path)
+                          .arg(timer.elapsed() / 1000.0, 0, 'f', 1);
+    if (!pdf)
+        message += tr(" (%1×%2 px)").arg(sheet.pngSize().width()).arg(sheet.pngSize().height());
+    showSuccess(message);
 }
 
-void SvgGallery::reloadCurrentSvg()
+void SvgGallery::buildPngs()
 {
-    if (m_currentSvgPath.isEmpty()) return;
+    if (!m_tab->source) {
+        showError(tr("Please load a directory first."));
+        return;
+    }
 
-    for (SvgPair *widget : m_svgPairs) {
-        if (widget->svgPath() == m_currentSvgPath) {
-            widget->reloadSvg();
+    bool ok = false;
+    const QString sizesText = QInputDialog::getText(
+        this, tr("Build PNGs"), tr("Sizes to build, as name_<size>.png next to each SVG:"),
+        QLineEdit::Normal, m_buildSizes, &ok);
+    if (!ok)
+        return;
+    PngBuild::Options options;
+    options.sizes = PngBuild::parseSizes(sizesText);
+    if (options.sizes.isEmpty()) {
+        showError(tr("Error: No valid icon size in '%1' (8 to 1024)").arg(sizesText));
+        return;
+    }
+    m_buildSizes = sizesText;
+
+    const QStringList encodings{tr("Fast"), tr("Optimized (lossless, slower)")};
+    const QString encoding = QInputDialog::getItem(this, tr("Build PNGs"), tr("Encoding:"), encodings,
+                                                   m_buildOptimized ? 1 : 0, false, &ok);
+    if (!ok)
+        return;
+    options.optimize = encoding == encodings[1];
+    m_buildOptimized = options.optimize;
+
+    // Into the folder itself, where loading pairs the PNGs with their SVGs
+    PngBuild build(m_tab->source, m_tab->source, options);
+    QProgressDialog progress(tr("Building PNGs..."), tr("Cancel"), 0, 0, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    QElapsedTimer timer;
+    timer.start();
+    const PngBuild::Result result = build.run([&progress](int done, int total) {
+        progress.setMaximum(total);
+        progress.setValue(done);
+        QCoreApplication::processEvents();
+        return !progress.wasCanceled();
+    });
+    const bool canceled = progress.wasCanceled();
+    progress.reset();
+
+    QString message = tr("Built PNGs in %1 s: %2").arg(timer.elapsed() / 1000.0, 0, 'f', 2).arg(result.summary());
+    if (result.pngsWritten > 0 || result.removed > 0)
+        message += tr("\nLoad SVGs again to show the new PNGs.");
+    if (canceled)
+        showWarning(tr("Build canceled. ") + message);
+    else if (!result.ok || result.failed > 0)
+        showError(tr("Error: %1. ").arg(result.error.isEmpty() ? tr("Some SVGs failed to build") : result.error) + message);
+    else
+        showSuccess(message);
+}
+
+void SvgGallery::compareFolders()
+{
+    const QString start = m_tab->currentPath.isEmpty() ? QDir::homePath() : m_tab->currentPath;
+    const QString before = QFileDialog::getExistingDirectory(this, tr("Compare: Folder Before"), start);
+    if (before.isEmpty())
+        return;
+    const QString after = QFileDialog::getExistingDirectory(this, tr("Compare: Folder After"), before);
+    if (after.isEmpty())
+        return;
+
+    QString error;
+    const FolderSourcePtr beforeSource = createSource(before, &error);
+    const FolderSourcePtr afterSource = beforeSource ? createSource(after, &error) : FolderSourcePtr();
+    if (!afterSource) {
+        showError(error);
+        return;
+    }
+
+    // Rendered at the icon size in device pixels, so the diff is of the
+    // pixels this screen shows
+    const qreal pixelRatio = devicePixelRatioF();
+    FolderCompare::Options options;
+    options.size = qRound(m_iconSize * pixelRatio);
+    FolderCompare compare(beforeSource, afterSource, options);
+    QProgressDialog progress(tr("Comparing folders..."), tr("Cancel"), 0, 0, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    QElapsedTimer timer;
+    timer.start();
+    const FolderCompare::Result result = compare.run([&progress](int done, int total) {
+        progress.setMaximum(total);
+        progress.setValue(done);
+        QCoreApplication::processEvents();
+        return !progress.wasCanceled();
+    });
+    const bool canceled = progress.wasCanceled();
+    progress.reset();
+    if (!result.ok) {
+        if (canceled)
+            showWarning(tr("Comparison canceled"));
+        else
+            showError(tr("Error: %1").arg(result.error));
+        return;
+    }
+
+    // Into a tab of its own, unless the current one is still empty
+    if (!m_tab->svgPairs.isEmpty() || !m_tab->comparison.isEmpty() || m_tab->loader->isRunning())
+        addTab();
+    FolderTab *tab = m_tab;
+    if (tab == m_sessionTab)
+        cancelSessionValidation();
+    clearGallery(tab);
+    tab->source.clear();
+    tab->currentPath.clear();
+    tab->folderEntries.clear();
+    tab->comparison = tr("%1 → %2 in %3 s: %4")
+                          .arg(before, after)
+                          .arg(timer.elapsed() / 1000.0, 0, 'f', 1)
+                          .arg(result.summary());
+    const int index = int(m_tabs.indexOf(tab));
+    m_tabWidget->setTabText(index, tr("Changes in %1").arg(QFileInfo(after).fileName()));
+    m_tabWidget->setTabToolTip(index, tr("%1 → %2").arg(before, after));
+
+    // One row per change: before, after and diff in fixed columns, then what happened
+    const int cellSize = m_iconSize + 8;
+    auto addRow = [&](const QString &name, const QList<QImage> &cells, const QString &text) {
+        QWidget *row = new QWidget(tab->galleryWidget);
+        row->setObjectName(name);
+        QHBoxLayout *rowLayout = new QHBoxLayout(row);
+        rowLayout->setContentsMargins(0, 0, 0, 0);
+        for (const QImage &image : cells) {
+            QLabel *cell = new QLabel(row);
+            cell->setFixedSize(cellSize, cellSize);
+            cell->setAlignment(Qt::AlignCenter);
+            if (!image.isNull()) {
+                QPixmap pixmap = QPixmap::fromImage(image);
+                pixmap.setDevicePixelRatio(pixelRatio);
+                cell->setPixmap(pixmap);
+            }
+            rowLayout->addWidget(cell);
+        }
+        QLabel *label = new QLabel(text, row);
+        label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+        rowLayout->addWidget(label, 1);
+        tab->galleryLayout->addWidget(row, int(tab->compareRows.size()), 0);
+        tab->compareRows.append(row);
+    };
+
+    QWidget *header = new QWidget(tab->galleryWidget);
+    QHBoxLayout *headerLayout = new QHBoxLayout(header);
+    headerLayout->setContentsMargins(0, 0, 0, 0);
+    for (const QString &title : {tr("Before"), tr("After"), tr("Diff")}) {
+        QLabel *label = new QLabel(title, header);
+        label->setFixedWidth(cellSize);
+        label->setAlignment(Qt::AlignCenter);
+        QFont font = label->font();
+        font.setBold(true);
+        label->setFont(font);
+        headerLayout->addWidget(label);
+    }
+    headerLayout->addStretch(1);
+    tab->galleryLayout->addWidget(header, 0, 0);
+    tab->compareRows.append(header);
+
+    for (const FolderCompare::Change &change : result.changes) {
+        QString text;
+        switch (change.status) {
+        case FolderCompare::Changed:
+            text = tr("%1\nchanged: %2% of pixels, up to %3 per channel")
+                       .arg(change.name())
+                       .arg(change.pixels.score() * 100, 0, 'f', 1)
+                       .arg(change.pixels.maxDelta);
+            break;
+        case FolderCompare::Added:
+            text = tr("%1\nadded").arg(change.name());
+            break;
+        case FolderCompare::Removed:
+            text = tr("%1\nremoved").arg(change.name());
+            break;
+        case FolderCompare::Renamed:
+            text = tr("%1\nrenamed from %2").arg(change.afterName, change.beforeName);
             break;
         }
+        addRow(change.beforeName + QLatin1Char(' ') + change.afterName,
+               {change.before, change.after, change.diff}, text);
     }
+    applyFilter(tab);
 
-    showSvgContent(m_currentSvgPath);
+    qDebug() << "Compared" << before << "with" << after << "in" << timer.elapsed() << "ms:" << result.summary();
+    if (result.failed > 0)
+        showWarning(tab->comparison);
+    else
+        showSuccess(tab->comparison);
 }
 
 void SvgGallery::closeEditor()
@@ -724,5 +2140,271 @@ void SvgGallery::closeEditor()
     m_editorContainer->hide();
     m_splitter->setSizes({width(), 0});
     m_editorVisible = false;
-    m_currentSvgPath.clear();
+}
+
+// ============================================================================
+// Session snapshot
+// ============================================================================
+
+bool SvgGallery::restoreSession(const QString &path)
+{
+    // Saved to from now on, even if there is nothing to restore yet
+    m_snapshotPath = path;
+
+    QElapsedTimer timer;
+    timer.start();
+    const SessionSnapshot snapshot = SessionSnapshot::load(path);
+    if (!snapshot.isValid() || snapshot.session().items.isEmpty())
+        return false;
+    m_snapshot = snapshot;
+    const SessionSnapshot::Session &session = m_snapshot.session();
+
+    // Into the current tab, which is checked against the folder afterwards
+    FolderTab *tab = m_tab;
+    m_sessionTab = tab;
+    m_pathInput->setText(session.folder);
+    tab->currentPath = session.folder;
+    updateTabTitle(tab);
+    if (session.background.isValid()) {
+        m_backgroundColor = session.background;
+        updateBackgroundColor();
+    }
+    m_sizeSlider->setValue(session.iconSize);
+
+    // Without a source the gallery is still shown, just not checked or saved to
+    QString error;
+    tab->source = createSource(session.folder, &error);
+
+    // Names and bytes point into the mapping; nothing is read or hashed
+    clearGallery(tab);
+    tab->folderEntries.clear();
+    tab->svgPairs.reserve(session.items.size());
+    for (int index = 0; index < session.items.size(); ++index) {
+        const SessionSnapshot::Item &item = session.items[index];
+        SvgDocumentPtr document = SvgDocumentPtr::create(svgPath(tab, item.name), item.data, item.contentHash);
+        tab->folderEntries.insert(item.name, folderEntry(item.name, item.size, item.lastModified));
+
+        QList<FolderFile> pngs;
+        for (const SessionSnapshot::Png &png : item.pngs) {
+            pngs.append(FolderFile{png.name, png.data});
+            tab->folderEntries.insert(png.name, folderEntry(png.name, png.size, png.lastModified));
+        }
+
+        SvgPair *svgWidget = createSvgPair(document, pngs);
+        tab->galleryLayout->addWidget(svgWidget, index, 0);
+        tab->svgPairs.append(svgWidget);
+        markDuplicate(tab, svgWidget);
+    }
+
+    const QString message = tr("Restored %1 SVG file(s) from the last session in %2 ms: %3")
+                                .arg(tab->svgPairs.size())
+                                .arg(timer.elapsed())
+                                .arg(session.folder);
+    qDebug() << "Restored" << tab->svgPairs.size() << "items from" << snapshot.byteSize() << "bytes in"
+             << timer.nsecsElapsed() / 1e6 << "ms";
+    updateMetadata();
+    if (!tab->source) {
+        m_sessionTab = nullptr;
+        showWarning(message + tr("\nNot checked against the folder: %1").arg(error));
+        return true;
+    }
+
+    // Checked in the background; only what changed is read
+    showSuccess(message);
+    m_sessionListWatcher.setFuture(tab->source->listAsync());
+    return true;
+}
+
+void SvgGallery::cancelSessionValidation()
+{
+    m_sessionListWatcher.cancel();
+    m_sessionReadWatcher.cancel();
+    // setFuture() also drops signals still queued
+    m_sessionListWatcher.setFuture(QFuture<QList<FolderEntry>>());
+    m_sessionReadWatcher.setFuture(QFuture<FolderBatch>());
+    m_sessionListing.clear();
+    m_staleItems.clear();
+    m_sessionTab = nullptr;
+}
+
+void SvgGallery::onSessionListed()
+{
+    if (m_sessionListWatcher.isCanceled())
+        return;
+    m_sessionListing = m_sessionListWatcher.result();
+    FolderTab *tab = m_sessionTab;
+
+    // A listing that failed comes back empty, as if every file had been
+    // deleted; only the source tells the two apart. The restored items stay.
+    if (m_sessionListing.isEmpty() && !tab->svgPairs.isEmpty() && !tab->source->isReady()) {
+        showError(tr("Cannot check the restored session: %1 is not accessible").arg(tab->source->displayName()));
+        m_sessionTab = nullptr;
+        return;
+    }
+
+    QHash<QString, FolderEntry> listed;
+    for (const FolderEntry &entry : std::as_const(m_sessionListing))
+        listed.insert(entry.name, entry);
+    QHash<QString, SvgPair*> shown;
+    for (SvgPair *widget : std::as_const(tab->svgPairs))
+        shown.insert(widget->fileName(), widget);
+
+    auto unchanged = [tab, &listed](const QString &fileName) {
+        return sameFile(listed.value(fileName), tab->folderEntries.value(fileName));
+    };
+
+    // An item is current if its SVG and the same set of PNGs are unchanged
+    m_staleItems.clear();
+    QStringList toRead;
+    for (const GalleryLoader::Item &item : GalleryLoader::itemsOf(m_sessionListing)) {
+        bool current = false;
+        if (SvgPair *widget = shown.value(item.svgFile)) {
+            QStringList shownPngs;
+            for (const FolderFile &png : widget->pngFiles())
+                shownPngs.append(png.name);
+            current = unchanged(item.svgFile) && shownPngs == item.pngFiles
+                      && std::all_of(item.pngFiles.cbegin(), item.pngFiles.cend(), unchanged);
+        }
+        if (current)
+            continue;
+        m_staleItems.append(item);
+        toRead.append(item.svgFile);
+        toRead.append(item.pngFiles);
+    }
+
+    if (toRead.isEmpty()) {
+        applySessionChanges({});
+        return;
+    }
+    toRead.removeDuplicates();
+    showInfo(tr("Reading %1 changed file(s) from %2...").arg(toRead.size()).arg(tab->source->displayName()));
+    m_sessionReadWatcher.setFuture(tab->source->readAsync(toRead));
+}
+
+void SvgGallery::onSessionFilesRead()
+{
+    if (m_sessionReadWatcher.isCanceled())
+        return;
+
+    QHash<QString, QByteArray> data;
+    for (const FolderBatch &batch : m_sessionReadWatcher.future().results()) {
+        for (const FolderFile &file : batch)
+            data.insert(file.name, file.data);
+    }
+    applySessionChanges(data);
+}
+
+void SvgGallery::applySessionChanges(const QHash<QString, QByteArray> &data)
+{
+    FolderTab *tab = m_sessionTab;
+    QSet<QString> listedSvgs;
+    for (const FolderEntry &entry : std::as_const(m_sessionListing)) {
+        if (entry.name.endsWith(QLatin1String(".svg"), Qt::CaseInsensitive))
+            listedSvgs.insert(entry.name);
+    }
+
+    // Deleted from the folder
+    int removed = 0;
+    for (qsizetype i = tab->svgPairs.size() - 1; i >= 0; --i) {
+        if (!listedSvgs.contains(tab->svgPairs[i]->fileName())) {
+            delete tab->svgPairs.takeAt(i);
+            ++removed;
+        }
+    }
+
+    // Changed ones are replaced in place, new ones appended
+    QHash<QString, qsizetype> indexOf;
+    for (qsizetype i = 0; i < tab->svgPairs.size(); ++i)
+        indexOf.insert(tab->svgPairs[i]->fileName(), i);
+    int changed = 0, added = 0;
+    for (const GalleryLoader::Item &item : std::as_const(m_staleItems)) {
+        QList<FolderFile> pngs;
+        for (const QString &pngFile : item.pngFiles)
+            pngs.append(FolderFile{pngFile, data.value(pngFile)});
+        SvgPair *svgWidget = createSvgPair(
+            SvgDocumentPtr::create(svgPath(tab, item.svgFile), data.value(item.svgFile)), pngs);
+
+        const auto it = indexOf.constFind(item.svgFile);
+        if (it != indexOf.constEnd()) {
+            delete std::exchange(tab->svgPairs[*it], svgWidget);
+            ++changed;
+        } else {
+            tab->svgPairs.append(svgWidget);
+            ++added;
+        }
+    }
+
+    tab->folderEntries.clear();
+    for (const FolderEntry &entry : std::as_const(m_sessionListing))
+        tab->folderEntries.insert(entry.name, entry);
+    m_sessionListing.clear();
+    m_staleItems.clear();
+    m_sessionTab = nullptr;
+
+    if (changed + added + removed == 0) {
+        qDebug() << "Restored session is up to date";
+        return;
+    }
+
+    // Same order as a load
+    std::sort(tab->svgPairs.begin(), tab->svgPairs.end(), [](const SvgPair *a, const SvgPair *b) {
+        return a->fileName() < b->fileName();
+    });
+    arrangeGallery(tab);
+    updateDuplicates(tab);
+    updateMetadata();
+    applyFilter(tab);
+    pruneContentIndex();
+    if (tab != m_tab)
+        return;
+    showSuccess(tr("Updated from %1: %2 changed, %3 new, %4 removed")
+                    .arg(tab->currentPath)
+                    .arg(changed)
+                    .arg(added)
+                    .arg(removed));
+    saveSession();
+}
+
+void SvgGallery::saveSession()
+{
+    // The session is one folder: the tab shown last
+    FolderTab *tab = m_tab;
+    if (m_snapshotPath.isEmpty() || tab->svgPairs.isEmpty())
+        return;
+
+    SessionSnapshot::Session session;
+    session.folder = tab->currentPath;
+    session.iconSize = m_iconSize;
+    session.background = m_backgroundColor;
+    session.items.reserve(tab->svgPairs.size());
+    for (SvgPair *widget : std::as_const(tab->svgPairs)) {
+        SessionSnapshot::Item item;
+        item.name = widget->fileName();
+        item.data = widget->document()->data();
+        item.contentHash = widget->document()->contentHash();
+        const FolderEntry entry = tab->folderEntries.value(item.name);
+        item.size = entry.size;
+        item.lastModified = msecsOf(entry.lastModified);
+
+        for (const FolderFile &png : widget->pngFiles()) {
+            const FolderEntry pngEntry = tab->folderEntries.value(png.name);
+            item.pngs.append(SessionSnapshot::Png{png.name, png.data, pngEntry.size, msecsOf(pngEntry.lastModified)});
+        }
+        session.items.append(item);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!SessionSnapshot::save(m_snapshotPath, session))
+        qDebug() << "Failed to save the session to" << m_snapshotPath;
+    else
+        qDebug() << "Saved the session in" << timer.nsecsElapsed() / 1e6 << "ms";
+}
+
+void SvgGallery::closeEvent(QCloseEvent *event)
+{
+    // Icon size and background are kept too, so save whatever was shown last
+    cancelSessionValidation();
+    saveSession();
+    QMainWindow::closeEvent(event);
 }
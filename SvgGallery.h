@@ -2,45 +2,166 @@
 #define SVGGALLERY_H
 
 #include "AndroidFolder.h"
+#include "GalleryLoader.h"
+#include "GalleryTheme.h"
+#include "SessionSnapshot.h"
+#include "SvgLint.h"
+#include "SvgMetadata.h"
 #include "SvgPair.h"
 
 #include <QColor>
+#include <QFutureWatcher>
 #include <QGridLayout>
+#include <QHash>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMainWindow>
 #include <QPushButton>
 #include <QScrollArea>
+#include <QSet>
 #include <QSlider>
 #include <QSplitter>
 
+class QComboBox;
+class SvgInspector;
+class QTabBar;
+class QTabWidget;
 class ScintillaRelay;
 
-// A Simple Gallery of SVGs in a given folder
+// A Simple Gallery of SVGs in a given folder, one tab per folder.
+// Tabs share the process-wide parse cache (SvgContent), the pixmap cache
+// and the metadata and lint results by content hash, so an icon that is in
+// several folders is parsed, rendered and analyzed once.
 class SvgGallery : public QMainWindow
 {
     Q_OBJECT
 
 public:
     explicit SvgGallery(QWidget *parent = nullptr);
+    ~SvgGallery() override;
+
+    // Wraps every folder in a SimulatedFolderSource with this per-file latency
+    void setSimulatedLatency(int readMs) { m_simulatedLatencyMs = readMs; }
+
+    // Shows the last session from its snapshot, then checks it against the
+    // folder in the background; false if there is no usable snapshot
+    bool restoreSession(const QString &path = SessionSnapshot::defaultPath());
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
 
 private slots:
     void browseDirectory();
     void loadSvgs();
+    void addTab();
+    void closeTab(int index);
+    void switchTab(int index);
     void updateIconSizes();
     void filterGallery();
+    void onMetadataReady();
+    void onLintFinished();
     void showSvgContent(const QString &svgPath);
     void saveSvgContent();
+    void optimizeCurrentSvg();
+    void inspectCurrentSvg();
+    void optimizeFolder();
+    void exportContactSheet();
+    void buildPngs();
+    void compareFolders();
     void closeEditor();
+    void showBackendStats();
+    void updateCacheStatus();
+    void onSessionListed();
+    void onSessionFilesRead();
 
 private:
+    // One folder, or the changes between two: its items and the widgets
+    // they are laid out in. The controls above the tabs show the current
+    // tab's filter and order.
+    struct GalleryGroup {
+        QLabel *header;
+        QString name;
+        QList<SvgPair*> items;
+    };
+    struct FolderTab {
+        QScrollArea *scrollArea = nullptr;
+        QWidget *galleryWidget = nullptr;
+        QGridLayout *galleryLayout = nullptr;
+        GalleryLoader *loader = nullptr;
+        FolderSourcePtr source; // Of the items shown, loaded or restored
+        QString currentPath;
+        QString pathText;       // Controls as last left in this tab
+        QString filterText;
+        int sortKey = 0;
+        int grouping = 0;
+        QList<SvgPair*> svgPairs;
+        QHash<quint64, SvgPair*> firstWithContent; // By content hash; later items with it are duplicates
+        QList<GalleryGroup> groups; // In display order; empty when not grouped
+        QHash<QString, FolderEntry> folderEntries; // Size and time the items were read at, by file name
+        QList<QWidget*> compareRows; // A folder comparison instead of items; the first is the column header
+        QString comparison;          // Its summary, empty for a folder
+    };
+
+    // An SVG open in the editor, as a tab above it. Each is a Scintilla
+    // document of its own, with its styling, lint marks and undo history;
+    // only the caret and scroll belong to the view and are kept here.
+    struct EditorDocument {
+        qintptr doc = 0;            // The gallery's reference, released on close
+        QString svgPath;
+        FolderTab *tab = nullptr;   // Whose gallery it was opened from
+        FolderSourcePtr source;     // Saved to, even once the tab shows another folder
+        quint64 savedHash = 0;      // Of the content last loaded or saved
+        bool modified = false;      // Follows the save point while shown
+        int caret = 0;
+        int anchor = 0;
+        int firstLine = 0;
+        qint64 bytes = 0;           // Text and styles, as when last shown
+        quint64 lastUsed = 0;
+    };
+
     void initUI();
     void updateBackgroundColor();
-    void updateTextColors();
-    void clearGallery();
+    void setBackends(const QList<RenderBackend*> &backends);
+    void setPixelRatios(const QList<qreal> &pixelRatios);
+    void setTint(IconTint::Mode mode, const QColor &color);
+    void clearGallery(FolderTab *tab);
+    void pruneContentIndex();
+    QList<SvgPair*> allSvgPairs() const;
+    void updateTabTitle(FolderTab *tab);
+    void onFolderListed(FolderTab *tab, int svgCount);
+    void onItemLoaded(FolderTab *tab, int index, const GalleryLoader::Item &item);
+    void onLoadFinished(FolderTab *tab, bool canceled);
+    void arrangeGallery(FolderTab *tab);
+    int applyFilter(const FolderTab *tab);
+    FolderSourcePtr createSource(const QString &path, QString *error);
+    QString svgPath(const FolderTab *tab, const QString &fileName) const;
+    SvgPair *createSvgPair(const SvgDocumentPtr &document, const QList<FolderFile> &pngs);
+    void cancelSessionValidation();
+    void applySessionChanges(const QHash<QString, QByteArray> &data);
+    void saveSession();
     void setupScintilla();
     void applyXMLHighlighting();
-    void reloadCurrentSvg();
+    bool setXMLLexer();
+    EditorDocument *findDocument(const FolderTab *tab, const QString &svgPath) const;
+    void showDocument(EditorDocument *document);
+    void closeDocument(EditorDocument *document);
+    void closeDocuments(const FolderTab *tab);
+    void requestCloseDocument(int index);
+    bool isModified(const EditorDocument *document) const;
+    void updateDocumentTab(EditorDocument *document);
+    void trimDocuments();
+    void colorizeVisibleRange();
+    void markLintFindings();
+    void reloadCurrentSvg(const QByteArray &content);
+    SvgPair *findSvgPair(const FolderTab *tab, const QString &svgPath) const;
+    void markDuplicate(FolderTab *tab, SvgPair *widget);
+    void updateDuplicates(FolderTab *tab);
+    void updateMetadata();
+    void queueLint(SvgPair *widget);
+    void startLint();
+    void updateGroupHeaders(const FolderTab *tab);
+    int groupOf(const SvgMetadata *metadata, int grouping) const;
+    QString groupName(int grouping, int group) const;
 
     // Message display helpers
     void showSuccess(const QString &message);
@@ -51,32 +172,78 @@ private:
     // UI Components
     QLineEdit *m_pathInput;
     QLineEdit *m_filterInput;
+    QComboBox *m_sortCombo;
+    QComboBox *m_groupCombo;
     QLabel *m_infoLabel;
     QLabel *m_sizeLabel;
     QSlider *m_sizeSlider;
-    QScrollArea *m_scrollArea;
-    QWidget *m_galleryWidget;
-    QGridLayout *m_galleryLayout;
+    QTabWidget *m_tabWidget;
     QSplitter *m_splitter;
+    QLabel *m_cacheLabel;
+    QComboBox *m_budgetCombo;
 
     // Editor components
     QWidget *m_editorContainer;
     QLabel *m_editorTitle;
+    QTabBar *m_documentTabs;
     QPushButton *m_saveButton;
+    QPushButton *m_optimizeButton;
     ScintillaRelay *m_editor;
 
+    // Zoomable view of the SVG in the editor, in a window of its own
+    QWidget *m_inspectorWindow = nullptr;
+    SvgInspector *m_inspector = nullptr;
+
     // State
-    QString m_currentPath;
-    QString m_currentSvgPath;
+    QList<EditorDocument*> m_documents; // In tab order
+    EditorDocument *m_document = nullptr; // In the editor
+    quint64 m_documentClock = 0; // Orders EditorDocument::lastUsed
     QColor m_backgroundColor;
+    GalleryTheme m_theme;
     int m_iconSize = 32;
-    bool m_customEngine = false;
+    QList<RenderBackend*> m_backends; // Render backends shown for every SVG
+    QList<qreal> m_pixelRatios = {0}; // Device pixel ratios, 0 for the screen's
+    IconTint::Mode m_tintMode = IconTint::Off;
+    QColor m_tintColor; // Invalid: the theme's text color
     bool m_editorVisible;
 
-    // Gallery items
-    QList<SvgPair*> m_svgPairs;
+    // Gallery tabs, in tab order
+    QList<FolderTab*> m_tabs;
+    FolderTab *m_tab = nullptr; // Current
+    int m_simulatedLatencyMs = 0;
+
+    // Metadata by content hash, so duplicates and the same icon in other
+    // tabs share an entry; sorted and grouped from here, a tab's svgPairs
+    // itself stays in name order
+    QHash<quint64, SvgMetadata> m_metadata;
+    QFutureWatcher<SvgMetadata> m_metadataWatcher;
+    QList<quint64> m_metadataHashes; // Being extracted, in result order
+    bool m_metadataStale = false;    // Contents changed during the extraction
+
+    // Lint reports by content hash. Items are queued as they are created and
+    // linted in batches on the thread pool, so a load is checked as it goes.
+    QHash<quint64, SvgLint::Report> m_lint;
+    QFutureWatcher<SvgLint::Report> m_lintWatcher;
+    QList<quint64> m_lintHashes;       // Being linted, in result order
+    QList<quint64> m_lintPending;      // Waiting for the running batch
+    QList<QByteArray> m_lintPendingData;
+    QSet<quint64> m_lintQueued;        // Being linted or pending
+
+    QString m_buildSizes = QStringLiteral("16, 24, 32, 48"); // Last choices in Build PNGs
+    bool m_buildOptimized = false;
+
+    // Session snapshot of the current tab; restored items point into its
+    // mapping, so it is kept
+    SessionSnapshot m_snapshot;
+    FolderTab *m_sessionTab = nullptr; // Restored into, while being checked
+    QString m_snapshotPath;
+    QFutureWatcher<QList<FolderEntry>> m_sessionListWatcher;
+    QFutureWatcher<FolderBatch> m_sessionReadWatcher;
+    QList<FolderEntry> m_sessionListing;      // Being validated against
+    QList<GalleryLoader::Item> m_staleItems;  // Changed or new, being read
 
 #ifdef Q_OS_ANDROID
+    AndroidFolder *androidFolder();
     AndroidFolder *m_androidFolder = nullptr;
 #endif
 };
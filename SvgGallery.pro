@@ -1,4 +1,4 @@
-QT += core gui svg svgwidgets widgets core5compat
+QT += core gui svg svgwidgets widgets xml core5compat concurrent
 
 android {
     QT += core-private
@@ -6,6 +6,14 @@ android {
 
 QTPLUGIN += qsvg
 
+# ContactSheet streams PNGs through zlib: Qt's bundled copy on Windows,
+# the system library elsewhere (Android's NDK ships one)
+win32 {
+    QT += zlib-private
+} else {
+    LIBS += -lz
+}
+
 CONFIG += c++17
 
 include(Project.pri)
@@ -0,0 +1,134 @@
+#ifndef SVGICONENGINE_H
+#define SVGICONENGINE_H
+
+#include "SvgDisplayList.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QIcon>
+#include <QIconEngine>
+#include <QPaintDevice>
+#include <QPainter>
+#include <QPixmap>
+#include <QSvgRenderer>
+#include <QTextStream>
+
+// Renders SVG text with QSvgRenderer on every request
+struct SvgIconEngine : QIconEngine
+{
+    QByteArray svg; // SVG text encoded in UTF-8
+
+    SvgIconEngine() = default;
+    SvgIconEngine(QByteArray const& svg) : svg(svg) {}
+    SvgIconEngine(QString const& path)
+    {
+        QFile f(path);
+        if (!f.open(QIODeviceBase::Text | QIODeviceBase::ReadOnly))
+            return;
+
+        QTextStream t(&f);
+        QString s = t.readAll();
+        if (!s.contains("</svg>", Qt::CaseInsensitive))
+            return;
+
+        svg = s.toUtf8();
+    }
+
+    QPixmap pixmap(
+        QSize const& size,
+        QIcon::Mode mode,
+        QIcon::State state) override
+    {
+        return scaledPixmap(size, mode, state, 1.0);
+    }
+
+    // Renders size * scale device pixels instead of upscaling a 1x pixmap
+    QPixmap scaledPixmap(
+        QSize const& size,
+        QIcon::Mode mode,
+        QIcon::State state,
+        qreal scale) override
+    {
+        QSvgRenderer renderer(svg);
+        if (!renderer.isValid())
+            return {};
+
+        QPixmap p(size * scale);
+        p.setDevicePixelRatio(scale);
+        p.fill(Qt::transparent);
+        QPainter painter(&p);
+        renderer.setAspectRatioMode(Qt::KeepAspectRatio);
+        renderer.render(&painter, QRectF(QPointF(), size));
+        painter.end();
+
+        QIcon icon(p);
+        return icon.pixmap(size, scale, mode, state);
+    }
+
+    void paint(
+        QPainter* painter,
+        QRect const& rect,
+        QIcon::Mode mode,
+        QIcon::State state) override
+    {
+        QPixmap p = scaledPixmap(rect.size(), mode, state, painter->device()->devicePixelRatio());
+        painter->drawPixmap(rect, p);
+    }
+
+    QIconEngine* clone() const override {
+        return new SvgIconEngine(svg);
+    }
+};
+
+// Replays a compiled display list, no XML involved
+struct DisplayListIconEngine : QIconEngine
+{
+    SvgDisplayList list;
+
+    DisplayListIconEngine() = default;
+    DisplayListIconEngine(SvgDisplayList const& list) : list(list) {}
+
+    QPixmap pixmap(
+        QSize const& size,
+        QIcon::Mode mode,
+        QIcon::State state) override
+    {
+        return scaledPixmap(size, mode, state, 1.0);
+    }
+
+    QPixmap scaledPixmap(
+        QSize const& size,
+        QIcon::Mode mode,
+        QIcon::State state,
+        qreal scale) override
+    {
+        if (!list.isValid())
+            return {};
+
+        QPixmap p(size * scale);
+        p.setDevicePixelRatio(scale);
+        p.fill(Qt::transparent);
+        QPainter painter(&p);
+        list.replay(&painter, QRectF(QPointF(), size));
+        painter.end();
+
+        QIcon icon(p);
+        return icon.pixmap(size, scale, mode, state);
+    }
+
+    void paint(
+        QPainter* painter,
+        QRect const& rect,
+        QIcon::Mode mode,
+        QIcon::State state) override
+    {
+        QPixmap p = scaledPixmap(rect.size(), mode, state, painter->device()->devicePixelRatio());
+        painter->drawPixmap(rect, p);
+    }
+
+    QIconEngine* clone() const override {
+        return new DisplayListIconEngine(list);
+    }
+};
+
+#endif // SVGICONENGINE_H
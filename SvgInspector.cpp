@@ -0,0 +1,354 @@
+#include "SvgInspector.h"
+
+#include "PixmapCache.h"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <QSvgRenderer>
+#include <QThreadPool>
+#include <QWheelEvent>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtMath>
+
+#include <algorithm>
+#include <memory>
+
+SvgInspector::SvgInspector(QWidget *parent)
+    : QAbstractScrollArea(parent)
+    , m_cacheOwner(PixmapCache::newOwner())
+{
+    setFocusPolicy(Qt::StrongFocus);
+    viewport()->setCursor(Qt::OpenHandCursor);
+    connect(&m_tileWatcher, &QFutureWatcherBase::resultReadyAt, this, &SvgInspector::onTileReady);
+}
+
+SvgInspector::~SvgInspector()
+{
+    m_tileWatcher.cancel();
+    m_tileWatcher.waitForFinished();
+    PixmapCache::instance().removeOwner(m_cacheOwner);
+}
+
+void SvgInspector::setDocument(const SvgDocumentPtr &document)
+{
+    m_document = document;
+    reload();
+
+    // The largest zoom at which the whole SVG is still in view
+    int zoom = 1;
+    while (zoom < kMaxZoom && m_size.width() * zoom * 2 <= viewport()->width()
+           && m_size.height() * zoom * 2 <= viewport()->height())
+        zoom *= 2;
+    m_zoom = zoom;
+    updateScrollBars();
+    horizontalScrollBar()->setValue(0);
+    verticalScrollBar()->setValue(0);
+    viewport()->update();
+    emit zoomChanged(m_zoom);
+}
+
+void SvgInspector::reload()
+{
+    // Tiles of the old content are of no use; results still arriving for it
+    // are told apart by their hash
+    m_tileWatcher.cancel();
+    m_requested.clear();
+    PixmapCache::instance().removeOwner(m_cacheOwner);
+    m_cacheOwner = PixmapCache::newOwner();
+
+    m_hash = m_document ? m_document->contentHash() : 0;
+    m_size = QSizeF();
+    if (QSvgRenderer *renderer = m_document ? m_document->renderer() : nullptr; renderer && renderer->isValid()) {
+        m_size = QSizeF(renderer->defaultSize());
+        if (m_size.isEmpty())
+            m_size = renderer->viewBoxF().size();
+    }
+    updateScrollBars();
+    viewport()->update();
+}
+
+void SvgInspector::setZoom(int zoom, const QPoint &anchor)
+{
+    // Powers of two only, so each level's tiles line up with the next one's
+    int level = 1;
+    while (level * 2 <= qMin(zoom, kMaxZoom))
+        level *= 2;
+    if (level == m_zoom)
+        return;
+
+    const QPoint at = anchor.x() < 0 ? viewport()->rect().center() : anchor;
+    const QPointF point = QPointF(at - origin()) / m_zoom; // In the SVG's own pixels
+    m_zoom = level;
+    updateScrollBars();
+    horizontalScrollBar()->setValue(qRound(point.x() * m_zoom - at.x()));
+    verticalScrollBar()->setValue(qRound(point.y() * m_zoom - at.y()));
+    viewport()->update();
+    emit zoomChanged(m_zoom);
+}
+
+void SvgInspector::setPixelGrid(bool enabled)
+{
+    m_pixelGrid = enabled;
+    viewport()->update();
+}
+
+void SvgInspector::setBackground(const QColor &color)
+{
+    m_background = color;
+    viewport()->update();
+}
+
+QSize SvgInspector::contentSize() const
+{
+    return QSize(qCeil(m_size.width() * m_zoom), qCeil(m_size.height() * m_zoom));
+}
+
+QPoint SvgInspector::origin() const
+{
+    // Centered while it fits, scrolled once it does not
+    const QSize content = contentSize();
+    const QSize view = viewport()->size();
+    return QPoint(content.width() < view.width() ? (view.width() - content.width()) / 2 : -horizontalScrollBar()->value(),
+                  content.height() < view.height() ? (view.height() - content.height()) / 2 : -verticalScrollBar()->value());
+}
+
+void SvgInspector::updateScrollBars()
+{
+    const QSize content = contentSize();
+    const QSize view = viewport()->size();
+    horizontalScrollBar()->setRange(0, qMax(0, content.width() - view.width()));
+    horizontalScrollBar()->setPageStep(view.width());
+    horizontalScrollBar()->setSingleStep(qMax(20, m_zoom));
+    verticalScrollBar()->setRange(0, qMax(0, content.height() - view.height()));
+    verticalScrollBar()->setPageStep(view.height());
+    verticalScrollBar()->setSingleStep(qMax(20, m_zoom));
+}
+
+quint64 SvgInspector::tag(const Tile &tile)
+{
+    return (quint64(qRound(tile.pixelRatio * 100)) << 8) | quint64(tile.zoom);
+}
+
+quint64 SvgInspector::spec(const Tile &tile)
+{
+    return (quint64(quint32(tile.x)) << 32) | quint32(tile.y);
+}
+
+void SvgInspector::paintEvent(QPaintEvent *event)
+{
+    if (m_document && m_document->contentHash() != m_hash)
+        reload();
+
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), m_background);
+    if (m_size.isEmpty())
+        return;
+
+    const QPoint topLeft = origin();
+    const QRect visible = QRect(topLeft, contentSize()).intersected(event->rect());
+    if (visible.isEmpty())
+        return;
+
+    // Tiles in view only; at 64× a large illustration is gigapixels whole
+    const qreal pixelRatio = devicePixelRatioF();
+    QList<Tile> missing;
+    for (int y = (visible.top() - topLeft.y()) / kTileSize; y <= (visible.bottom() - topLeft.y()) / kTileSize; ++y) {
+        for (int x = (visible.left() - topLeft.x()) / kTileSize; x <= (visible.right() - topLeft.x()) / kTileSize; ++x) {
+            const Tile tile{m_zoom, x, y, pixelRatio};
+            const QRect target(topLeft.x() + x * kTileSize, topLeft.y() + y * kTileSize, kTileSize, kTileSize);
+            const QPixmap pixmap = PixmapCache::instance().find({m_cacheOwner, tag(tile), spec(tile)});
+            if (!pixmap.isNull()) {
+                painter.drawPixmap(target.topLeft(), pixmap);
+            } else {
+                drawFallback(painter, tile, target);
+                missing.append(tile);
+            }
+        }
+    }
+
+    // On the boundaries of the SVG's own pixels, so edges that miss them show
+    if (m_pixelGrid && m_zoom >= 4) {
+        painter.setPen(QPen(m_background.lightness() > 128 ? QColor(0, 0, 0, 60) : QColor(255, 255, 255, 60), 0));
+        for (int x = visible.left() - (visible.left() - topLeft.x()) % m_zoom; x <= visible.right() + 1; x += m_zoom)
+            painter.drawLine(x, visible.top(), x, visible.bottom());
+        for (int y = visible.top() - (visible.top() - topLeft.y()) % m_zoom; y <= visible.bottom() + 1; y += m_zoom)
+            painter.drawLine(visible.left(), y, visible.right(), y);
+    }
+
+    if (!missing.isEmpty())
+        requestTiles(missing);
+}
+
+void SvgInspector::drawFallback(QPainter &painter, const Tile &tile, const QRect &target)
+{
+    // The nearest lower level that has this area, scaled up: blurry for a
+    // moment, but in place while the tile renders
+    for (int scale = 2; tile.zoom / scale >= 1; scale *= 2) {
+        const Tile lower{tile.zoom / scale, tile.x / scale, tile.y / scale, tile.pixelRatio};
+        const QPixmap pixmap = PixmapCache::instance().find({m_cacheOwner, tag(lower), spec(lower)});
+        if (pixmap.isNull())
+            continue;
+        const qreal span = qreal(kTileSize) / scale * tile.pixelRatio; // Pixels of the lower tile covering this one
+        const QRectF source((tile.x % scale) * span, (tile.y % scale) * span, span, span);
+        painter.drawPixmap(QRectF(target), pixmap, source);
+        return;
+    }
+}
+
+void SvgInspector::requestTiles(const QList<Tile> &missing)
+{
+    if (m_tileWatcher.isRunning()) {
+        const bool requested = std::all_of(missing.cbegin(), missing.cend(), [this](const Tile &tile) {
+            return m_requested.contains({tag(tile), spec(tile)});
+        });
+        if (requested)
+            return;
+        // The view moved on: tiles not started yet are dropped, and the
+        // ones still missing are asked for again below
+        m_tileWatcher.cancel();
+    }
+
+    m_requested.clear();
+    for (const Tile &tile : missing)
+        m_requested.insert({tag(tile), spec(tile)});
+    const QByteArray svg = m_document->data();
+    const quint64 hash = m_document->contentHash();
+    const QSizeF size = m_size;
+    m_tileWatcher.setFuture(QtConcurrent::mapped(QThreadPool::globalInstance(), missing, [svg, hash, size](const Tile &tile) {
+        return renderTile(svg, hash, size, tile);
+    }));
+}
+
+void SvgInspector::onTileReady(int index)
+{
+    // Results may come in for a batch since replaced, or for older content
+    const QFuture<Rendered> future = m_tileWatcher.future();
+    if (!future.isResultReadyAt(index))
+        return;
+    const Rendered rendered = future.resultAt(index);
+    if (rendered.hash != m_hash)
+        return;
+
+    const Tile &tile = rendered.tile;
+    m_requested.remove({tag(tile), spec(tile)});
+    if (rendered.image.isNull())
+        return;
+    PixmapCache::instance().insert({m_cacheOwner, tag(tile), spec(tile)}, QPixmap::fromImage(rendered.image));
+    ++m_tilesRendered;
+    if (tile.zoom == m_zoom)
+        viewport()->update(QRect(origin() + QPoint(tile.x, tile.y) * kTileSize, QSize(kTileSize, kTileSize)));
+}
+
+SvgInspector::Rendered SvgInspector::renderTile(const QByteArray &svg, quint64 hash, const QSizeF &size, const Tile &tile)
+{
+    // A renderer of its own per worker thread, kept for the next tiles: the
+    // document's parsed forms belong to the GUI thread, and parsing a large
+    // illustration for every tile would cost more than rendering it
+    thread_local quint64 parsedHash = 0;
+    thread_local std::unique_ptr<QSvgRenderer> renderer;
+    if (!renderer || parsedHash != hash) {
+        renderer = std::make_unique<QSvgRenderer>(svg);
+        parsedHash = hash;
+    }
+
+    Rendered result{tile, hash, QImage()};
+    if (!renderer->isValid())
+        return result;
+
+    const int pixels = qCeil(kTileSize * tile.pixelRatio);
+    QImage image(pixels, pixels, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    image.setDevicePixelRatio(tile.pixelRatio);
+
+    // The whole SVG at this zoom, moved so the tile's corner is at the
+    // origin; the painter clips everything outside the tile
+    QPainter painter(&image);
+    renderer->render(&painter, QRectF(-tile.x * kTileSize, -tile.y * kTileSize,
+                                      size.width() * tile.zoom, size.height() * tile.zoom));
+    painter.end();
+    result.image = image;
+    return result;
+}
+
+void SvgInspector::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+void SvgInspector::scrollContentsBy(int, int)
+{
+    viewport()->update();
+}
+
+void SvgInspector::wheelEvent(QWheelEvent *event)
+{
+    // Ctrl zooms at the cursor; the wheel alone scrolls
+    if (!(event->modifiers() & Qt::ControlModifier)) {
+        QAbstractScrollArea::wheelEvent(event);
+        return;
+    }
+    // Touchpads send small steps; a zoom level per notch of a wheel
+    m_wheelDelta += event->angleDelta().y();
+    const QPoint anchor = event->position().toPoint();
+    while (m_wheelDelta >= 120) {
+        m_wheelDelta -= 120;
+        setZoom(m_zoom * 2, anchor);
+    }
+    while (m_wheelDelta <= -120) {
+        m_wheelDelta += 120;
+        setZoom(m_zoom / 2, anchor);
+    }
+    event->accept();
+}
+
+void SvgInspector::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mousePressEvent(event);
+        return;
+    }
+    m_dragging = true;
+    m_dragStart = event->position().toPoint();
+    m_dragScroll = QPoint(horizontalScrollBar()->value(), verticalScrollBar()->value());
+    viewport()->setCursor(Qt::ClosedHandCursor);
+}
+
+void SvgInspector::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!m_dragging) {
+        QAbstractScrollArea::mouseMoveEvent(event);
+        return;
+    }
+    const QPoint moved = event->position().toPoint() - m_dragStart;
+    horizontalScrollBar()->setValue(m_dragScroll.x() - moved.x());
+    verticalScrollBar()->setValue(m_dragScroll.y() - moved.y());
+}
+
+void SvgInspector::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (!m_dragging || event->button() != Qt::LeftButton) {
+        QAbstractScrollArea::mouseReleaseEvent(event);
+        return;
+    }
+    m_dragging = false;
+    viewport()->setCursor(Qt::OpenHandCursor);
+}
+
+void SvgInspector::keyPressEvent(QKeyEvent *event)
+{
+    switch (event->key()) {
+    case Qt::Key_Plus:
+    case Qt::Key_Equal:
+        setZoom(m_zoom * 2);
+        break;
+    case Qt::Key_Minus:
+        setZoom(m_zoom / 2);
+        break;
+    default:
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
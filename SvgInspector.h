@@ -0,0 +1,110 @@
+#ifndef SVGINSPECTOR_H
+#define SVGINSPECTOR_H
+
+#include "SvgDocument.h"
+
+#include <QAbstractScrollArea>
+#include <QColor>
+#include <QFutureWatcher>
+#include <QImage>
+#include <QList>
+#include <QPair>
+#include <QPoint>
+#include <QSet>
+#include <QSizeF>
+
+// Pans and zooms a single SVG from 1× to 64× its own size, to check fine
+// detail and how edges fall on the pixel grid.
+//
+// The view is cut into tiles per zoom level. Only tiles in view are
+// rendered, on the global thread pool, and they are kept in PixmapCache
+// under the gallery's budget, so a large illustration is never rasterized
+// whole and zooming back to a level already seen is instant. Until its tile
+// arrives, an area shows the next lower level scaled up.
+class SvgInspector : public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    static constexpr int kTileSize = 256; // Logical pixels
+    static constexpr int kMaxZoom = 64;
+
+    explicit SvgInspector(QWidget *parent = nullptr);
+    ~SvgInspector() override;
+
+    // Shown from the top left at the largest zoom that fits. When the
+    // document's content changes (saved from the editor, optimized), the
+    // view follows it at the same zoom and position.
+    void setDocument(const SvgDocumentPtr &document);
+    SvgDocumentPtr document() const { return m_document; }
+
+    // Powers of two from 1 to kMaxZoom. The point of the SVG under anchor,
+    // in viewport coordinates, stays in place; by default the center.
+    int zoom() const { return m_zoom; }
+    void setZoom(int zoom, const QPoint &anchor = QPoint(-1, -1));
+
+    // Lines between the SVG's own pixels, from 4× up
+    void setPixelGrid(bool enabled);
+    void setBackground(const QColor &color);
+
+    int tilesRendered() const { return m_tilesRendered; }
+    bool isRendering() const { return m_tileWatcher.isRunning(); }
+
+signals:
+    void zoomChanged(int zoom);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+
+private:
+    struct Tile {
+        int zoom = 1;
+        int x = 0;
+        int y = 0;
+        qreal pixelRatio = 1.0;
+    };
+
+    struct Rendered {
+        Tile tile;
+        quint64 hash = 0; // Of the content rendered
+        QImage image;
+    };
+
+    static Rendered renderTile(const QByteArray &svg, quint64 hash, const QSizeF &size, const Tile &tile);
+    static quint64 tag(const Tile &tile);
+    static quint64 spec(const Tile &tile);
+
+    void reload();
+    QSize contentSize() const;
+    QPoint origin() const; // Of the content in the viewport
+    void updateScrollBars();
+    void requestTiles(const QList<Tile> &missing);
+    void onTileReady(int index);
+    void drawFallback(QPainter &painter, const Tile &tile, const QRect &target);
+
+    SvgDocumentPtr m_document;
+    quint64 m_hash = 0; // Of the content the tiles are of
+    QSizeF m_size;      // The SVG's own size, at 1×
+    int m_zoom = 1;
+    bool m_pixelGrid = false;
+    QColor m_background = QColor(90, 90, 90);
+    quint64 m_cacheOwner;
+
+    QFutureWatcher<Rendered> m_tileWatcher;
+    QSet<QPair<quint64, quint64>> m_requested; // Tags and specs being rendered
+    int m_tilesRendered = 0;
+
+    bool m_dragging = false;
+    QPoint m_dragStart;
+    QPoint m_dragScroll; // Scroll bar values when the drag started
+    int m_wheelDelta = 0; // Toward the next zoom step
+};
+
+#endif // SVGINSPECTOR_H
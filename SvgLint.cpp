@@ -0,0 +1,374 @@
+#include "SvgLint.h"
+
+#include "SvgPathParser.h"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVarLengthArray>
+#include <QXmlStreamReader>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+// Rough costs, in fills of one plain icon-sized path
+constexpr float kSegmentCost = 0.01f;        // A hundred segments fill like one path
+constexpr float kFilterPrimitiveCost = 20;   // One offscreen pass over the filter region
+constexpr float kBlurCost = 40;              // Two kernel passes per pixel
+constexpr float kMaskCost = 20;              // Offscreen layer plus a composite
+constexpr float kImageCostPerKiB = 1;        // Decoded again on every render
+constexpr float kMinImageCost = 10;
+constexpr float kViewBoxCost = 2;
+
+// Where a construct starts to matter
+constexpr int kShapeLimit = 500;
+constexpr quint32 kSegmentLimit = 10000;
+constexpr quint32 kPathSegmentLimit = 2000;  // In a single path
+constexpr int kUseChainLimit = 3;
+constexpr int kSevereImageBytes = 64 * 1024;
+constexpr double kViewBoxLimit = 4096;       // User units on a side
+constexpr double kViewBoxScaleLimit = 64;    // Units per pixel at the nominal size
+constexpr int kCycle = 1 << 20;              // Depth given to reference cycles
+
+const QLatin1String kXlinkNamespace("http://www.w3.org/1999/xlink");
+
+// QXmlStreamReader counts UTF-16 units of the decoded text; Scintilla and
+// the findings count bytes. Offsets only grow, so one walk covers the file.
+class ByteOffsets
+{
+public:
+    explicit ByteOffsets(const QByteArray &data)
+        : m_data(data)
+    {
+        // The reader drops a byte order mark
+        if (data.startsWith("\xEF\xBB\xBF"))
+            m_byte = 3;
+    }
+
+    qsizetype byteAt(qint64 characterOffset)
+    {
+        while (m_units < characterOffset && m_byte < m_data.size()) {
+            const uchar c = uchar(m_data[m_byte]);
+            const int length = c < 0x80 ? 1 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : 4;
+            m_units += length == 4 ? 2 : 1; // Beyond the BMP: a surrogate pair
+            m_byte += length;
+        }
+        return qMin(m_byte, m_data.size());
+    }
+
+private:
+    const QByteArray &m_data;
+    qsizetype m_byte = 0;
+    qint64 m_units = 0;
+};
+
+bool isShape(QStringView name)
+{
+    return name == QLatin1String("path") || name == QLatin1String("rect") || name == QLatin1String("circle")
+           || name == QLatin1String("ellipse") || name == QLatin1String("line") || name == QLatin1String("polyline")
+           || name == QLatin1String("polygon") || name == QLatin1String("text") || name == QLatin1String("image");
+}
+
+// A property from its presentation attribute or the style attribute
+QStringView property(const QXmlStreamAttributes &attributes, QLatin1String name)
+{
+    for (QStringView declaration : attributes.value(QLatin1String("style")).split(QLatin1Char(';'))) {
+        const qsizetype colon = declaration.indexOf(QLatin1Char(':'));
+        if (colon > 0 && declaration.left(colon).trimmed() == name)
+            return declaration.mid(colon + 1).trimmed();
+    }
+    return attributes.value(name);
+}
+
+// The id in url(#id), empty for anything else
+QString urlTarget(QStringView value)
+{
+    static const QRegularExpression pattern(QStringLiteral("url\\(\\s*['\"]?#([^'\")\\s]+)"));
+    const QRegularExpressionMatch match = pattern.match(value.toString());
+    return match.hasMatch() ? match.captured(1) : QString();
+}
+
+QStringView href(const QXmlStreamAttributes &attributes)
+{
+    const QStringView value = attributes.value(kXlinkNamespace, QLatin1String("href"));
+    return value.isEmpty() ? attributes.value(QLatin1String("href")) : value;
+}
+
+} // namespace
+
+QString SvgLint::ruleName(Rule rule)
+{
+    switch (rule) {
+    case Filter:
+        return QStringLiteral("filter");
+    case Mask:
+        return QStringLiteral("mask");
+    case PathCount:
+        return QStringLiteral("path count");
+    case UseChain:
+        return QStringLiteral("use chain");
+    case EmbeddedImage:
+        return QStringLiteral("embedded image");
+    case OversizedViewBox:
+        return QStringLiteral("viewBox");
+    }
+    return {};
+}
+
+SvgLint::Severity SvgLint::Report::severity() const
+{
+    for (const Finding &finding : findings) {
+        if (finding.severity == Severe)
+            return Severe;
+    }
+    return Warning;
+}
+
+QString SvgLint::Report::badge() const
+{
+    if (isClean())
+        return {};
+    // Distinct rules, most expensive first
+    QList<const Finding *> sorted;
+    for (const Finding &finding : findings)
+        sorted.append(&finding);
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Finding *a, const Finding *b) {
+        return a->cost > b->cost;
+    });
+    QStringList names;
+    for (const Finding *finding : std::as_const(sorted)) {
+        const QString name = ruleName(finding->rule);
+        if (!names.contains(name))
+            names.append(name);
+    }
+    return QStringLiteral("⚠ ") + names.join(QStringLiteral(", "));
+}
+
+QString SvgLint::Report::summary() const
+{
+    if (isClean())
+        return {};
+    QStringList lines;
+    lines.append(QString("Estimated render cost %1 path fill(s)").arg(qRound(cost)));
+    for (const Finding &finding : findings)
+        lines.append(QString("%1 (~%2): %3").arg(ruleName(finding.rule)).arg(qRound(finding.cost)).arg(finding.message));
+    return lines.join(QLatin1Char('\n'));
+}
+
+SvgLint::Report SvgLint::run(const QByteArray &data)
+{
+    struct Element {
+        int offset;
+        int length;
+        int end = -1; // Index after the last descendant
+    };
+    struct Use {
+        int element;
+        QString target;
+    };
+    struct Effect {
+        int element;
+        int primitives = 0;
+        int blurs = 0;
+    };
+
+    Report report;
+    ByteOffsets offsets(data);
+    QList<Element> elements;
+    QVarLengthArray<int, 32> open;
+    QHash<QString, int> ids;
+    QList<Use> uses;
+    QHash<QString, Effect> filters, masks; // By id
+    QHash<QString, int> filterReferences, maskReferences;
+    int filter = -1; // Open <filter>, as index into elements
+    QString filterId;
+    int shapes = 0;
+    quint32 segments = 0;
+
+    auto finding = [&](int element, Rule rule, Severity severity, float cost, const QString &message) {
+        report.findings.append({rule, severity, elements[element].offset, elements[element].length, cost, message});
+    };
+
+    QXmlStreamReader xml(data);
+    while (!xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::EndElement && !open.isEmpty()) {
+            elements[open.last()].end = int(elements.size());
+            if (open.last() == filter)
+                filter = -1;
+            open.removeLast();
+        }
+        if (token != QXmlStreamReader::StartElement)
+            continue;
+
+        // Right after the start tag's closing bracket
+        const qsizetype end = offsets.byteAt(xml.characterOffset());
+        const qsizetype start = qMax<qsizetype>(0, data.lastIndexOf('<', qMax<qsizetype>(0, end - 1)));
+        const int index = int(elements.size());
+        elements.append({int(start), int(end - start)});
+        open.append(index);
+
+        const QStringView name = xml.name();
+        const QXmlStreamAttributes attributes = xml.attributes();
+        const QString id = attributes.value(QLatin1String("id")).toString();
+        if (!id.isEmpty())
+            ids.insert(id, index);
+
+        const QString filterTarget = urlTarget(property(attributes, QLatin1String("filter")));
+        if (!filterTarget.isEmpty())
+            ++filterReferences[filterTarget];
+        const QString maskTarget = urlTarget(property(attributes, QLatin1String("mask")));
+        if (!maskTarget.isEmpty())
+            ++maskReferences[maskTarget];
+
+        if (index == 0) {
+            // Oversized against an absolute limit, and against the nominal size
+            static const QRegularExpression separator(QStringLiteral("[\\s,]+"));
+            const QList<QStringView> box = attributes.value(QLatin1String("viewBox")).split(separator, Qt::SkipEmptyParts);
+            const double side = box.size() == 4 ? qMax(box[2].toDouble(), box[3].toDouble()) : 0;
+            const double size = qMax(attributes.value(QLatin1String("width")).toDouble(),
+                                     attributes.value(QLatin1String("height")).toDouble());
+            if (side > kViewBoxLimit || (size > 0 && side / size > kViewBoxScaleLimit)) {
+                finding(index, OversizedViewBox, Warning, kViewBoxCost,
+                        size > 0 ? QString("viewBox of %1 units for a %2 px icon: long coordinates to parse, "
+                                           "hairlines vanish when scaled down").arg(side).arg(size)
+                                 : QString("viewBox of %1 units: long coordinates to parse, "
+                                           "hairlines vanish when scaled down").arg(side));
+            }
+            continue;
+        }
+
+        if (isShape(name))
+            ++shapes;
+
+        if (name == QLatin1String("path")) {
+            SvgPathParser parser;
+            parser.parsePath(attributes.value(QLatin1String("d")));
+            segments += parser.stats().segments;
+            if (parser.stats().segments > kPathSegmentLimit) {
+                finding(index, PathCount, Warning, parser.stats().segments * kSegmentCost,
+                        QString("%1 segments in one path").arg(parser.stats().segments));
+            }
+        } else if (name == QLatin1String("polyline") || name == QLatin1String("polygon")) {
+            SvgPathParser parser;
+            parser.parsePoints(attributes.value(QLatin1String("points")), name == QLatin1String("polygon"));
+            segments += parser.stats().segments;
+        } else if (name == QLatin1String("filter")) {
+            filter = index;
+            filterId = id;
+            filters.insert(id, Effect{index});
+        } else if (filter >= 0 && name.startsWith(QLatin1String("fe"))) {
+            // Primitives directly in the open filter; nested feMergeNode and
+            // the like count as part of theirs
+            if (open.size() >= 2 && open[open.size() - 2] == filter) {
+                Effect &effect = filters[filterId];
+                ++effect.primitives;
+                if (name == QLatin1String("feGaussianBlur"))
+                    ++effect.blurs;
+            }
+        } else if (name == QLatin1String("mask")) {
+            masks.insert(id, Effect{index});
+        } else if (name == QLatin1String("use")) {
+            const QStringView target = href(attributes);
+            if (target.startsWith(QLatin1Char('#')))
+                uses.append({index, target.mid(1).toString()});
+        } else if (name == QLatin1String("image")) {
+            const QStringView source = href(attributes);
+            if (source.startsWith(QLatin1String("data:"))) {
+                const int bytes = int(source.size() * 3 / 4); // Base64
+                finding(index, EmbeddedImage, bytes > kSevereImageBytes ? Severe : Warning,
+                        qMax(kMinImageCost, bytes / 1024.0f * kImageCostPerKiB),
+                        QString("%1 KiB of embedded raster data, decoded on every render").arg(bytes / 1024));
+            } else if (!source.isEmpty()) {
+                finding(index, EmbeddedImage, Warning, kMinImageCost,
+                        QStringLiteral("External raster image, loaded from disk on every render"));
+            }
+        }
+    }
+    // Elements left open by an XML error end with the document
+    for (int index : open)
+        elements[index].end = int(elements.size());
+
+    // Only effects that something uses are drawn
+    for (auto it = filters.cbegin(); it != filters.cend(); ++it) {
+        const int references = filterReferences.value(it.key());
+        if (references == 0 || it->primitives == 0)
+            continue;
+        const float cost = references * (it->primitives * kFilterPrimitiveCost + it->blurs * (kBlurCost - kFilterPrimitiveCost));
+        finding(it->element, Filter, it->blurs > 0 || it->primitives > 1 || references > 1 ? Severe : Warning, cost,
+                QString("%1 primitive(s)%2, applied %3 time(s): each is an offscreen pass over the filter region")
+                    .arg(it->primitives)
+                    .arg(it->blurs > 0 ? QStringLiteral(" with blur") : QString())
+                    .arg(references));
+    }
+    for (auto it = masks.cbegin(); it != masks.cend(); ++it) {
+        const int references = maskReferences.value(it.key());
+        if (references == 0)
+            continue;
+        finding(it->element, Mask, references > 4 ? Severe : Warning, references * kMaskCost,
+                QString("Applied %1 time(s): each masked element is drawn into an offscreen layer").arg(references));
+    }
+
+    // Depth of a use: one more than the deepest use inside what it references.
+    // Uses are in document order, and a subtree is a range of elements.
+    QList<int> depths(uses.size(), 0); // 0: not yet, -1: being resolved
+    std::function<int(int)> depthOf = [&](int use) -> int {
+        if (depths[use] == -1)
+            return kCycle;
+        if (depths[use] > 0)
+            return depths[use];
+        const int target = ids.value(uses[use].target, -1);
+        if (target < 0)
+            return depths[use] = 1;
+        depths[use] = -1;
+        int deepest = 0;
+        const auto first = std::lower_bound(uses.cbegin(), uses.cend(), target, [](const Use &u, int element) {
+            return u.element < element;
+        });
+        for (auto it = first; it != uses.cend() && it->element < elements[target].end; ++it)
+            deepest = qMax(deepest, depthOf(int(it - uses.cbegin())));
+        return depths[use] = qMin(kCycle, deepest + 1);
+    };
+    for (int i = 0; i < uses.size(); ++i) {
+        const int depth = depthOf(i);
+        if (depth < kUseChainLimit)
+            continue;
+        const int target = ids.value(uses[i].target);
+        const int copied = elements[target].end - target;
+        if (depth >= kCycle) {
+            finding(uses[i].element, UseChain, Severe, float(copied),
+                    QString("References itself through #%1").arg(uses[i].target));
+        } else {
+            finding(uses[i].element, UseChain, Warning, float(depth * copied),
+                    QString("Chain of %1 <use> levels through #%2, each resolved and copied on render")
+                        .arg(depth)
+                        .arg(uses[i].target));
+        }
+    }
+
+    const float base = shapes + segments * kSegmentCost;
+    if (shapes > kShapeLimit || segments > kSegmentLimit) {
+        finding(0, PathCount, shapes > 4 * kShapeLimit || segments > 5 * kSegmentLimit ? Severe : Warning, base,
+                QString("%1 shape(s) with %2 path segment(s)").arg(shapes).arg(segments));
+    }
+
+    std::stable_sort(report.findings.begin(), report.findings.end(), [](const Finding &a, const Finding &b) {
+        return a.offset < b.offset;
+    });
+    report.cost = base;
+    for (const Finding &item : std::as_const(report.findings)) {
+        // Path counts are the base cost itself
+        if (item.rule != PathCount)
+            report.cost += item.cost;
+    }
+    return report;
+}
+
+QFuture<SvgLint::Report> SvgLint::runAsync(const QList<QByteArray> &data)
+{
+    return QtConcurrent::mapped(QThreadPool::globalInstance(), data, &SvgLint::run);
+}
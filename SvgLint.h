@@ -0,0 +1,56 @@
+#ifndef SVGLINT_H
+#define SVGLINT_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QList>
+#include <QString>
+
+// Flags constructs that Qt's SVG renderer handles slowly, each with the
+// start tag it is about and an estimate of what it costs. Costs are in
+// units of filling one plain icon-sized path, so a clean icon costs about
+// as much as it has shapes. One streaming pass, no DOM.
+class SvgLint
+{
+public:
+    enum Rule : quint8 {
+        Filter,          // Offscreen pass over the filter region per primitive
+        Mask,            // Offscreen layer per masked element
+        PathCount,       // Too many shapes or segments to draw
+        UseChain,        // <use> of a <use> of a <use>, or a reference cycle
+        EmbeddedImage,   // Raster data decoded on every render
+        OversizedViewBox // Coordinates far larger than the icon is drawn
+    };
+
+    enum Severity : quint8 {
+        Warning,
+        Severe
+    };
+
+    struct Finding {
+        Rule rule;
+        Severity severity;
+        int offset; // Start tag, in bytes of the data
+        int length;
+        float cost;
+        QString message;
+    };
+
+    struct Report {
+        QList<Finding> findings; // In document order
+        float cost = 0;          // Whole icon, findings included
+
+        bool isClean() const { return findings.isEmpty(); }
+        Severity severity() const;
+        QString badge() const;   // Short, for the gallery item
+        QString summary() const; // One line per finding
+    };
+
+    static QString ruleName(Rule rule);
+
+    static Report run(const QByteArray &data);
+    // In order, on the global thread pool
+    static QFuture<Report> runAsync(const QList<QByteArray> &data);
+};
+
+#endif // SVGLINT_H
@@ -0,0 +1,316 @@
+#include "SvgMetadata.h"
+
+#include "SvgPathParser.h"
+
+#include <QHash>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVarLengthArray>
+#include <QXmlStreamReader>
+#include <QtConcurrent>
+
+#include <climits>
+
+static_assert(sizeof(SvgMetadata) == 84, "Kept small so large galleries sort quickly");
+
+namespace {
+
+SvgMetadata::Kind kindOf(QStringView name)
+{
+    static const QHash<QString, SvgMetadata::Kind> kinds = {
+        {"path", SvgMetadata::Path},
+        {"rect", SvgMetadata::Shape}, {"circle", SvgMetadata::Shape}, {"ellipse", SvgMetadata::Shape},
+        {"line", SvgMetadata::Shape}, {"polyline", SvgMetadata::Shape}, {"polygon", SvgMetadata::Shape},
+        {"g", SvgMetadata::Group}, {"symbol", SvgMetadata::Group}, {"svg", SvgMetadata::Group},
+        {"use", SvgMetadata::Use},
+        {"text", SvgMetadata::Text}, {"tspan", SvgMetadata::Text}, {"textPath", SvgMetadata::Text},
+        {"linearGradient", SvgMetadata::Gradient}, {"radialGradient", SvgMetadata::Gradient},
+        {"filter", SvgMetadata::Filter},
+        {"mask", SvgMetadata::Mask},
+        {"clipPath", SvgMetadata::ClipPath},
+        {"image", SvgMetadata::Image},
+    };
+    if (name.startsWith(QLatin1String("fe")) && name.size() > 2 && name[2].isUpper())
+        return SvgMetadata::Filter;
+    return kinds.value(name.toString(), SvgMetadata::Other);
+}
+
+// A length in px; relative units (%, em) have no size without a context
+float lengthOf(QStringView text)
+{
+    static const QRegularExpression pattern(
+        QStringLiteral("^\\s*([+-]?(?:\\d+\\.?\\d*|\\.\\d+)(?:[eE][+-]?\\d+)?)\\s*(px|pt|pc|mm|cm|in)?\\s*$"));
+    const QRegularExpressionMatch match = pattern.match(text.toString());
+    if (!match.hasMatch())
+        return 0;
+    const float value = match.capturedView(1).toFloat();
+    const QStringView unit = match.capturedView(2);
+    if (unit == QLatin1String("pt"))
+        return value * 4 / 3;
+    if (unit == QLatin1String("pc"))
+        return value * 16;
+    if (unit == QLatin1String("mm"))
+        return value * 96 / 25.4f;
+    if (unit == QLatin1String("cm"))
+        return value * 96 / 2.54f;
+    if (unit == QLatin1String("in"))
+        return value * 96;
+    return value;
+}
+
+// Content that is only drawn when referenced, if at all
+bool isTemplate(QStringView name)
+{
+    return name == QLatin1String("defs") || name == QLatin1String("symbol") || name == QLatin1String("clipPath")
+           || name == QLatin1String("mask") || name == QLatin1String("pattern") || name == QLatin1String("marker");
+}
+
+double number(const QXmlStreamAttributes &attributes, QLatin1String name)
+{
+    return attributes.value(name).toDouble();
+}
+
+// Feeds a basic shape or path to the parser
+void addGeometry(SvgPathParser &parser, SvgMetadata::Kind kind, QStringView name, const QXmlStreamAttributes &attributes)
+{
+    if (kind == SvgMetadata::Path) {
+        parser.parsePath(attributes.value(QLatin1String("d")));
+    } else if (name == QLatin1String("rect")) {
+        parser.addRect(number(attributes, QLatin1String("x")), number(attributes, QLatin1String("y")),
+                       number(attributes, QLatin1String("width")), number(attributes, QLatin1String("height")));
+    } else if (name == QLatin1String("circle")) {
+        const double r = number(attributes, QLatin1String("r"));
+        parser.addEllipse(number(attributes, QLatin1String("cx")), number(attributes, QLatin1String("cy")), r, r);
+    } else if (name == QLatin1String("ellipse")) {
+        parser.addEllipse(number(attributes, QLatin1String("cx")), number(attributes, QLatin1String("cy")),
+                          number(attributes, QLatin1String("rx")), number(attributes, QLatin1String("ry")));
+    } else if (name == QLatin1String("line")) {
+        parser.addLine(number(attributes, QLatin1String("x1")), number(attributes, QLatin1String("y1")),
+                       number(attributes, QLatin1String("x2")), number(attributes, QLatin1String("y2")));
+    } else if (name == QLatin1String("polyline") || name == QLatin1String("polygon")) {
+        parser.parsePoints(attributes.value(QLatin1String("points")), name == QLatin1String("polygon"));
+    }
+}
+
+// Features referenced through url() in presentation attributes or style
+quint16 referencedFeatures(const QXmlStreamAttributes &attributes)
+{
+    quint16 features = 0;
+    auto check = [&features](QStringView property, QStringView value) {
+        if (!value.contains(QLatin1String("url(")))
+            return;
+        if (property == QLatin1String("fill") || property == QLatin1String("stroke"))
+            features |= SvgMetadata::UsesGradients;
+        else if (property == QLatin1String("filter"))
+            features |= SvgMetadata::UsesFilters;
+        else if (property == QLatin1String("mask"))
+            features |= SvgMetadata::UsesMasks;
+        else if (property == QLatin1String("clip-path"))
+            features |= SvgMetadata::UsesClipPaths;
+    };
+    for (const QXmlStreamAttribute &attribute : attributes) {
+        if (attribute.name() == QLatin1String("style")) {
+            for (QStringView declaration : attribute.value().split(QLatin1Char(';'))) {
+                const qsizetype colon = declaration.indexOf(QLatin1Char(':'));
+                if (colon > 0)
+                    check(declaration.left(colon).trimmed(), declaration.mid(colon + 1));
+            }
+        } else {
+            check(attribute.name(), attribute.value());
+        }
+    }
+    return features;
+}
+
+} // namespace
+
+int SvgMetadata::elementCount() const
+{
+    int count = 0;
+    for (quint16 kindCount : counts)
+        count += kindCount;
+    return count;
+}
+
+float SvgMetadata::aspectRatio() const
+{
+    if (viewBox[2] > 0 && viewBox[3] > 0)
+        return viewBox[2] / viewBox[3];
+    if (width > 0 && height > 0)
+        return width / height;
+    return 0;
+}
+
+QString SvgMetadata::summary() const
+{
+    if (!isValid())
+        return QStringLiteral("Not a well-formed SVG");
+
+    QStringList lines;
+    if (viewBox[2] > 0 && viewBox[3] > 0)
+        lines.append(QString("viewBox %1 %2 %3 %4").arg(viewBox[0]).arg(viewBox[1]).arg(viewBox[2]).arg(viewBox[3]));
+    if (width > 0 && height > 0)
+        lines.append(QString("%1×%2 px").arg(width).arg(height));
+    lines.append(QString("%1 element(s), %2 segment(s) of which %3 curve(s), %4 byte(s)")
+                     .arg(elementCount())
+                     .arg(segments)
+                     .arg(curves)
+                     .arg(fileSize));
+    if (segments > 0)
+        lines.append(QString("Path data with up to %1 decimal(s)").arg(maxDecimals));
+    if (has(HasBounds)) {
+        QString line = QString("Drawn bounds %1 %2 %3 %4").arg(bounds[0]).arg(bounds[1]).arg(bounds[2]).arg(bounds[3]);
+        if (has(ExceedsViewBox))
+            line += QStringLiteral(", outside the viewBox");
+        if (has(Transformed))
+            line += QStringLiteral(" (before transforms)");
+        lines.append(line);
+    }
+    if (has(OffPixelGrid))
+        lines.append(QString("%1 endpoint(s) off the pixel grid").arg(offGridPoints));
+    if (has(PathErrors))
+        lines.append(QStringLiteral("Path data with errors"));
+
+    QStringList uses;
+    if (has(UsesGradients))
+        uses.append(QStringLiteral("gradients"));
+    if (has(UsesFilters))
+        uses.append(QStringLiteral("filters"));
+    if (has(UsesMasks))
+        uses.append(QStringLiteral("masks"));
+    if (has(UsesClipPaths))
+        uses.append(QStringLiteral("clip paths"));
+    if (has(UsesText))
+        uses.append(QStringLiteral("text"));
+    if (has(UsesImages))
+        uses.append(QStringLiteral("images"));
+    if (!uses.isEmpty())
+        lines.append(QStringLiteral("Uses ") + uses.join(QStringLiteral(", ")));
+    return lines.join(QLatin1Char('\n'));
+}
+
+SvgMetadata SvgMetadata::extract(const QByteArray &data)
+{
+    SvgMetadata metadata;
+    metadata.fileSize = quint32(qMin<qsizetype>(data.size(), UINT_MAX));
+
+    // Geometry in templates counts towards the cost but not the drawn bounds
+    SvgPathParser drawn, templates;
+    QVarLengthArray<bool, 32> inTemplate; // Per open element
+
+    QXmlStreamReader xml(data);
+    bool root = true;
+    while (!xml.atEnd()) {
+        const QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::EndElement && !inTemplate.isEmpty())
+            inTemplate.removeLast();
+        if (token != QXmlStreamReader::StartElement)
+            continue;
+
+        const QStringView name = xml.name();
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (attributes.hasAttribute(QLatin1String("transform")))
+            metadata.features |= Transformed;
+
+        if (root) {
+            // The outer svg sets the size and is not counted as a group
+            root = false;
+            inTemplate.append(false);
+            static const QRegularExpression separator(QStringLiteral("[\\s,]+"));
+            const QList<QStringView> numbers = attributes.value(QLatin1String("viewBox"))
+                                                   .split(separator, Qt::SkipEmptyParts);
+            if (numbers.size() == 4) {
+                for (int i = 0; i < 4; ++i)
+                    metadata.viewBox[i] = numbers[i].toFloat();
+            }
+            metadata.width = lengthOf(attributes.value(QLatin1String("width")));
+            metadata.height = lengthOf(attributes.value(QLatin1String("height")));
+
+            // Pixels at the nominal size: the width and height, else one per unit
+            SvgPathParser::Grid grid;
+            if (metadata.viewBox[2] > 0 && metadata.viewBox[3] > 0) {
+                grid.originX = metadata.viewBox[0];
+                grid.originY = metadata.viewBox[1];
+                if (metadata.width > 0 && metadata.height > 0) {
+                    grid.scaleX = metadata.width / metadata.viewBox[2];
+                    grid.scaleY = metadata.height / metadata.viewBox[3];
+                }
+            }
+            drawn = SvgPathParser(grid);
+            templates = SvgPathParser(grid);
+        } else {
+            const Kind kind = kindOf(name);
+            if (metadata.counts[kind] < 0xffff)
+                ++metadata.counts[kind];
+
+            const bool hidden = inTemplate.last() || isTemplate(name);
+            inTemplate.append(hidden);
+            if (kind == Path || kind == Shape)
+                addGeometry(hidden ? templates : drawn, kind, name, attributes);
+
+            switch (kind) {
+            case Text:
+                metadata.features |= UsesText;
+                break;
+            case Gradient:
+                metadata.features |= UsesGradients;
+                break;
+            case Filter:
+                metadata.features |= UsesFilters;
+                break;
+            case Mask:
+                metadata.features |= UsesMasks;
+                break;
+            case ClipPath:
+                metadata.features |= UsesClipPaths;
+                break;
+            case Image:
+                metadata.features |= UsesImages;
+                break;
+            default:
+                break;
+            }
+        }
+        metadata.features |= referencedFeatures(attributes);
+    }
+
+    const SvgPathParser::Stats &stats = drawn.stats();
+    metadata.segments = stats.segments + templates.stats().segments;
+    metadata.curves = stats.curves + templates.stats().curves;
+    metadata.maxDecimals = quint8(qMin(255, qMax(stats.maxDecimals, templates.stats().maxDecimals)));
+    metadata.offGridPoints = stats.offGridPoints;
+    if (stats.offGridPoints > 0)
+        metadata.features |= OffPixelGrid;
+    if (stats.error || templates.stats().error)
+        metadata.features |= PathErrors;
+
+    if (stats.hasBounds()) {
+        metadata.features |= HasBounds;
+        const QRectF bounds = stats.bounds();
+        metadata.bounds[0] = float(bounds.x());
+        metadata.bounds[1] = float(bounds.y());
+        metadata.bounds[2] = float(bounds.width());
+        metadata.bounds[3] = float(bounds.height());
+
+        // Transforms move geometry in ways not tracked here
+        QRectF box(metadata.viewBox[0], metadata.viewBox[1], metadata.viewBox[2], metadata.viewBox[3]);
+        if (box.isEmpty())
+            box = QRectF(0, 0, metadata.width, metadata.height);
+        const double tolerance = 1e-3 * qMax(box.width(), box.height());
+        if (!box.isEmpty() && !metadata.has(Transformed)
+            && (bounds.left() < box.left() - tolerance || bounds.top() < box.top() - tolerance
+                || bounds.right() > box.right() + tolerance || bounds.bottom() > box.bottom() + tolerance)) {
+            metadata.features |= ExceedsViewBox;
+        }
+    }
+
+    if (!xml.hasError() && !root)
+        metadata.features |= Parsed;
+    return metadata;
+}
+
+QFuture<SvgMetadata> SvgMetadata::extractAsync(const QList<QByteArray> &data)
+{
+    return QtConcurrent::mapped(QThreadPool::globalInstance(), data, &SvgMetadata::extract);
+}
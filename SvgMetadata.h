@@ -0,0 +1,71 @@
+#ifndef SVGMETADATA_H
+#define SVGMETADATA_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QList>
+#include <QString>
+
+// What one streaming pass over an SVG's XML finds, without building a DOM:
+// size, element counts, the features that make it expensive to render and
+// path geometry (see SvgPathParser). Plain data of 84 bytes, so tens of
+// thousands of entries sort in place.
+struct SvgMetadata
+{
+    enum Kind : quint8 {
+        Path,
+        Shape,    // rect, circle, ellipse, line, polyline, polygon
+        Group,    // g, symbol, nested svg
+        Use,
+        Text,     // text, tspan, textPath
+        Gradient, // linearGradient, radialGradient
+        Filter,   // filter and its fe* primitives
+        Mask,
+        ClipPath,
+        Image,
+        Other,
+        KindCount
+    };
+
+    enum Feature : quint16 {
+        UsesGradients = 0x01, // Defined or referenced through fill/stroke url()
+        UsesFilters = 0x02,
+        UsesMasks = 0x04,
+        UsesClipPaths = 0x08,
+        UsesText = 0x10,
+        UsesImages = 0x20,
+        HasBounds = 0x40,      // Something is drawn; bounds[] is set
+        ExceedsViewBox = 0x80, // Drawn geometry reaches outside the viewBox
+        OffPixelGrid = 0x100,  // Some endpoints miss whole and half pixels
+        Transformed = 0x200,   // Has transforms; geometry is as written, not as drawn
+        PathErrors = 0x400,    // Path data that does not parse to the end
+        Parsed = 0x8000        // Read to the end without an XML error
+    };
+
+    float viewBox[4] = {};   // x, y, width, height; all 0 if absent
+    float width = 0;         // In px from the width/height attributes, 0 if absent or relative
+    float height = 0;
+    float bounds[4] = {};    // Tight bounds of what is drawn, x, y, width, height
+    quint32 fileSize = 0;
+    quint32 segments = 0;    // Path, polyline and polygon segments
+    quint32 curves = 0;      // Of which Bézier curves and arcs
+    quint32 offGridPoints = 0; // Endpoints off the pixel grid at the nominal size
+    quint16 counts[KindCount] = {}; // Saturate at 65535
+    quint16 features = 0;
+    quint8 maxDecimals = 0;  // Most fraction digits in path data
+
+    bool isValid() const { return features & Parsed; }
+    bool has(Feature feature) const { return features & feature; }
+    int elementCount() const;
+    // Elements plus path segments: a rough measure of parse and render cost
+    int complexity() const { return elementCount() + int(segments); }
+    // Width / height from the viewBox, else the size attributes; 0 if unknown
+    float aspectRatio() const;
+    QString summary() const;
+
+    static SvgMetadata extract(const QByteArray &data);
+    // In order, on the global thread pool
+    static QFuture<SvgMetadata> extractAsync(const QList<QByteArray> &data);
+};
+
+#endif // SVGMETADATA_H
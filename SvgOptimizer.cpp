@@ -0,0 +1,502 @@
+#include "SvgOptimizer.h"
+
+#include <QDomDocument>
+#include <QDomElement>
+#include <QDomNamedNodeMap>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QLocale>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QSet>
+#include <QSvgRenderer>
+
+#include <limits>
+
+namespace {
+
+// Namespaces written by Inkscape, Sketch, Illustrator, Affinity, ...;
+// matched by URI, whatever prefix a file binds them to
+const QSet<QString> &editorNamespaces()
+{
+    static const QSet<QString> uris = {
+        QStringLiteral("http://www.inkscape.org/namespaces/inkscape"),
+        QStringLiteral("http://sodipodi.sourceforge.net/DTD/sodipodi-0.dtd"),
+        QStringLiteral("http://www.bohemiancoding.com/sketch/ns"),
+        QStringLiteral("http://www.serif.com/"),
+        QStringLiteral("http://ns.adobe.com/AdobeIllustrator/10.0/"),
+        QStringLiteral("http://ns.adobe.com/Extensibility/1.0/"),
+        QStringLiteral("http://ns.adobe.com/AdobeSVGViewerExtensions/3.0/"),
+        QStringLiteral("http://ns.adobe.com/Graphs/1.0/"),
+        QStringLiteral("http://krita.org/namespaces/svg/krita"),
+        QStringLiteral("https://boxy-svg.com"),
+        QStringLiteral("http://vectornator.io"),
+    };
+    return uris;
+}
+
+// Attributes holding numbers (or lists of numbers) that can be rounded
+const QSet<QString> &numericAttributes()
+{
+    static const QSet<QString> names = {
+        QStringLiteral("d"), QStringLiteral("points"), QStringLiteral("viewBox"),
+        QStringLiteral("transform"), QStringLiteral("gradientTransform"),
+        QStringLiteral("patternTransform"), QStringLiteral("x"), QStringLiteral("y"),
+        QStringLiteral("width"), QStringLiteral("height"), QStringLiteral("cx"),
+        QStringLiteral("cy"), QStringLiteral("r"), QStringLiteral("rx"), QStringLiteral("ry"),
+        QStringLiteral("x1"), QStringLiteral("y1"), QStringLiteral("x2"), QStringLiteral("y2"),
+        QStringLiteral("fx"), QStringLiteral("fy"), QStringLiteral("stroke-width"),
+    };
+    return names;
+}
+
+// Group attributes that must not be pushed down onto a single child
+const QSet<QString> &groupOnlyAttributes()
+{
+    static const QSet<QString> names = {
+        QStringLiteral("id"), QStringLiteral("class"), QStringLiteral("style"),
+        QStringLiteral("clip-path"), QStringLiteral("mask"), QStringLiteral("filter"),
+    };
+    return names;
+}
+
+QString prefixOf(const QString &qualifiedName)
+{
+    const qsizetype colon = qualifiedName.indexOf(QLatin1Char(':'));
+    return colon > 0 ? qualifiedName.left(colon) : QString();
+}
+
+// Namespace URIs by prefix, the default namespace under an empty one. The
+// document is parsed without namespace processing so it serializes as
+// written; declarations are resolved here instead.
+using Namespaces = QHash<QString, QString>;
+
+Namespaces namespacesAt(const QDomElement &element, Namespaces inherited)
+{
+    const QDomNamedNodeMap attrs = element.attributes();
+    for (int i = 0; i < attrs.count(); ++i) {
+        const QDomAttr attr = attrs.item(i).toAttr();
+        if (attr.name() == QLatin1String("xmlns"))
+            inherited.insert(QString(), attr.value());
+        else if (attr.name().startsWith(QLatin1String("xmlns:")))
+            inherited.insert(attr.name().mid(6), attr.value());
+    }
+    return inherited;
+}
+
+// Unprefixed attributes are in no namespace; unprefixed elements in the default one
+bool isEditorName(const QString &qualifiedName, const Namespaces &namespaces, bool element)
+{
+    const QString prefix = prefixOf(qualifiedName);
+    if (prefix.isEmpty() && !element)
+        return false;
+    const auto it = namespaces.constFind(prefix);
+    return it != namespaces.constEnd() && editorNamespaces().contains(*it);
+}
+
+QList<QDomElement> childElements(const QDomElement &parent)
+{
+    QList<QDomElement> result;
+    for (QDomElement e = parent.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+        result.append(e);
+    return result;
+}
+
+QList<QDomAttr> attributesOf(const QDomElement &element)
+{
+    QList<QDomAttr> result;
+    const QDomNamedNodeMap attrs = element.attributes();
+    for (int i = 0; i < attrs.count(); ++i)
+        result.append(attrs.item(i).toAttr());
+    return result;
+}
+
+void collectReferences(const QDomElement &element, QSet<QString> &refs)
+{
+    static const QRegularExpression urlRef(QStringLiteral("url\\(\\s*['\"]?#([^)'\"\\s]+)"));
+
+    for (const QDomAttr &attr : attributesOf(element)) {
+        const QString value = attr.value();
+        if ((attr.name() == QLatin1String("href") || attr.name() == QLatin1String("xlink:href"))
+            && value.startsWith(QLatin1Char('#'))) {
+            refs.insert(value.mid(1));
+        }
+        for (auto it = urlRef.globalMatch(value); it.hasNext();)
+            refs.insert(it.next().captured(1));
+    }
+    if (element.tagName() == QLatin1String("style")) {
+        for (auto it = urlRef.globalMatch(element.text()); it.hasNext();)
+            refs.insert(it.next().captured(1));
+    }
+    for (const QDomElement &child : childElements(element))
+        collectReferences(child, refs);
+}
+
+bool hasReferencedId(const QDomElement &element, const QSet<QString> &refs)
+{
+    if (element.hasAttribute(QStringLiteral("id")) && refs.contains(element.attribute(QStringLiteral("id"))))
+        return true;
+    for (const QDomElement &child : childElements(element)) {
+        if (hasReferencedId(child, refs))
+            return true;
+    }
+    return false;
+}
+
+void collectPrefixes(const QDomElement &element, QSet<QString> &prefixes)
+{
+    prefixes.insert(prefixOf(element.tagName()));
+    for (const QDomAttr &attr : attributesOf(element)) {
+        if (!attr.name().startsWith(QLatin1String("xmlns")))
+            prefixes.insert(prefixOf(attr.name()));
+    }
+    for (const QDomElement &child : childElements(element))
+        collectPrefixes(child, prefixes);
+}
+
+void removeNamespaceDeclarations(QDomElement &element, const QSet<QString> &usedPrefixes)
+{
+    for (const QDomAttr &attr : attributesOf(element)) {
+        if (attr.name().startsWith(QLatin1String("xmlns:"))
+            && !usedPrefixes.contains(attr.name().mid(6))) {
+            element.removeAttribute(attr.name());
+        }
+    }
+    for (QDomElement &child : childElements(element))
+        removeNamespaceDeclarations(child, usedPrefixes);
+}
+
+// Editor attributes and elements, comments and <metadata>
+void removeEditorContent(QDomElement &element, const Namespaces &inherited)
+{
+    const Namespaces namespaces = namespacesAt(element, inherited);
+    for (const QDomAttr &attr : attributesOf(element)) {
+        if (isEditorName(attr.name(), namespaces, false))
+            element.removeAttribute(attr.name());
+    }
+
+    QDomNode node = element.firstChild();
+    while (!node.isNull()) {
+        QDomNode next = node.nextSibling();
+
+        if (node.isComment()) {
+            element.removeChild(node);
+        } else if (node.isElement()) {
+            QDomElement child = node.toElement();
+            const QString tag = child.tagName();
+            if (tag == QLatin1String("metadata") || isEditorName(tag, namespacesAt(child, namespaces), true))
+                element.removeChild(node);
+            else
+                removeEditorContent(child, namespaces);
+        }
+        node = next;
+    }
+}
+
+} // namespace
+
+SvgOptimizer::SvgOptimizer(const Options &options)
+    : m_options(options)
+{
+}
+
+QByteArray SvgOptimizer::optimize(const QByteArray &svg, QString *error) const
+{
+    QDomDocument doc;
+    const QDomDocument::ParseResult result = doc.setContent(svg);
+    if (!result) {
+        if (error) {
+            *error = QStringLiteral("%1 (line %2, column %3)")
+                         .arg(result.errorMessage)
+                         .arg(result.errorLine)
+                         .arg(result.errorColumn);
+        }
+        return {};
+    }
+
+    QDomElement root = doc.documentElement();
+    if (root.tagName() != QLatin1String("svg")) {
+        if (error)
+            *error = QStringLiteral("Not an SVG document");
+        return {};
+    }
+
+    if (m_options.removeMetadata) {
+        for (QDomNode node = doc.firstChild(); !node.isNull();) {
+            QDomNode next = node.nextSibling();
+            if (node.isComment())
+                doc.removeChild(node);
+            node = next;
+        }
+        removeMetadata(root);
+    }
+    if (m_options.removeUnusedDefs)
+        removeUnusedDefs(root);
+    if (m_options.collapseGroups)
+        collapseGroups(root);
+    if (m_options.precision >= 0)
+        roundNumbers(root);
+    removeUnusedNamespaces(root);
+
+    return doc.toByteArray(-1);
+}
+
+SvgOptimizer::Report SvgOptimizer::run(const QByteArray &svg, QByteArray *optimized, int renderSize) const
+{
+    Report report;
+    const QByteArray result = optimize(svg, &report.error);
+    if (result.isEmpty())
+        return report;
+
+    report.before = measure(svg, renderSize);
+    report.after = measure(result, renderSize);
+    report.diff = VisualDiff::compareSvgs(svg, result, {16, 32, renderSize});
+    report.ok = true;
+
+    if (optimized)
+        *optimized = result;
+    return report;
+}
+
+SvgOptimizer::Metrics SvgOptimizer::measure(const QByteArray &svg, int renderSize)
+{
+    // Best of a few runs, so a single cold run does not dominate
+    constexpr int kRuns = 5;
+
+    Metrics metrics;
+    metrics.bytes = svg.size();
+    metrics.parseMs = metrics.renderMs = std::numeric_limits<double>::max();
+
+    QElapsedTimer timer;
+    for (int i = 0; i < kRuns; ++i) {
+        timer.start();
+        QSvgRenderer renderer(svg);
+        metrics.parseMs = qMin(metrics.parseMs, timer.nsecsElapsed() / 1e6);
+    }
+
+    QSvgRenderer renderer(svg);
+    renderer.setAspectRatioMode(Qt::KeepAspectRatio);
+    QImage image(renderSize, renderSize, QImage::Format_ARGB32_Premultiplied);
+    for (int i = 0; i < kRuns; ++i) {
+        image.fill(Qt::transparent);
+        timer.start();
+        QPainter painter(&image);
+        renderer.render(&painter);
+        painter.end();
+        metrics.renderMs = qMin(metrics.renderMs, timer.nsecsElapsed() / 1e6);
+    }
+    return metrics;
+}
+
+QString SvgOptimizer::Report::summary() const
+{
+    if (!ok)
+        return error;
+
+    const QLocale locale;
+    // Signed, since a file can come out bigger
+    const double change = before.bytes ? 100.0 * (after.bytes - before.bytes) / before.bytes : 0.0;
+    QString text = QStringLiteral("%1 → %2 (%3%), parse %4 → %5 ms, render %6 → %7 ms")
+                       .arg(locale.formattedDataSize(before.bytes),
+                            locale.formattedDataSize(after.bytes))
+                       .arg(QString::asprintf("%+.1f", change))
+                       .arg(before.parseMs, 0, 'f', 2)
+                       .arg(after.parseMs, 0, 'f', 2)
+                       .arg(before.renderMs, 0, 'f', 2)
+                       .arg(after.renderMs, 0, 'f', 2);
+    if (pixelsChanged()) {
+        text += QStringLiteral(", PIXELS CHANGED (%1 px, max delta %2)")
+                    .arg(diff.changedPixels)
+                    .arg(diff.maxDelta);
+    } else {
+        text += QStringLiteral(", pixels unchanged");
+    }
+    return text;
+}
+
+void SvgOptimizer::removeMetadata(QDomElement &element) const
+{
+    removeEditorContent(element, Namespaces());
+}
+
+void SvgOptimizer::roundNumbers(QDomElement &element) const
+{
+    for (const QDomAttr &attr : attributesOf(element)) {
+        if (numericAttributes().contains(attr.name()))
+            element.setAttribute(attr.name(), roundNumberList(attr.value()));
+    }
+    for (QDomElement &child : childElements(element))
+        roundNumbers(child);
+}
+
+void SvgOptimizer::collapseGroups(QDomElement &element) const
+{
+    for (QDomElement &child : childElements(element))
+        collapseGroups(child);
+
+    for (QDomElement &group : childElements(element)) {
+        if (group.tagName() != QLatin1String("g"))
+            continue;
+
+        const QList<QDomAttr> groupAttrs = attributesOf(group);
+
+        // <g> without attributes: hoist the children
+        if (groupAttrs.isEmpty()) {
+            while (group.hasChildNodes())
+                element.insertBefore(group.firstChild(), group);
+            element.removeChild(group);
+            continue;
+        }
+
+        // <g> with a single child element: push the attributes down
+        const QList<QDomElement> children = childElements(group);
+        if (children.size() != 1 || group.childNodes().count() != 1)
+            continue;
+
+        QDomElement child = children.first();
+        bool movable = true;
+        for (const QDomAttr &attr : groupAttrs) {
+            if (groupOnlyAttributes().contains(attr.name())
+                || (attr.name() != QLatin1String("transform") && child.hasAttribute(attr.name()))) {
+                movable = false;
+                break;
+            }
+        }
+        if (!movable)
+            continue;
+
+        for (const QDomAttr &attr : groupAttrs) {
+            QString value = attr.value();
+            if (attr.name() == QLatin1String("transform") && child.hasAttribute(attr.name()))
+                value += QLatin1Char(' ') + child.attribute(attr.name());
+            child.setAttribute(attr.name(), value);
+        }
+        element.insertBefore(child, group);
+        element.removeChild(group);
+    }
+}
+
+void SvgOptimizer::removeUnusedDefs(QDomElement &root) const
+{
+    // Repeat until stable: removing a def can orphan the defs it referenced
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        QSet<QString> refs;
+        collectReferences(root, refs);
+
+        const QDomNodeList defsList = root.elementsByTagName(QStringLiteral("defs"));
+        QList<QDomElement> allDefs;
+        for (int i = 0; i < defsList.count(); ++i)
+            allDefs.append(defsList.at(i).toElement());
+
+        for (QDomElement &defs : allDefs) {
+            for (const QDomElement &def : childElements(defs)) {
+                if (def.tagName() == QLatin1String("style") || hasReferencedId(def, refs))
+                    continue;
+                defs.removeChild(def);
+                changed = true;
+            }
+            if (!defs.hasChildNodes()) {
+                defs.parentNode().removeChild(defs);
+                changed = true;
+            }
+        }
+    }
+}
+
+void SvgOptimizer::removeUnusedNamespaces(QDomElement &root) const
+{
+    QSet<QString> used;
+    collectPrefixes(root, used);
+    removeNamespaceDeclarations(root, used);
+}
+
+QString SvgOptimizer::roundNumberList(const QString &text) const
+{
+    auto isDigit = [](QChar c) { return c >= QLatin1Char('0') && c <= QLatin1Char('9'); };
+
+    QString out;
+    out.reserve(text.size());
+
+    const qsizetype n = text.size();
+    qsizetype i = 0;
+    while (i < n) {
+        const QChar c = text[i];
+        const bool signedStart = (c == QLatin1Char('-') || c == QLatin1Char('+')) && i + 1 < n
+                                 && (isDigit(text[i + 1]) || text[i + 1] == QLatin1Char('.'));
+        const bool numberStart = isDigit(c) || signedStart
+                                 || (c == QLatin1Char('.') && i + 1 < n && isDigit(text[i + 1]));
+        if (!numberStart) {
+            out += c;
+            ++i;
+            continue;
+        }
+
+        // [+-]? digits? ('.' digits*)? ([eE][+-]?digits)?
+        const qsizetype start = i;
+        if (signedStart)
+            ++i;
+        while (i < n && isDigit(text[i]))
+            ++i;
+        bool fraction = false;
+        if (i < n && text[i] == QLatin1Char('.')) {
+            fraction = true;
+            ++i;
+            while (i < n && isDigit(text[i]))
+                ++i;
+        }
+        bool exponent = false;
+        if (i + 1 < n && (text[i] == QLatin1Char('e') || text[i] == QLatin1Char('E'))) {
+            qsizetype j = i + 1;
+            if (j < n && (text[j] == QLatin1Char('-') || text[j] == QLatin1Char('+')))
+                ++j;
+            if (j < n && isDigit(text[j])) {
+                exponent = true;
+                i = j;
+                while (i < n && isDigit(text[i]))
+                    ++i;
+            }
+        }
+
+        const QString token = text.mid(start, i - start);
+        const qsizetype digitsStart = signedStart ? 1 : 0;
+        const bool leadingZeroRun = token.size() > digitsStart + 1
+                                    && token[digitsStart] == QLatin1Char('0')
+                                    && isDigit(token[digitsStart + 1]);
+
+        // Integers stay as they are; "01.5" only occurs with packed arc flags
+        if ((!fraction && !exponent) || leadingZeroRun) {
+            out += token;
+            continue;
+        }
+
+        QString rounded = QString::number(token.toDouble(), 'f', m_options.precision);
+        if (rounded.contains(QLatin1Char('.'))) {
+            while (rounded.endsWith(QLatin1Char('0')))
+                rounded.chop(1);
+            if (rounded.endsWith(QLatin1Char('.')))
+                rounded.chop(1);
+        }
+        if (rounded == QLatin1String("-0"))
+            rounded = QStringLiteral("0");
+        if (rounded.startsWith(QLatin1String("0.")))
+            rounded.remove(0, 1);
+        else if (rounded.startsWith(QLatin1String("-0.")))
+            rounded.remove(1, 1);
+
+        if (rounded.size() > token.size())
+            rounded = token;
+
+        out += rounded;
+
+        // "1.0004.5" must not collapse into "1.5"
+        if (i < n && text[i] == QLatin1Char('.') && !rounded.contains(QLatin1Char('.'))
+            && !rounded.contains(QLatin1Char('e'), Qt::CaseInsensitive)) {
+            out += QLatin1Char(' ');
+        }
+    }
+    return out;
+}
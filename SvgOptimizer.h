@@ -0,0 +1,64 @@
+#ifndef SVGOPTIMIZER_H
+#define SVGOPTIMIZER_H
+
+#include "VisualDiff.h"
+
+#include <QByteArray>
+#include <QString>
+
+class QDomElement;
+class QDomNode;
+
+// Lossless-ish cleanup of SVGs exported from design tools (a small subset of svgo):
+// editor metadata, excessive number precision, redundant groups and unused defs.
+class SvgOptimizer
+{
+public:
+    struct Options {
+        int precision = 3;            // Decimals kept in path data and coordinates
+        bool removeMetadata = true;   // <metadata>, comments, editor namespaces
+        bool collapseGroups = true;   // Attribute-less <g> and single-child groups
+        bool removeUnusedDefs = true; // Unreferenced children of <defs>
+    };
+
+    // Cost of handing an SVG to QSvgRenderer
+    struct Metrics {
+        qint64 bytes = 0;
+        double parseMs = 0.0;
+        double renderMs = 0.0;
+    };
+
+    struct Report {
+        bool ok = false;
+        QString error;
+        Metrics before;
+        Metrics after;
+        VisualDiff::Result diff;
+
+        bool pixelsChanged() const { return !diff.identical(); }
+        QString summary() const;
+    };
+
+    explicit SvgOptimizer(const Options &options = Options());
+
+    // Returns the optimized document, or an empty array on parse errors
+    QByteArray optimize(const QByteArray &svg, QString *error = nullptr) const;
+
+    // Optimizes, measures both versions and runs the visual-diff check
+    Report run(const QByteArray &svg, QByteArray *optimized, int renderSize = 64) const;
+
+    static Metrics measure(const QByteArray &svg, int renderSize);
+
+private:
+    void removeMetadata(QDomElement &element) const;
+    void roundNumbers(QDomElement &element) const;
+    void collapseGroups(QDomElement &element) const;
+    void removeUnusedDefs(QDomElement &root) const;
+    void removeUnusedNamespaces(QDomElement &root) const;
+
+    QString roundNumberList(const QString &text) const;
+
+    Options m_options;
+};
+
+#endif // SVGOPTIMIZER_H
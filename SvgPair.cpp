@@ -1,104 +1,98 @@
 #include "SvgPair.h"
+
+#include "PixmapCache.h"
+
+#include <QBuffer>
 #include <QByteArray>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
+#include <QFontMetrics>
 #include <QIcon>
-#include <QIconEngine>
+#include <QImageReader>
 #include <QMouseEvent>
+#include <QPaintEvent>
 #include <QPainter>
 #include <QPixmap>
-#include <QSvgRenderer>
-#include <QTextStream>
-
-struct SvgIconEngine : QIconEngine
+#include <QStyle>
+#include <QStyleOptionToolButton>
+
+namespace {
+
+// Geometry of the former widget layout, kept so the cell looks the same
+constexpr int kMargin = 10;         // Around the whole cell
+constexpr int kNameSpacing = 5;     // Between filename and icon row
+constexpr int kNoteSpacing = 8;     // Between filename and duplicate note
+constexpr int kPairSpacing = 15;    // Between icon pairs
+constexpr int kTypeSpacing = 2;     // Between type label and buttons
+constexpr int kButtonSpacing = 5;   // Between the Off and On buttons
+constexpr int kLabelSpacing = 1;    // Between a button and its label
+constexpr int kButtonPadding = 4;   // Button size over icon size
+constexpr int kBadgePadding = 4;    // Around the lint badge text
+
+// Fonts are shared; colors come from the palette roles set by GalleryTheme
+QFont pixelFont(int pixelSize, bool bold)
 {
-    QByteArray svg; // SVG text encoded in UTF-8
-
-    SvgIconEngine() = default;
-    SvgIconEngine(QByteArray const& svg) : svg(svg) {}
-    SvgIconEngine(QString const& path)
-    {
-        QFile f(path);
-        if (!f.open(QIODeviceBase::Text | QIODeviceBase::ReadOnly))
-            return;
-
-        QTextStream t(&f);
-        QString s = t.readAll();
-        if (!s.contains("</svg>", Qt::CaseInsensitive))
-            return;
+    QFont font;
+    font.setPixelSize(pixelSize);
+    font.setBold(bold);
+    return font;
+}
 
-        svg = s.toUtf8();
-    }
+const QFont &nameFont()  { static const QFont font = pixelFont(11, true);  return font; }
+const QFont &typeFont()  { static const QFont font = pixelFont(9, true);   return font; }
+const QFont &stateFont() { static const QFont font = pixelFont(8, false);  return font; }
 
-    QPixmap pixmap(
-        QSize const& size,
-        QIcon::Mode mode,
-        QIcon::State state) override
-    {
-        QSvgRenderer renderer(svg);
-        if (!renderer.isValid())
-            return {};
-
-        QPixmap p(size);
-        p.fill(Qt::transparent);
-        QPainter painter(&p);
-        renderer.setAspectRatioMode(Qt::KeepAspectRatio);
-        renderer.render(&painter);
-
-        QIcon icon(p);
-        return icon.pixmap(size, mode, state);
-    }
+QString duplicateNote(const QString &fileName)
+{
+    return SvgPair::tr("= %1").arg(fileName);
+}
 
-    void paint(
-        QPainter* painter,
-        QRect const& rect,
-        QIcon::Mode mode,
-        QIcon::State state) override
-    {
-        QPixmap p = pixmap(rect.size(), mode, state);
-        painter->drawPixmap(rect, p);
-    }
+void drawCentered(QPainter &painter, const QRect &rect, const QPixmap &pixmap, int size)
+{
+    QRect target(0, 0, size, size);
+    target.moveCenter(rect.center());
+    painter.drawPixmap(target, pixmap);
+}
 
-    QIconEngine* clone() const override {
-        return new SvgIconEngine(svg);
-    }
-};
+} // namespace
 
 SvgPair::SvgPair(
     const QString &svgPath,
     const QStringList &pngPaths,
     int iconSize,
-    bool customEngine,
+    const QList<RenderBackend*> &backends,
+    const QList<qreal> &pixelRatios,
+    QWidget *parent)
+: SvgPair(SvgDocument::fromFile(svgPath), readFiles(pngPaths), iconSize, backends, pixelRatios, parent)
+{
+}
+
+SvgPair::SvgPair(
+    const SvgDocumentPtr &document,
+    const QList<FolderFile> &pngs,
+    int iconSize,
+    const QList<RenderBackend*> &backends,
+    const QList<qreal> &pixelRatios,
     QWidget *parent)
 : QWidget(parent)
-, m_svgPath(svgPath)
+, m_fileName(QFileInfo(document->path()).fileName())
+, m_document(document)
 , m_iconSize(iconSize)
-, m_customEngine(customEngine)
-{
-    // Main layout
-    QVBoxLayout *mainLayout = new QVBoxLayout(this);
-    mainLayout->setContentsMargins(10, 10, 10, 10);
-    mainLayout->setSpacing(5);
-    
-    // Filename label at the top
-    QFileInfo fileInfo(svgPath);
-    m_filenameLabel = new QLabel(fileInfo.fileName(), this);
-    m_filenameLabel->setAlignment(Qt::AlignLeft);
-    m_filenameLabel->setStyleSheet("font-weight: bold; font-size: 11px;");
-    mainLayout->addWidget(m_filenameLabel);
-    
-    // Horizontal layout for all icons (SVG + PNGs)
-    m_iconsLayout = new QHBoxLayout();
-    m_iconsLayout->setSpacing(15);
-    
-    // Add SVG first
-    createIconPair(svgPath, "SVG", m_iconSize, true);
-    
-    // Add PNGs
-    for (const QString &pngPath : pngPaths) {
-        QFileInfo pngInfo(pngPath);
-        QString baseName = pngInfo.completeBaseName();
-        
+, m_backends(backends)
+, m_pixelRatios(pixelRatios.isEmpty() ? QList<qreal>{0} : pixelRatios)
+, m_cacheOwner(PixmapCache::newOwner())
+{
+    setMouseTracking(true);
+    setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+
+    // Add SVG first, once per backend and pixel ratio
+    createSvgIconPairs();
+
+    // Add PNGs; the bytes are kept and decoded into PixmapCache when painted
+    for (const FolderFile &png : pngs) {
+        QString baseName = QFileInfo(png.name).completeBaseName();
+
         // Extract size from filename (e.g., "icon_48" -> 48)
         int pngSize = 32; // default
         QStringList parts = baseName.split('_');
@@ -109,269 +103,461 @@ SvgPair::SvgPair(
                 pngSize = size;
             }
         }
-        
-        // If no size suffix found, try to detect from image
-        if (pngSize == 32 && baseName.split('_').size() < 2) {
-            QPixmap pixmap(pngPath);
-            if (!pixmap.isNull()) {
-                pngSize = pixmap.width();
-            }
+
+        // If no size suffix found, try to detect from the header
+        if (pngSize == 32 && parts.size() < 2) {
+            QBuffer buffer;
+            buffer.setData(png.data);
+            const QSize imageSize = QImageReader(&buffer, "PNG").size();
+            if (imageSize.isValid())
+                pngSize = imageSize.width();
         }
-        
+
         QString label = QString("PNG %1×%1").arg(pngSize);
-        createIconPair(pngPath, label, pngSize, false);
+        m_iconPairs.append(createIconPair(QIcon(), label, pngSize, false));
+        m_iconPairs.last().pixelRatio = m_pixelRatios.first();
+        m_iconPairs.last().pngName = png.name;
+        m_iconPairs.last().png = png.data;
+        m_iconPairs.last().pngIndex = int(m_iconPairs.size()) - 1 - m_svgCount;
+    }
+
+    rebuildLayout();
+}
+
+SvgPair::~SvgPair()
+{
+    // SVG renders belong to the document's content and go with it
+    PixmapCache::instance().removeOwner(m_cacheOwner);
+}
+
+QList<FolderFile> SvgPair::pngFiles() const
+{
+    QList<FolderFile> files;
+    for (int i = m_svgCount; i < m_iconPairs.size(); ++i)
+        files.append(FolderFile{m_iconPairs[i].pngName, m_iconPairs[i].png});
+    return files;
+}
+
+QList<FolderFile> SvgPair::readFiles(const QStringList &paths)
+{
+    QList<FolderFile> files;
+    for (const QString &path : paths) {
+        QFile file(path);
+        files.append(FolderFile{QFileInfo(path).fileName(), file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray()});
     }
-    
-    m_iconsLayout->addStretch();
-    mainLayout->addLayout(m_iconsLayout);
-    
-    // Widget style
-    setStyleSheet(
-        "SvgPair {"
-        "    background-color: rgba(200, 200, 200, 30);"
-        "    border: 1px solid rgba(150, 150, 150, 50);"
-        "    border-radius: 5px;"
-        "}"
-    );
-}
-
-void SvgPair::createIconPair(const QString &path, const QString &label, int size, bool isSvg)
+    return files;
+}
+
+SvgPair::IconPair SvgPair::createIconPair(const QIcon &icon, const QString &label, int size, bool isSvg) const
 {
     IconPair pair;
+    pair.icon = icon;
+    pair.label = label;
     pair.originalSize = size;
-    
-    // Load icon
-    QIcon icon;
-    if (isSvg && m_customEngine) {
-        icon = QIcon(new SvgIconEngine(path));
-    } else {
-        icon = QIcon(path);
-    }
-    
-    // Create vertical layout for this icon pair
-    QVBoxLayout *pairLayout = new QVBoxLayout();
-    pairLayout->setSpacing(2);
-    
-    // Type label (SVG, PNG 32x32, etc.)
-    pair.typeLabel = new QLabel(label, this);
-    pair.typeLabel->setAlignment(Qt::AlignCenter);
-    pair.typeLabel->setStyleSheet("font-size: 9px; font-weight: bold; color: #666;");
-    pairLayout->addWidget(pair.typeLabel);
-    
-    // Horizontal layout for disabled/enabled buttons
-    QHBoxLayout *buttonsLayout = new QHBoxLayout();
-    buttonsLayout->setSpacing(5);
-    
-    // Disabled button
-    pair.disabledButton = new QToolButton(this);
-    pair.disabledButton->setIcon(icon);
-    
-    // For PNGs, use original size; for SVGs, use current iconSize
-    int displaySize = isSvg ? m_iconSize : size;
-    pair.disabledButton->setIconSize(QSize(displaySize, displaySize));
-    pair.disabledButton->setAutoRaise(true);
-    pair.disabledButton->setEnabled(false);
-    pair.disabledButton->setFixedSize(displaySize + 4, displaySize + 4);
-    
-    // Enabled button
-    pair.enabledButton = new QToolButton(this);
-    pair.enabledButton->setIcon(icon);
-    pair.enabledButton->setIconSize(QSize(displaySize, displaySize));
-    pair.enabledButton->setAutoRaise(true);
-    pair.enabledButton->setEnabled(true);
-    pair.enabledButton->setCheckable(true);
-    pair.enabledButton->setFixedSize(displaySize + 4, displaySize + 4);
-    
-    // Disabled label
-    pair.disabledLabel = new QLabel(tr("Off"), this);
-    pair.disabledLabel->setAlignment(Qt::AlignCenter);
-    pair.disabledLabel->setStyleSheet("color: gray; font-size: 8px;");
-    
-    // Enabled label
-    pair.enabledLabel = new QLabel(tr("On"), this);
-    pair.enabledLabel->setAlignment(Qt::AlignCenter);
-    pair.enabledLabel->setStyleSheet("color: black; font-size: 8px;");
-    
-    // Add disabled button and label
-    QVBoxLayout *disabledLayout = new QVBoxLayout();
-    disabledLayout->setSpacing(1);
-    disabledLayout->addWidget(pair.disabledButton, 0, Qt::AlignCenter);
-    disabledLayout->addWidget(pair.disabledLabel);
-    
-    // Add enabled button and label
-    QVBoxLayout *enabledLayout = new QVBoxLayout();
-    enabledLayout->setSpacing(1);
-    enabledLayout->addWidget(pair.enabledButton, 0, Qt::AlignCenter);
-    enabledLayout->addWidget(pair.enabledLabel);
-    
-    buttonsLayout->addLayout(disabledLayout);
-    buttonsLayout->addLayout(enabledLayout);
-    
-    pairLayout->addLayout(buttonsLayout);
-    
-    // Add to main icons layout
-    m_iconsLayout->addLayout(pairLayout);
-    
-    // Store the pair
-    m_iconPairs.append(pair);
+    pair.isSvg = isSvg;
+    return pair;
 }
 
-void SvgPair::setIconSize(int size)
+void SvgPair::createSvgIconPairs()
 {
-    m_iconSize = size;
+    m_svgCount = 0;
+    for (RenderBackend *backend : m_backends) {
+        const QIcon icon = backend->icon(m_document);
+        for (qreal ratio : m_pixelRatios) {
+            QString label = m_backends.size() == 1 ? QString("SVG") : QString("SVG · %1").arg(backend->name());
+            if (ratio > 0)
+                label += QString(" @%1×").arg(ratio);
+            IconPair pair = createIconPair(icon, label, m_iconSize, true);
+            pair.pixelRatio = ratio;
+            pair.backend = backend;
+            m_iconPairs.insert(m_svgCount++, pair);
+        }
+    }
+}
 
-    // Update SVG icon size
-    IconPair &svgPair = m_iconPairs[0];
-    svgPair.disabledButton->setIconSize(QSize(m_iconSize, m_iconSize));
-    svgPair.disabledButton->setFixedSize(m_iconSize + 4, m_iconSize + 4);
-    svgPair.enabledButton->setIconSize(QSize(m_iconSize, m_iconSize));
-    svgPair.enabledButton->setFixedSize(m_iconSize + 4, m_iconSize + 4);
+void SvgPair::setBackends(const QList<RenderBackend*> &backends)
+{
+    // Replace the SVG pairs only; PNG pairs stay as they are
+    m_iconPairs.remove(0, m_svgCount);
+    m_hovered = -1;
 
-    // Rebuild the layout with closest PNG next to SVG
+    m_backends = backends;
+    createSvgIconPairs();
     rebuildLayout();
+}
+
+void SvgPair::setPixelRatios(const QList<qreal> &pixelRatios)
+{
+    m_pixelRatios = pixelRatios.isEmpty() ? QList<qreal>{0} : pixelRatios;
+    for (int i = m_svgCount; i < m_iconPairs.size(); ++i)
+        m_iconPairs[i].pixelRatio = m_pixelRatios.first();
 
-    updateGeometry();
+    // SVG pairs depend on the list, recreate them
+    setBackends(m_backends);
 }
 
-void SvgPair::rebuildLayout()
+int SvgPair::displaySize(const IconPair &pair) const
 {
-    // Store all existing layouts temporarily
-    QList<QVBoxLayout*> pairLayouts;
+    // For PNGs, use original size; for SVGs, use current iconSize
+    return pair.isSvg ? m_iconSize : pair.originalSize;
+}
 
-    // Remove all items from main layout (but don't delete them)
-    while (m_iconsLayout->count() > 0) {
-        QLayoutItem *item = m_iconsLayout->takeAt(0);
-        if (QVBoxLayout *vbox = qobject_cast<QVBoxLayout*>(item->layout())) {
-            pairLayouts.append(vbox);
+qreal SvgPair::renderRatio(const IconPair &pair) const
+{
+    return pair.pixelRatio > 0 ? pair.pixelRatio : devicePixelRatioF();
+}
+
+int SvgPair::paintedSize(const IconPair &pair) const
+{
+    // A simulated ratio is shown pixel for pixel, so a 32 px icon at 1.5x
+    // takes 48 device pixels on this screen as well
+    if (pair.pixelRatio <= 0)
+        return displaySize(pair);
+    return qRound(displaySize(pair) * pair.pixelRatio / devicePixelRatioF());
+}
+
+QPixmap SvgPair::pixmap(const IconPair &pair, QIcon::Mode mode) const
+{
+    // Rendered at size * ratio device pixels, never upscaled from 1x
+    const QSize size(displaySize(pair), displaySize(pair));
+    const qreal ratio = renderRatio(pair);
+    if (pair.isSvg) {
+        if (m_tintMode != IconTint::Off) {
+            const QColor color = m_tintColor.isValid() ? m_tintColor : palette().color(QPalette::WindowText);
+            const QPixmap tinted = IconTint::pixmap(pair.backend, *m_document, size, ratio, mode, m_tintMode, color);
+            if (!tinted.isNull())
+                return tinted;
         }
-        delete item; // Delete the layout item wrapper, not the layout itself
+        return pair.icon.pixmap(size, ratio, mode); // Cached by the backend's icon engine
     }
 
-    // Clear the list (we'll rebuild from m_iconPairs)
-    pairLayouts.clear();
+    PixmapCache &cache = PixmapCache::instance();
+    const PixmapCache::Key key{m_cacheOwner, quint64(pair.pngIndex), PixmapCache::spec(size, ratio, mode)};
+    QPixmap pixmap = cache.find(key);
+    if (pixmap.isNull()) {
+        QPixmap decoded;
+        decoded.loadFromData(pair.png, "PNG");
+        pixmap = QIcon(decoded).pixmap(size, ratio, mode);
+        cache.insert(key, pixmap);
+    }
+    return pixmap;
+}
 
-    // Rebuild order: SVG first, then closest PNG, then rest
-    QList<int> displayOrder;
-    displayOrder.append(0); // SVG always first
+void SvgPair::setIconSize(int size)
+{
+    if (size == m_iconSize)
+        return;
+    m_iconSize = size;
 
-    // Find PNG closest to current SVG size
-    if (m_iconPairs.size() > 1) {
-        int closestIndex = 1;
-        int smallestDiff = qAbs(m_iconPairs[1].originalSize - m_iconSize);
-
-        for (int i = 2; i < m_iconPairs.size(); ++i) {
-            int diff = qAbs(m_iconPairs[i].originalSize - m_iconSize);
-            if (diff < smallestDiff) {
-                smallestDiff = diff;
-                closestIndex = i;
-            }
-        }
+    // SVG buttons change size, so the geometry always moves; the order only
+    // when another PNG becomes the closest one
+    updateDisplayOrder();
+    layoutPairs();
+}
 
-        // Add closest PNG second
-        displayOrder.append(closestIndex);
+void SvgPair::rebuildLayout()
+{
+    m_closestPng = -1;
+    updateDisplayOrder();
+    layoutPairs();
+}
 
-        // Add remaining PNGs
-        for (int i = 1; i < m_iconPairs.size(); ++i) {
-            if (i != closestIndex) {
-                displayOrder.append(i);
-            }
+bool SvgPair::updateDisplayOrder()
+{
+    // Find PNG closest to current SVG size
+    int closestIndex = -1;
+    int smallestDiff = 0;
+    for (int i = m_svgCount; i < m_iconPairs.size(); ++i) {
+        int diff = qAbs(m_iconPairs[i].originalSize - m_iconSize);
+        if (closestIndex < 0 || diff < smallestDiff) {
+            smallestDiff = diff;
+            closestIndex = i;
         }
     }
 
-    // Add all icon pairs in the new order
-    for (int index : displayOrder) {
-        addIconPairToLayout(index);
+    if (closestIndex == m_closestPng && m_displayOrder.size() == m_iconPairs.size())
+        return false;
+    m_closestPng = closestIndex;
+
+    // Order: SVGs first, then closest PNG, then rest
+    // Rewritten in place; resize() keeps the capacity, so no allocation after the first call
+    m_displayOrder.resize(m_iconPairs.size());
+    int position = 0;
+    for (int i = 0; i < m_svgCount; ++i)
+        m_displayOrder[position++] = i;
+    if (closestIndex >= 0)
+        m_displayOrder[position++] = closestIndex;
+    for (int i = m_svgCount; i < m_iconPairs.size(); ++i) {
+        if (i != closestIndex)
+            m_displayOrder[position++] = i;
     }
-
-    m_iconsLayout->addStretch();
+    return true;
 }
 
-void SvgPair::addIconPairToLayout(int index)
+void SvgPair::layoutPairs()
 {
-    IconPair &pair = m_iconPairs[index];
+    // Place filename, then every pair left to right:
+    //   type label / Off and On buttons / Off and On labels
+    const QFontMetrics nameMetrics(nameFont());
+    const QFontMetrics typeMetrics(typeFont());
+    const QFontMetrics stateMetrics(stateFont());
+    const int offTextWidth = stateMetrics.horizontalAdvance(tr("Off"));
+    const int onTextWidth = stateMetrics.horizontalAdvance(tr("On"));
+
+    m_filenameRect = QRect(kMargin, kMargin, nameMetrics.horizontalAdvance(m_fileName), nameMetrics.height());
+    m_duplicateRect = QRect();
+    if (!m_duplicateOf.isEmpty()) {
+        m_duplicateRect = QRect(m_filenameRect.right() + 1 + kNoteSpacing, m_filenameRect.top(),
+                                typeMetrics.horizontalAdvance(duplicateNote(m_duplicateOf)), m_filenameRect.height());
+    }
+    m_badgeRect = QRect();
+    if (!m_badge.isEmpty()) {
+        const int left = (m_duplicateRect.isNull() ? m_filenameRect : m_duplicateRect).right() + 1 + kNoteSpacing;
+        m_badgeRect = QRect(left, m_filenameRect.top(),
+                            typeMetrics.horizontalAdvance(m_badge) + 2 * kBadgePadding, m_filenameRect.height());
+    }
+    const int rowTop = m_filenameRect.bottom() + 1 + kNameSpacing;
+
+    int x = kMargin;
+    int rowHeight = 0;
+    for (int index : m_displayOrder) {
+        IconPair &pair = m_iconPairs[index];
+        const int button = paintedSize(pair) + kButtonPadding;
+        const int offWidth = qMax(button, offTextWidth);
+        const int onWidth = qMax(button, onTextWidth);
+        const int buttonsWidth = offWidth + kButtonSpacing + onWidth;
+        const int width = qMax(buttonsWidth, typeMetrics.horizontalAdvance(pair.label));
+        const int left = x + (width - buttonsWidth) / 2;
+
+        pair.typeRect = QRect(x, rowTop, width, typeMetrics.height());
+
+        const int buttonTop = pair.typeRect.bottom() + 1 + kTypeSpacing;
+        pair.offButtonRect = QRect(left + (offWidth - button) / 2, buttonTop, button, button);
+        pair.onButtonRect = QRect(left + offWidth + kButtonSpacing + (onWidth - button) / 2, buttonTop, button, button);
+
+        const int labelTop = buttonTop + button + kLabelSpacing;
+        pair.offLabelRect = QRect(left, labelTop, offWidth, stateMetrics.height());
+        pair.onLabelRect = QRect(left + offWidth + kButtonSpacing, labelTop, onWidth, stateMetrics.height());
+
+        rowHeight = qMax(rowHeight, pair.offLabelRect.bottom() + 1 - rowTop);
+        x += width + kPairSpacing;
+    }
 
-    // Create vertical layout for this icon pair
-    QVBoxLayout *pairLayout = new QVBoxLayout();
-    pairLayout->setSpacing(2);
+    // The last of filename, duplicate note and badge
+    int nameRight = m_filenameRect.right() + 1;
+    if (!m_duplicateRect.isNull())
+        nameRight = m_duplicateRect.right() + 1;
+    if (!m_badgeRect.isNull())
+        nameRight = m_badgeRect.right() + 1;
+    const int contentRight = qMax(nameRight, m_displayOrder.isEmpty() ? x : x - kPairSpacing);
+    const QSize sizeHint(contentRight + kMargin, rowTop + rowHeight + kMargin);
+    if (sizeHint != m_sizeHint) {
+        m_sizeHint = sizeHint;
+        updateGeometry();
+    }
+    update();
+}
 
-    // Type label
-    pairLayout->addWidget(pair.typeLabel);
+QSize SvgPair::sizeHint() const
+{
+    return m_sizeHint;
+}
 
-    // Horizontal layout for disabled/enabled buttons
-    QHBoxLayout *buttonsLayout = new QHBoxLayout();
-    buttonsLayout->setSpacing(5);
+QSize SvgPair::minimumSizeHint() const
+{
+    return m_sizeHint;
+}
 
-    // Disabled button and label
-    QVBoxLayout *disabledLayout = new QVBoxLayout();
-    disabledLayout->setSpacing(1);
-    disabledLayout->addWidget(pair.disabledButton, 0, Qt::AlignCenter);
-    disabledLayout->addWidget(pair.disabledLabel);
+int SvgPair::enabledButtonAt(const QPoint &pos) const
+{
+    for (int i = 0; i < m_iconPairs.size(); ++i) {
+        if (m_iconPairs[i].onButtonRect.contains(pos))
+            return i;
+    }
+    return -1;
+}
 
-    // Enabled button and label
-    QVBoxLayout *enabledLayout = new QVBoxLayout();
-    enabledLayout->setSpacing(1);
-    enabledLayout->addWidget(pair.enabledButton, 0, Qt::AlignCenter);
-    enabledLayout->addWidget(pair.enabledLabel);
+void SvgPair::reloadSvg(const QByteArray &svg)
+{
+    // Force reload by recreating the SVG icons from the in-memory bytes
+    // This is needed because Qt and the backends cache SVG rendering
+    m_document->setData(svg);
+    setBackends(m_backends);
 
-    buttonsLayout->addLayout(disabledLayout);
-    buttonsLayout->addLayout(enabledLayout);
+    qDebug() << "Reloaded SVG:" << m_document->path();
+}
 
-    pairLayout->addLayout(buttonsLayout);
+void SvgPair::setDuplicateOf(const QString &fileName)
+{
+    if (fileName == m_duplicateOf)
+        return;
+    m_duplicateOf = fileName;
+    updateToolTip();
+    layoutPairs();
+}
 
-    // Add to main icons layout
-    m_iconsLayout->addLayout(pairLayout);
+void SvgPair::setDetails(const QString &details)
+{
+    if (details == m_details)
+        return;
+    m_details = details;
+    updateToolTip();
 }
 
-void SvgPair::setTextColor(const QColor &color)
+void SvgPair::setLint(const SvgLint::Report &report)
 {
-    QString colorName = color.name();
+    const QString badge = report.badge();
+    const QString summary = report.summary();
+    const bool severe = !report.isClean() && report.severity() == SvgLint::Severe;
+    if (badge == m_badge && summary == m_lintSummary && severe == m_badgeSevere)
+        return;
+    m_badge = badge;
+    m_badgeSevere = severe;
+    m_lintSummary = summary;
+    updateToolTip();
+    layoutPairs();
+}
 
-    // Update filename label
-    m_filenameLabel->setStyleSheet(QString("font-weight: bold; font-size: 11px; color: %1;").arg(colorName));
+void SvgPair::setTint(IconTint::Mode mode, const QColor &color)
+{
+    if (mode == m_tintMode && color == m_tintColor)
+        return;
+    m_tintMode = mode;
+    m_tintColor = color;
+    // Only what is painted is composited; the masks stay cached
+    update();
+}
 
-    // Update all icon pair labels
-    for (IconPair &pair : m_iconPairs) {
-        // Type label (SVG, PNG 32x32, etc.)
-        pair.typeLabel->setStyleSheet(QString("font-size: 9px; font-weight: bold; color: %1;").arg(colorName));
+void SvgPair::updateToolTip()
+{
+    QStringList lines;
+    if (!m_duplicateOf.isEmpty())
+        lines.append(tr("Same content as %1, parsed and rendered once").arg(m_duplicateOf));
+    if (!m_lintSummary.isEmpty())
+        lines.append(m_lintSummary);
+    if (!m_details.isEmpty())
+        lines.append(m_details);
+    setToolTip(lines.join(QLatin1String("\n\n")));
+}
 
-        // Disabled label - slightly dimmed
-        QColor dimmedColor = color;
-        dimmedColor.setAlpha(150);
-        pair.disabledLabel->setStyleSheet(QString("font-size: 8px; color: %1;").arg(dimmedColor.name(QColor::HexArgb)));
+void SvgPair::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+    emit doubleClicked(m_document->path());
+}
 
-        // Enabled label - full brightness
-        pair.enabledLabel->setStyleSheet(QString("font-size: 8px; color: %1;").arg(colorName));
+void SvgPair::mousePressEvent(QMouseEvent *event)
+{
+    // The enabled button is checkable
+    const int index = event->button() == Qt::LeftButton ? enabledButtonAt(event->position().toPoint()) : -1;
+    if (index < 0) {
+        QWidget::mousePressEvent(event);
+        return;
     }
+    m_iconPairs[index].checked = !m_iconPairs[index].checked;
+    update(m_iconPairs[index].onButtonRect);
 }
 
-void SvgPair::reloadSvg()
+void SvgPair::mouseMoveEvent(QMouseEvent *event)
 {
-    // Force reload by recreating the SVG icon
-    // This is needed because Qt caches SVG rendering
-
-    QIcon newIcon;
-    if (m_customEngine) {
-        newIcon = QIcon(new SvgIconEngine(m_svgPath));
-    } else {
-        newIcon = QIcon(m_svgPath);
+    const int index = enabledButtonAt(event->position().toPoint());
+    if (index != m_hovered) {
+        if (m_hovered >= 0)
+            update(m_iconPairs[m_hovered].onButtonRect);
+        m_hovered = index;
+        if (m_hovered >= 0)
+            update(m_iconPairs[m_hovered].onButtonRect);
     }
+    QWidget::mouseMoveEvent(event);
+}
 
-    // Update the first icon pair (SVG)
-    if (!m_iconPairs.isEmpty()) {
-        IconPair &pair = m_iconPairs[0];
-        pair.disabledButton->setIcon(newIcon);
-        pair.enabledButton->setIcon(newIcon);
-
-        // Force repaint
-        pair.disabledButton->update();
-        pair.enabledButton->update();
+void SvgPair::leaveEvent(QEvent *event)
+{
+    if (m_hovered >= 0) {
+        update(m_iconPairs[m_hovered].onButtonRect);
+        m_hovered = -1;
     }
+    QWidget::leaveEvent(event);
+}
 
-    qDebug() << "Reloaded SVG:" << m_svgPath;
+void SvgPair::changeEvent(QEvent *event)
+{
+    // Moved to a screen with another scale factor
+    if (event->type() == QEvent::DevicePixelRatioChange)
+        rebuildLayout();
+    QWidget::changeEvent(event);
 }
 
-void SvgPair::mouseDoubleClickEvent(QMouseEvent *event)
+void SvgPair::paintEvent(QPaintEvent *event)
 {
-    Q_UNUSED(event);
-    emit doubleClicked(m_svgPath);
+    QPainter painter(this);
+
+    // Rounded item background and border
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(palette().color(QPalette::Mid), 1));
+    painter.setBrush(palette().color(QPalette::AlternateBase));
+    painter.drawRoundedRect(QRectF(rect()).adjusted(0.5, 0.5, -0.5, -0.5), 5, 5);
+    painter.setRenderHint(QPainter::Antialiasing, false);
+
+    const QColor textColor = palette().color(QPalette::WindowText);
+    const QColor dimmedColor = palette().color(QPalette::PlaceholderText);
+
+    painter.setPen(textColor);
+    painter.setFont(nameFont());
+    painter.drawText(m_filenameRect, Qt::AlignLeft | Qt::AlignVCenter, m_fileName);
+    if (!m_duplicateRect.isNull()) {
+        painter.setPen(dimmedColor);
+        painter.setFont(typeFont());
+        painter.drawText(m_duplicateRect, Qt::AlignLeft | Qt::AlignVCenter, duplicateNote(m_duplicateOf));
+    }
+    if (!m_badgeRect.isNull()) {
+        // Same colors on every background, like a status light
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(m_badgeSevere ? QColor(200, 50, 40) : QColor(230, 160, 30));
+        painter.drawRoundedRect(QRectF(m_badgeRect), 3, 3);
+        painter.setRenderHint(QPainter::Antialiasing, false);
+        painter.setPen(m_badgeSevere ? Qt::white : Qt::black);
+        painter.setFont(typeFont());
+        painter.drawText(m_badgeRect, Qt::AlignCenter, m_badge);
+    }
+
+    for (int i = 0; i < m_iconPairs.size(); ++i) {
+        IconPair &pair = m_iconPairs[i];
+        const QRect bounds = pair.typeRect.united(pair.offLabelRect).united(pair.onLabelRect);
+        if (!event->rect().intersects(bounds))
+            continue;
+
+        // Looked up on every paint, which keeps what is on screen in the cache
+        const QPixmap offPixmap = pixmap(pair, QIcon::Disabled);
+        const QPixmap onPixmap = pixmap(pair, QIcon::Normal);
+        const int size = paintedSize(pair);
+
+        painter.setPen(textColor);
+        painter.setFont(typeFont());
+        painter.drawText(pair.typeRect, Qt::AlignCenter, pair.label);
+
+        // Disabled button
+        drawCentered(painter, pair.offButtonRect, offPixmap, size);
+
+        // Enabled button: auto-raise panel when hovered or checked
+        if (i == m_hovered || pair.checked) {
+            QStyleOptionToolButton option;
+            option.initFrom(this);
+            option.rect = pair.onButtonRect;
+            option.state |= QStyle::State_AutoRaise | QStyle::State_Enabled;
+            if (i == m_hovered)
+                option.state |= QStyle::State_MouseOver | QStyle::State_Raised;
+            if (pair.checked)
+                option.state |= QStyle::State_On | QStyle::State_Sunken;
+            style()->drawPrimitive(QStyle::PE_PanelButtonTool, &option, &painter, this);
+        }
+        drawCentered(painter, pair.onButtonRect, onPixmap, size);
+
+        painter.setFont(stateFont());
+        painter.setPen(dimmedColor); // Slightly dimmed
+        painter.drawText(pair.offLabelRect, Qt::AlignCenter, tr("Off"));
+        painter.setPen(textColor);
+        painter.drawText(pair.onLabelRect, Qt::AlignCenter, tr("On"));
+    }
 }
@@ -1,60 +1,151 @@
 #ifndef SVGPAIR_H
 #define SVGPAIR_H
 
+#include "FolderSource.h"
+#include "IconTint.h"
+#include "RenderBackend.h"
+#include "SvgDocument.h"
+#include "SvgLint.h"
+
 #include <QWidget>
-#include <QLabel>
-#include <QVBoxLayout>
-#include <QHBoxLayout>
-#include <QToolButton>
-#include <QSvgWidget>
+#include <QIcon>
+#include <QPixmap>
+#include <QRect>
 #include <QString>
 #include <QStringList>
 
 // Displays an SVG and its corresponding PNGs (if found)
-// Each image is shown twice: disabled and enabled toolbuttons
+// Each image is shown twice: disabled and enabled toolbutton look
+// The SVG is shown once per render backend and pixel ratio, all sharing one parsed document
+// Colors come from the inherited palette (see GalleryTheme)
+//
+// Everything is painted by this one widget from PixmapCache; there are no
+// child widgets or layouts and no pixmaps held per button. Hit-testing
+// replaces the toolbuttons.
 class SvgPair : public QWidget
 {
     Q_OBJECT
 
 public:
+    // Reads the files
     explicit SvgPair(
         const QString &svgPath,
         const QStringList &pngPaths,
-        int iconSize = 32,
-        bool customEngine = true,
+        int iconSize,
+        const QList<RenderBackend*> &backends,
+        const QList<qreal> &pixelRatios,
+        QWidget *parent = nullptr);
+
+    // Renders straight from memory; the buffers are shared, not copied
+    SvgPair(
+        const SvgDocumentPtr &document,
+        const QList<FolderFile> &pngs,
+        int iconSize,
+        const QList<RenderBackend*> &backends,
+        const QList<qreal> &pixelRatios,
         QWidget *parent = nullptr);
-    
-    QString svgPath() const { return m_svgPath; }
+
+    ~SvgPair() override;
+
+    QString svgPath() const { return m_document->path(); }
+    QString fileName() const { return m_fileName; }
+    SvgDocumentPtr document() const { return m_document; }
+    QList<FolderFile> pngFiles() const; // As passed in, by file name
     void setIconSize(int size);
-    void setTextColor(const QColor &color);
-    void reloadSvg();
+    void setBackends(const QList<RenderBackend*> &backends);
+
+    // 0 renders for the screen; other values simulate that device pixel ratio
+    // by rendering size * ratio pixels and showing them unscaled
+    void setPixelRatios(const QList<qreal> &pixelRatios);
+    void reloadSvg(const QByteArray &svg);
+
+    // Marks this SVG as having the same bytes as another file; empty clears it
+    void setDuplicateOf(const QString &fileName);
+    QString duplicateOf() const { return m_duplicateOf; }
+
+    // Shown in the tooltip, below the duplicate note
+    void setDetails(const QString &details);
+
+    // Badge after the filename naming the expensive constructs, with the
+    // findings in the tooltip; a clean report removes it
+    void setLint(const SvgLint::Report &report);
+
+    // Recolors the SVG renders from cached masks; an invalid color follows
+    // the palette's text color, so the tint changes with the background
+    void setTint(IconTint::Mode mode, const QColor &color = QColor());
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
 
 signals:
     void doubleClicked(const QString &svgPath);
 
 protected:
     void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
 
 private:
     struct IconPair {
-        QToolButton *disabledButton;
-        QToolButton *enabledButton;
-        QLabel *disabledLabel;
-        QLabel *enabledLabel;
-        QLabel *typeLabel;
+        QIcon icon;
+        QString label;    // SVG, PNG 32×32, etc.
         int originalSize; // For PNGs to know their original size
+        bool isSvg;
+        qreal pixelRatio = 0; // Simulated device pixel ratio, 0 for the screen's
+        RenderBackend *backend = nullptr; // SVGs only
+        bool checked = false;
+
+        // PNGs only: the file, decoded on demand into PixmapCache
+        QString pngName;
+        QByteArray png;
+        int pngIndex = -1;
+
+        // Set by rebuildLayout()
+        QRect typeRect;
+        QRect offButtonRect;
+        QRect onButtonRect;
+        QRect offLabelRect;
+        QRect onLabelRect;
     };
 
-    void createIconPair(const QString &path, const QString &label, int size, bool isSvg);
+    static QList<FolderFile> readFiles(const QStringList &paths);
+    IconPair createIconPair(const QIcon &icon, const QString &label, int size, bool isSvg) const;
+    void createSvgIconPairs();
     void rebuildLayout();
-    void addIconPairToLayout(int index);
+    bool updateDisplayOrder();
+    void layoutPairs();
+    int displaySize(const IconPair &pair) const;
+    qreal renderRatio(const IconPair &pair) const;
+    int paintedSize(const IconPair &pair) const;
+    QPixmap pixmap(const IconPair &pair, QIcon::Mode mode) const;
+    int enabledButtonAt(const QPoint &pos) const;
+    void updateToolTip();
 
-    QString m_svgPath;
+    QString m_fileName;
+    SvgDocumentPtr m_document;
     int m_iconSize;
-    bool m_customEngine;
-    QHBoxLayout *m_iconsLayout;
-    QLabel *m_filenameLabel;
+    QList<RenderBackend*> m_backends;
+    QList<qreal> m_pixelRatios;
+    IconTint::Mode m_tintMode = IconTint::Off;
+    QColor m_tintColor;
+    int m_svgCount = 0; // The first m_svgCount icon pairs are SVGs, one per backend and pixel ratio
     QList<IconPair> m_iconPairs;
+    QList<int> m_displayOrder; // Reused; rewritten in place when the closest PNG changes
+    int m_closestPng = -1;
+    QRect m_filenameRect;
+    QString m_duplicateOf;
+    QString m_details;
+    QRect m_duplicateRect; // Note after the filename, empty if not a duplicate
+    QString m_badge;
+    bool m_badgeSevere = false;
+    QString m_lintSummary;
+    QRect m_badgeRect; // After the filename and note, empty without findings
+    QSize m_sizeHint;
+    int m_hovered = -1; // Icon pair whose enabled button is under the mouse
+    quint64 m_cacheOwner; // PNG pixmaps in PixmapCache
 };
 
 #endif // SVGPAIR_H
@@ -0,0 +1,492 @@
+#include "SvgPathParser.h"
+
+#include <QtAlgorithms>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SVGPATHPARSER_SSE2 1
+#endif
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Exact in a double, so one multiply or divide rounds correctly
+constexpr double kPowersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+template <typename Char>
+inline bool isSeparator(Char c)
+{
+    return c == ' ' || c == ',' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+template <typename Char>
+inline bool isDigit(Char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Length of the run of ASCII digits at p
+template <typename Char>
+qsizetype digitRun(const Char *p, const Char *end, bool simd)
+{
+    const Char *start = p;
+#ifdef SVGPATHPARSER_SSE2
+    if (simd) {
+        // Signed compares: bytes and units with the top bit set are negative,
+        // so they fall outside '0'..'9' like every other non-digit
+        if constexpr (sizeof(Char) == 1) {
+            const __m128i below = _mm_set1_epi8('0' - 1);
+            const __m128i above = _mm_set1_epi8('9' + 1);
+            for (; end - p >= 16; p += 16) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                const __m128i digits = _mm_and_si128(_mm_cmpgt_epi8(chars, below), _mm_cmplt_epi8(chars, above));
+                const uint stop = ~uint(_mm_movemask_epi8(digits)) & 0xffff;
+                if (stop)
+                    return (p - start) + qCountTrailingZeroBits(stop);
+            }
+        } else {
+            const __m128i below = _mm_set1_epi16('0' - 1);
+            const __m128i above = _mm_set1_epi16('9' + 1);
+            for (; end - p >= 8; p += 8) {
+                const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                const __m128i digits = _mm_and_si128(_mm_cmpgt_epi16(chars, below), _mm_cmplt_epi16(chars, above));
+                const uint stop = ~uint(_mm_movemask_epi8(digits)) & 0xffff;
+                if (stop)
+                    return (p - start) + qCountTrailingZeroBits(stop) / 2; // Two mask bits per unit
+            }
+        }
+    }
+#else
+    Q_UNUSED(simd)
+#endif
+    while (p < end && isDigit(*p))
+        ++p;
+    return p - start;
+}
+
+// Reads a number at p and moves past it; false, with p unchanged, if there
+// is none. Up to 19 significant digits are kept, which covers any
+// coordinate written out by a design tool.
+template <typename Char>
+bool readNumber(const Char *&p, const Char *end, bool simd, double *value, int *decimals)
+{
+    const Char *q = p;
+    bool negative = false;
+    if (q < end && (*q == '+' || *q == '-')) {
+        negative = *q == '-';
+        ++q;
+    }
+
+    quint64 mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    auto accumulate = [&](const Char *digits, qsizetype count, bool fraction) {
+        for (qsizetype i = 0; i < count; ++i) {
+            if (significant < 19) {
+                mantissa = mantissa * 10 + quint64(digits[i] - '0');
+                if (mantissa)
+                    ++significant;
+                if (fraction)
+                    --exponent;
+            } else if (!fraction) {
+                ++exponent;
+            }
+        }
+    };
+
+    const qsizetype integerDigits = digitRun(q, end, simd);
+    accumulate(q, integerDigits, false);
+    q += integerDigits;
+
+    qsizetype fractionDigits = 0;
+    if (q < end && *q == '.') {
+        fractionDigits = digitRun(q + 1, end, simd);
+        if (integerDigits > 0 || fractionDigits > 0) {
+            accumulate(q + 1, fractionDigits, true);
+            q += 1 + fractionDigits;
+        }
+    }
+    if (integerDigits == 0 && fractionDigits == 0)
+        return false;
+
+    int written = 0; // The exponent as written
+    if (q < end && (*q == 'e' || *q == 'E')) {
+        const Char *e = q + 1;
+        bool negativeExponent = false;
+        if (e < end && (*e == '+' || *e == '-')) {
+            negativeExponent = *e == '-';
+            ++e;
+        }
+        const qsizetype exponentDigits = digitRun(e, end, simd);
+        // Otherwise the e is not part of the number
+        if (exponentDigits > 0) {
+            for (qsizetype i = 0; i < exponentDigits && written < 10000; ++i)
+                written = written * 10 + (e[i] - '0');
+            if (negativeExponent)
+                written = -written;
+            exponent += written;
+            q = e + exponentDigits;
+        }
+    }
+
+    double result = double(mantissa);
+    if (mantissa != 0 && exponent != 0) {
+        if (exponent > 0 && exponent <= 22)
+            result *= kPowersOf10[exponent];
+        else if (exponent < 0 && exponent >= -22)
+            result /= kPowersOf10[-exponent];
+        else
+            result *= std::pow(10.0, exponent);
+    }
+    *value = negative ? -result : result;
+    *decimals = qMax(0, int(fractionDigits) - written);
+    p = q;
+    return true;
+}
+
+int argumentCount(char command)
+{
+    switch (command) {
+    case 'M': case 'm': case 'L': case 'l': case 'T': case 't':
+        return 2;
+    case 'H': case 'h': case 'V': case 'v':
+        return 1;
+    case 'C': case 'c':
+        return 6;
+    case 'S': case 's': case 'Q': case 'q':
+        return 4;
+    case 'A': case 'a':
+        return 7;
+    case 'Z': case 'z':
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+bool offGrid(double value, double origin, double scale)
+{
+    const double halfPixels = (value - origin) * scale * 2;
+    return std::abs(halfPixels - std::round(halfPixels)) > 1e-3;
+}
+
+// Parameters in (0, 1) where one coordinate of a cubic Bézier turns
+int cubicExtrema(double p0, double p1, double p2, double p3, double *t)
+{
+    // The derivative over 3: a t² + b t + c
+    const double a = -p0 + 3 * p1 - 3 * p2 + p3;
+    const double b = 2 * (p0 - 2 * p1 + p2);
+    const double c = p1 - p0;
+    double roots[2];
+    int count = 0;
+    if (std::abs(a) < 1e-12) {
+        if (std::abs(b) > 1e-12)
+            roots[count++] = -c / b;
+    } else {
+        const double discriminant = b * b - 4 * a * c;
+        if (discriminant >= 0) {
+            const double root = std::sqrt(discriminant);
+            roots[count++] = (-b + root) / (2 * a);
+            roots[count++] = (-b - root) / (2 * a);
+        }
+    }
+    int inside = 0;
+    for (int i = 0; i < count; ++i) {
+        if (roots[i] > 0 && roots[i] < 1)
+            t[inside++] = roots[i];
+    }
+    return inside;
+}
+
+double cubicAt(double p0, double p1, double p2, double p3, double t)
+{
+    const double u = 1 - t;
+    return u * u * u * p0 + 3 * u * u * t * p1 + 3 * u * t * t * p2 + t * t * t * p3;
+}
+
+} // namespace
+
+SvgPathParser::SvgPathParser()
+    : SvgPathParser(Grid())
+{
+}
+
+SvgPathParser::SvgPathParser(const Grid &grid, Mode mode)
+    : m_grid(grid)
+    , m_mode(mode)
+{
+}
+
+bool SvgPathParser::simdAvailable()
+{
+#ifdef SVGPATHPARSER_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SvgPathParser::parsePath(QStringView d)
+{
+    parse(d.utf16(), d.utf16() + d.size(), false, false);
+}
+
+void SvgPathParser::parsePath(QByteArrayView d)
+{
+    parse(d.data(), d.data() + d.size(), false, false);
+}
+
+void SvgPathParser::parsePoints(QStringView points, bool closed)
+{
+    parse(points.utf16(), points.utf16() + points.size(), true, closed);
+}
+
+void SvgPathParser::addRect(double x, double y, double width, double height)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    endpoint(x, y);
+    endpoint(x + width, y + height);
+}
+
+void SvgPathParser::addEllipse(double cx, double cy, double rx, double ry)
+{
+    if (rx <= 0 || ry <= 0)
+        return;
+    include(cx - rx, cy - ry);
+    include(cx + rx, cy + ry);
+}
+
+void SvgPathParser::addLine(double x1, double y1, double x2, double y2)
+{
+    endpoint(x1, y1);
+    endpoint(x2, y2);
+}
+
+void SvgPathParser::include(double x, double y)
+{
+    m_stats.minX = qMin(m_stats.minX, x);
+    m_stats.minY = qMin(m_stats.minY, y);
+    m_stats.maxX = qMax(m_stats.maxX, x);
+    m_stats.maxY = qMax(m_stats.maxY, y);
+}
+
+void SvgPathParser::endpoint(double x, double y)
+{
+    include(x, y);
+    ++m_stats.points;
+    if (offGrid(x, m_grid.originX, m_grid.scaleX) || offGrid(y, m_grid.originY, m_grid.scaleY))
+        ++m_stats.offGridPoints;
+}
+
+void SvgPathParser::cubic(double x0, double y0, double x1, double y1, double x2, double y2, double x3, double y3)
+{
+    double t[4];
+    int count = cubicExtrema(x0, x1, x2, x3, t);
+    count += cubicExtrema(y0, y1, y2, y3, t + count);
+    for (int i = 0; i < count; ++i)
+        include(cubicAt(x0, x1, x2, x3, t[i]), cubicAt(y0, y1, y2, y3, t[i]));
+    endpoint(x3, y3);
+}
+
+void SvgPathParser::quadratic(double x0, double y0, double x1, double y1, double x2, double y2)
+{
+    // Degree-elevated, so the cubic extrema apply
+    cubic(x0, y0, x0 + 2.0 / 3 * (x1 - x0), y0 + 2.0 / 3 * (y1 - y0),
+          x2 + 2.0 / 3 * (x1 - x2), y2 + 2.0 / 3 * (y1 - y2), x2, y2);
+}
+
+void SvgPathParser::arc(double x0, double y0, double rx, double ry, double angle, bool largeArc, bool sweep, double x, double y)
+{
+    // Endpoint to center parameterization, SVG 1.1 appendix F.6.5
+    if (x0 == x && y0 == y)
+        return;
+    rx = std::abs(rx);
+    ry = std::abs(ry);
+    if (rx == 0 || ry == 0) {
+        endpoint(x, y);
+        return;
+    }
+
+    const double phi = angle * kPi / 180;
+    const double cosPhi = std::cos(phi);
+    const double sinPhi = std::sin(phi);
+    const double dx = (x0 - x) / 2;
+    const double dy = (y0 - y) / 2;
+    const double x1 = cosPhi * dx + sinPhi * dy;
+    const double y1 = -sinPhi * dx + cosPhi * dy;
+
+    // Radii too small to reach are scaled up (F.6.6)
+    const double lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+    if (lambda > 1) {
+        rx *= std::sqrt(lambda);
+        ry *= std::sqrt(lambda);
+    }
+
+    const double numerator = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+    const double denominator = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+    double coefficient = denominator > 0 ? std::sqrt(qMax(0.0, numerator / denominator)) : 0;
+    if (largeArc == sweep)
+        coefficient = -coefficient;
+    const double cx1 = coefficient * rx * y1 / ry;
+    const double cy1 = -coefficient * ry * x1 / rx;
+    const double cx = cosPhi * cx1 - sinPhi * cy1 + (x0 + x) / 2;
+    const double cy = sinPhi * cx1 + cosPhi * cy1 + (y0 + y) / 2;
+
+    const double theta1 = std::atan2((y1 - cy1) / ry, (x1 - cx1) / rx);
+    double delta = std::atan2((-y1 - cy1) / ry, (-x1 - cx1) / rx) - theta1;
+    if (!sweep && delta > 0)
+        delta -= 2 * kPi;
+    else if (sweep && delta < 0)
+        delta += 2 * kPi;
+
+    // Where x and y of the rotated ellipse turn, if the arc passes there
+    const double thetaX = std::atan2(-ry * sinPhi, rx * cosPhi);
+    const double thetaY = std::atan2(ry * cosPhi, rx * sinPhi);
+    for (double theta : {thetaX, thetaX + kPi, thetaY, thetaY + kPi}) {
+        double along = std::fmod((delta >= 0 ? theta - theta1 : theta1 - theta), 2 * kPi);
+        if (along < 0)
+            along += 2 * kPi;
+        if (along <= std::abs(delta)) {
+            include(cx + rx * cosPhi * std::cos(theta) - ry * sinPhi * std::sin(theta),
+                    cy + rx * sinPhi * std::cos(theta) + ry * cosPhi * std::sin(theta));
+        }
+    }
+    endpoint(x, y);
+}
+
+template <typename Char>
+void SvgPathParser::parse(const Char *p, const Char *end, bool points, bool closed)
+{
+    const bool simd = m_mode == Auto;
+    char command = points ? 'M' : 0;
+    char previous = 0; // Upper case, for S and T reflection
+    double x = 0, y = 0, startX = 0, startY = 0, controlX = 0, controlY = 0;
+    double args[7];
+
+    while (true) {
+        while (p < end && isSeparator(*p))
+            ++p;
+        if (p >= end)
+            break;
+
+        if (!points && *p < 128 && argumentCount(char(*p)) >= 0) {
+            command = char(*p++);
+            if (command == 'Z' || command == 'z') {
+                // Numbers may not follow without a new command
+                ++m_stats.segments;
+                x = startX;
+                y = startY;
+                previous = 'Z';
+                command = 0;
+                continue;
+            }
+        } else if (!command) {
+            m_stats.error = true;
+            return;
+        }
+
+        const int count = argumentCount(command);
+        for (int i = 0; i < count; ++i) {
+            while (p < end && isSeparator(*p))
+                ++p;
+            // Arc flags are single digits and need no separator: "a1 1 0 00 5 5"
+            if ((command == 'A' || command == 'a') && (i == 3 || i == 4)) {
+                if (p < end && (*p == '0' || *p == '1')) {
+                    args[i] = *p++ - '0';
+                    continue;
+                }
+                m_stats.error = true;
+                return;
+            }
+            int decimals = 0;
+            if (!readNumber(p, end, simd, &args[i], &decimals)) {
+                m_stats.error = true;
+                return;
+            }
+            ++m_stats.numbers;
+            m_stats.maxDecimals = qMax(m_stats.maxDecimals, decimals);
+        }
+
+        const bool relative = command >= 'a';
+        const double ox = relative ? x : 0;
+        const double oy = relative ? y : 0;
+        const char upper = relative ? char(command - 'a' + 'A') : command;
+        switch (upper) {
+        case 'M':
+            x = startX = ox + args[0];
+            y = startY = oy + args[1];
+            endpoint(x, y);
+            // Further pairs are lines
+            command = relative ? 'l' : 'L';
+            break;
+        case 'L':
+            x = ox + args[0];
+            y = oy + args[1];
+            endpoint(x, y);
+            break;
+        case 'H':
+            x = ox + args[0];
+            endpoint(x, y);
+            break;
+        case 'V':
+            y = oy + args[0];
+            endpoint(x, y);
+            break;
+        case 'C':
+            cubic(x, y, ox + args[0], oy + args[1], ox + args[2], oy + args[3], ox + args[4], oy + args[5]);
+            controlX = ox + args[2];
+            controlY = oy + args[3];
+            x = ox + args[4];
+            y = oy + args[5];
+            break;
+        case 'S': {
+            const bool reflect = previous == 'C' || previous == 'S';
+            cubic(x, y, reflect ? 2 * x - controlX : x, reflect ? 2 * y - controlY : y,
+                  ox + args[0], oy + args[1], ox + args[2], oy + args[3]);
+            controlX = ox + args[0];
+            controlY = oy + args[1];
+            x = ox + args[2];
+            y = oy + args[3];
+            break;
+        }
+        case 'Q':
+            quadratic(x, y, ox + args[0], oy + args[1], ox + args[2], oy + args[3]);
+            controlX = ox + args[0];
+            controlY = oy + args[1];
+            x = ox + args[2];
+            y = oy + args[3];
+            break;
+        case 'T': {
+            const bool reflect = previous == 'Q' || previous == 'T';
+            controlX = reflect ? 2 * x - controlX : x;
+            controlY = reflect ? 2 * y - controlY : y;
+            quadratic(x, y, controlX, controlY, ox + args[0], oy + args[1]);
+            x = ox + args[0];
+            y = oy + args[1];
+            break;
+        }
+        case 'A':
+            arc(x, y, args[0], args[1], args[2], args[3] != 0, args[4] != 0, ox + args[5], oy + args[6]);
+            x = ox + args[5];
+            y = oy + args[6];
+            break;
+        }
+
+        if (upper != 'M')
+            ++m_stats.segments;
+        if (upper == 'C' || upper == 'S' || upper == 'Q' || upper == 'T' || upper == 'A')
+            ++m_stats.curves;
+        previous = upper;
+    }
+
+    // A polygon closes back to its first point
+    if (points && closed && previous)
+        ++m_stats.segments;
+}
@@ -0,0 +1,83 @@
+#ifndef SVGPATHPARSER_H
+#define SVGPATHPARSER_H
+
+#include <QByteArrayView>
+#include <QRectF>
+#include <QStringView>
+
+#include <limits>
+
+// Streams SVG path data (a d attribute, polyline/polygon points) into
+// geometry statistics without building a path: segment and curve counts,
+// the number precision used, tight bounds from curve extrema rather than
+// control points, and endpoints that miss the pixel grid. Nothing is
+// allocated; digit runs are found 16 bytes (8 UTF-16 units) at a time with
+// SSE2 where the target has it, and numbers are assembled without strtod.
+//
+// Coordinates are taken as written; transforms are not applied.
+class SvgPathParser
+{
+public:
+    // Maps path coordinates to device pixels for the grid check
+    struct Grid {
+        double originX = 0;
+        double originY = 0;
+        double scaleX = 1;
+        double scaleY = 1;
+    };
+
+    struct Stats {
+        quint32 segments = 0;      // Drawing commands, implicit repeats included
+        quint32 curves = 0;        // C, S, Q, T and A segments
+        quint32 numbers = 0;
+        quint32 points = 0;        // Endpoints checked against the grid
+        quint32 offGridPoints = 0; // Endpoints not on a whole or half pixel
+        int maxDecimals = 0;       // Most fraction digits in any number
+        bool error = false;        // Some data was invalid; parsing stopped there
+
+        double minX = std::numeric_limits<double>::infinity();
+        double minY = std::numeric_limits<double>::infinity();
+        double maxX = -std::numeric_limits<double>::infinity();
+        double maxY = -std::numeric_limits<double>::infinity();
+
+        bool hasBounds() const { return minX <= maxX; }
+        QRectF bounds() const { return hasBounds() ? QRectF(minX, minY, maxX - minX, maxY - minY) : QRectF(); }
+    };
+
+    enum Mode {
+        Auto,  // SIMD scanning where available
+        Scalar // Byte by byte, for comparison
+    };
+
+    SvgPathParser();
+    explicit SvgPathParser(const Grid &grid, Mode mode = Auto);
+
+    void parsePath(QStringView d);
+    void parsePath(QByteArrayView d);
+    void parsePoints(QStringView points, bool closed);
+
+    // Basic shapes: bounds and grid only
+    void addRect(double x, double y, double width, double height);
+    void addEllipse(double cx, double cy, double rx, double ry);
+    void addLine(double x1, double y1, double x2, double y2);
+
+    const Stats &stats() const { return m_stats; }
+
+    static bool simdAvailable();
+
+private:
+    template <typename Char>
+    void parse(const Char *p, const Char *end, bool points, bool closed);
+
+    void include(double x, double y);
+    void endpoint(double x, double y);
+    void cubic(double x0, double y0, double x1, double y1, double x2, double y2, double x3, double y3);
+    void quadratic(double x0, double y0, double x1, double y1, double x2, double y2);
+    void arc(double x0, double y0, double rx, double ry, double angle, bool largeArc, bool sweep, double x, double y);
+
+    Grid m_grid;
+    Mode m_mode;
+    Stats m_stats;
+};
+
+#endif // SVGPATHPARSER_H
@@ -0,0 +1,86 @@
+#include "VisualDiff.h"
+
+#include <QPainter>
+#include <QSvgRenderer>
+
+namespace VisualDiff {
+
+QImage renderSvg(const QByteArray &svg, const QSize &size)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QSvgRenderer renderer(svg);
+    if (!renderer.isValid())
+        return image;
+
+    QPainter painter(&image);
+    renderer.setAspectRatioMode(Qt::KeepAspectRatio);
+    renderer.render(&painter);
+    return image;
+}
+
+Result compare(const QImage &a, const QImage &b, int tolerance, QImage *diffImage)
+{
+    Result result;
+    if (a.size() != b.size()) {
+        // Not comparable pixel by pixel, so all of it changed; calling it
+        // unchanged would let a broken render pass
+        const QSize size = a.size().expandedTo(b.size());
+        result.totalPixels = result.changedPixels = qMax(a.width() * a.height(), b.width() * b.height());
+        result.maxDelta = 255;
+        if (diffImage) {
+            *diffImage = QImage(size, QImage::Format_ARGB32_Premultiplied);
+            diffImage->fill(qRgba(255, 0, 127, 255));
+        }
+        return result;
+    }
+
+    const QImage ia = a.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const QImage ib = b.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    result.totalPixels = ia.width() * ia.height();
+
+    if (diffImage) {
+        *diffImage = QImage(ia.size(), QImage::Format_ARGB32_Premultiplied);
+        diffImage->fill(Qt::transparent);
+    }
+
+    for (int y = 0; y < ia.height(); ++y) {
+        const QRgb *la = reinterpret_cast<const QRgb *>(ia.constScanLine(y));
+        const QRgb *lb = reinterpret_cast<const QRgb *>(ib.constScanLine(y));
+        QRgb *ld = diffImage ? reinterpret_cast<QRgb *>(diffImage->scanLine(y)) : nullptr;
+
+        for (int x = 0; x < ia.width(); ++x) {
+            if (la[x] == lb[x])
+                continue;
+
+            const int delta = qMax(qMax(qAbs(qRed(la[x]) - qRed(lb[x])),
+                                        qAbs(qGreen(la[x]) - qGreen(lb[x]))),
+                                   qMax(qAbs(qBlue(la[x]) - qBlue(lb[x])),
+                                        qAbs(qAlpha(la[x]) - qAlpha(lb[x]))));
+            result.maxDelta = qMax(result.maxDelta, delta);
+            if (delta > tolerance) {
+                ++result.changedPixels;
+                if (ld)
+                    ld[x] = qRgba(delta, 0, delta / 2, 255);
+            }
+        }
+    }
+    return result;
+}
+
+Result compareSvgs(const QByteArray &a, const QByteArray &b, const QList<int> &sizes, int tolerance)
+{
+    Result total;
+    for (int size : sizes) {
+        const Result r = compare(renderSvg(a, QSize(size, size)),
+                                 renderSvg(b, QSize(size, size)),
+                                 tolerance);
+        total.changedPixels += r.changedPixels;
+        total.totalPixels += r.totalPixels;
+        total.maxDelta = qMax(total.maxDelta, r.maxDelta);
+    }
+    return total;
+}
+
+} // namespace VisualDiff
@@ -0,0 +1,35 @@
+#ifndef VISUALDIFF_H
+#define VISUALDIFF_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QSize>
+
+// Pixel comparison of two renders
+namespace VisualDiff {
+
+struct Result {
+    int changedPixels = 0; // Pixels where any channel differs by more than the tolerance
+    int totalPixels = 0;
+    int maxDelta = 0;      // Largest per-channel difference (0-255)
+
+    bool identical() const { return changedPixels == 0; }
+    double score() const { return totalPixels ? double(changedPixels) / totalPixels : 0.0; }
+};
+
+// Renders SVG data into a transparent ARGB32 premultiplied image
+QImage renderSvg(const QByteArray &svg, const QSize &size);
+
+// Compares two images of the same size. If diffImage is given, it receives
+// a visualization of the changed pixels. Images of different sizes count
+// as entirely changed.
+Result compare(const QImage &a, const QImage &b, int tolerance = 2, QImage *diffImage = nullptr);
+
+// Renders both SVGs at each size and accumulates the differences
+Result compareSvgs(const QByteArray &a, const QByteArray &b,
+                   const QList<int> &sizes = {16, 32, 64}, int tolerance = 2);
+
+} // namespace VisualDiff
+
+#endif // VISUALDIFF_H
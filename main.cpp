@@ -1,11 +1,175 @@
+#include "Benchmark.h"
+#include "PixmapCache.h"
+#include "PngBuild.h"
 #include "SvgGallery.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+// --build-pngs: the gallery's Build PNGs without the gallery
+static int buildPngs(const QString &directory, const QString &sizes, bool optimize, bool force)
+{
+    QTextStream out(stdout);
+    PngBuild::Options options;
+    options.sizes = PngBuild::parseSizes(sizes);
+    options.optimize = optimize;
+    options.force = force;
+    if (options.sizes.isEmpty()) {
+        out << "No valid icon size in: " << sizes << Qt::endl;
+        return 1;
+    }
+
+    const auto folder = QSharedPointer<LocalFolderSource>::create(directory);
+    QElapsedTimer timer;
+    timer.start();
+    const PngBuild::Result result = PngBuild(folder, folder, options).run();
+    out << directory << ": " << result.summary() << " in " << timer.elapsed() << " ms" << Qt::endl;
+    if (!result.error.isEmpty())
+        out << result.error << Qt::endl;
+    return result.ok && result.failed == 0 ? 0 : 1;
+}
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
     QApplication::setStyle("Fusion");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Shows how Qt renders the SVGs in a folder.");
+    parser.addHelpOption();
+    QCommandLineOption benchmarkDisplayList("benchmark-displaylist",
+        "Compare SvgIconEngine against compiled display lists for the SVGs in <dir>.", "dir");
+    QCommandLineOption benchmarkTheme("benchmark-theme",
+        "Time background preset switching with 1k and 10k gallery items.");
+    QCommandLineOption benchmarkResize("benchmark-resize",
+        "Check that memory stays constant across 1,000 icon size changes for the SVGs in <dir>.", "dir");
+    QCommandLineOption benchmarkDpr("benchmark-dpr",
+        "Time rendering the SVGs in <dir> at 1.0, 1.25, 1.5 and 2.0 device pixel ratios.", "dir");
+    QCommandLineOption benchmarkLoader("benchmark-loader",
+        "Compare sequential and batched asynchronous loading of <dir> over simulated slow storage.", "dir");
+    QCommandLineOption benchmarkSheet("benchmark-sheet",
+        "Export <count> generated icons as a streamed PNG contact sheet and report time and memory.", "count");
+    QCommandLineOption benchmarkSession("benchmark-session",
+        "Save <count> generated icons as a session snapshot and time restoring a gallery from it.", "count");
+    QCommandLineOption benchmarkMetadata("benchmark-metadata",
+        "Extract metadata from <count> generated icons and time sorting and grouping them.", "count");
+    QCommandLineOption benchmarkPaths("benchmark-paths",
+        "Time the path data parser on the SVGs in <dir> against QSvgRenderer, in MB/s.", "dir");
+    QCommandLineOption benchmarkLint("benchmark-lint",
+        "Lint the SVGs in <dir> for expensive constructs, sequentially and in parallel.", "dir");
+    QCommandLineOption benchmarkTint("benchmark-tint",
+        "Tint <count> generated currentColor icons from cached masks and time switching colors.", "count");
+    QCommandLineOption benchmarkBuild("benchmark-build",
+        "Build PNGs for <count> generated icons, then rebuild after changing one.", "count");
+    QCommandLineOption benchmarkCompare("benchmark-compare",
+        "Compare two folders of <count> generated icons that differ by a few edits, an addition, a removal and a rename.", "count");
+    QCommandLineOption benchmarkInspector("benchmark-inspector",
+        "Zoom the inspector from 1x to 64x into a generated illustration of <count> paths, rendering only visible tiles.", "count");
+    QCommandLineOption buildPngsOption("build-pngs",
+        "Render the SVGs in <dir> to name_<size>.png; only SVGs changed since the last build are rendered.", "dir");
+    QCommandLineOption pngSizes("png-sizes",
+        "Sizes for --build-pngs (default 16,24,32,48).", "list", "16,24,32,48");
+    QCommandLineOption optimizePngs("optimize-pngs",
+        "Optimize built PNGs losslessly: smaller files, slower encoding.");
+    QCommandLineOption rebuild("rebuild",
+        "Build every PNG again, whatever the build manifest says.");
+    QCommandLineOption noSession("no-session",
+        "Start empty; the session is neither restored nor saved.");
+    QCommandLineOption selftestMirror("selftest-mirror",
+        "Check the incremental mirror sync against a simulated remote folder.");
+    QCommandLineOption simulateLatency("simulate-latency",
+        "Simulate slow storage (like SAF) with <ms> latency per file, in the gallery and --benchmark-loader.",
+        "ms");
+    QCommandLineOption pixmapBudget("pixmap-budget",
+        "Memory for rendered and decoded pixmaps, in MiB (default 64).", "mib");
+    QCommandLineOption iconSize("size", "Icon size in pixels for benchmarks (default 32).", "px", "32");
+    parser.addOption(benchmarkDisplayList);
+    parser.addOption(benchmarkTheme);
+    parser.addOption(benchmarkResize);
+    parser.addOption(benchmarkDpr);
+    parser.addOption(benchmarkLoader);
+    parser.addOption(benchmarkSheet);
+    parser.addOption(benchmarkSession);
+    parser.addOption(benchmarkMetadata);
+    parser.addOption(benchmarkPaths);
+    parser.addOption(benchmarkLint);
+    parser.addOption(benchmarkTint);
+    parser.addOption(benchmarkBuild);
+    parser.addOption(benchmarkCompare);
+    parser.addOption(benchmarkInspector);
+    parser.addOption(buildPngsOption);
+    parser.addOption(pngSizes);
+    parser.addOption(optimizePngs);
+    parser.addOption(rebuild);
+    parser.addOption(noSession);
+    parser.addOption(selftestMirror);
+    parser.addOption(simulateLatency);
+    parser.addOption(pixmapBudget);
+    parser.addOption(iconSize);
+    parser.process(a);
+
+    // Applies to the gallery and to the benchmarks that paint items
+    if (parser.isSet(pixmapBudget))
+        PixmapCache::instance().setBudget(parser.value(pixmapBudget).toLongLong() * 1024 * 1024);
+
+    if (parser.isSet(benchmarkDisplayList))
+        return Benchmark::displayList(parser.value(benchmarkDisplayList), parser.value(iconSize).toInt());
+
+    if (parser.isSet(benchmarkTheme))
+        return Benchmark::themeSwitch();
+
+    if (parser.isSet(benchmarkResize))
+        return Benchmark::resizeMemory(parser.value(benchmarkResize));
+
+    if (parser.isSet(benchmarkDpr))
+        return Benchmark::pixelRatios(parser.value(benchmarkDpr), parser.value(iconSize).toInt());
+
+    if (parser.isSet(benchmarkSheet))
+        return Benchmark::contactSheet(parser.value(benchmarkSheet).toInt(), parser.value(iconSize).toInt());
+
+    if (parser.isSet(benchmarkSession))
+        return Benchmark::sessionRestore(parser.value(benchmarkSession).toInt(), parser.value(iconSize).toInt());
+
+    if (parser.isSet(benchmarkMetadata))
+        return Benchmark::metadata(parser.value(benchmarkMetadata).toInt());
+
+    if (parser.isSet(benchmarkPaths))
+        return Benchmark::pathParser(parser.value(benchmarkPaths));
+
+    if (parser.isSet(benchmarkLint))
+        return Benchmark::lint(parser.value(benchmarkLint));
+
+    if (parser.isSet(benchmarkTint))
+        return Benchmark::tint(parser.value(benchmarkTint).toInt(), parser.value(iconSize).toInt());
+
+    if (parser.isSet(benchmarkBuild))
+        return Benchmark::pngBuild(parser.value(benchmarkBuild).toInt(), parser.isSet(optimizePngs));
+
+    if (parser.isSet(benchmarkCompare))
+        return Benchmark::folderCompare(parser.value(benchmarkCompare).toInt(), parser.value(iconSize).toInt());
+
+    if (parser.isSet(benchmarkInspector))
+        return Benchmark::inspector(parser.value(benchmarkInspector).toInt());
+
+    if (parser.isSet(buildPngsOption)) {
+        return buildPngs(parser.value(buildPngsOption), parser.value(pngSizes),
+                         parser.isSet(optimizePngs), parser.isSet(rebuild));
+    }
+
+    if (parser.isSet(selftestMirror))
+        return Benchmark::mirrorSync(parser.isSet(simulateLatency) ? parser.value(simulateLatency).toInt() : 2);
+
+    if (parser.isSet(benchmarkLoader)) {
+        const int latency = parser.isSet(simulateLatency) ? parser.value(simulateLatency).toInt() : 15;
+        return Benchmark::loader(parser.value(benchmarkLoader), latency, parser.value(iconSize).toInt());
+    }
+
     SvgGallery gallery;
+    if (parser.isSet(simulateLatency))
+        gallery.setSimulatedLatency(parser.value(simulateLatency).toInt());
+    if (!parser.isSet(noSession))
+        gallery.restoreSession();
     gallery.show();
     
     return a.exec();